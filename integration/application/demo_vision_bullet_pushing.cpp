@@ -31,7 +31,7 @@ std::ostream& operator<<(std::ostream &out, const btQuaternion &x) {
 	return out << x.getX() << ", " << x.getY() << ", " << x.getZ() << ", " << x.getW();
 }
 
-void simulate_physics(const vector<PolygonObject*> &polygons) {
+void simulate_physics(const vector<PolygonObject> &polygons) {
 	static float base_size = vision_gui.getTangramBaseLength() * SCALING;
 	static vector<btRigidBody*> bodyList;
 	static btVector3 pusher_size(base_size/5, base_size, base_size/5);
@@ -45,14 +45,13 @@ void simulate_physics(const vector<PolygonObject*> &polygons) {
   btTransform trans;
 	
 	for (unsigned int i=0; i<polygons.size(); i++) {
-		PolygonObject po = *polygons[i];
-		btRigidBody *b = adapter.to_bullet(po);
+		btRigidBody *b = adapter.to_bullet(polygons[i]);
 		bodyList.push_back(b);
 	}
 
 	bodyList[0]->getMotionState()->getWorldTransform(trans);
 	cout << endl << "== Before ======" << endl;
-	cout << "Polygon[0] vision transform: " << polygons[0]->getTransformation() << endl;
+	cout << "Polygon[0] vision transform: " << polygons[0].getTransformation() << endl;
 	cout << "Polygon[0] physics transform: (Origin: " << trans.getOrigin()
 			 << " Rotation: " << trans.getRotation() << ")" << endl;
 	cout << "simulating...";
@@ -69,7 +68,7 @@ void simulate_physics(const vector<PolygonObject*> &polygons) {
 	// write the results to the polygon objects
 	for (unsigned int i=0; i<polygons.size(); i++) {
 		bodyList[i]->getMotionState()->getWorldTransform(trans);
-		polygons[i]->setPredictedTransformation(adapter.to_vision(trans));
+		vision_gui.setPredictedTransformation(polygons[i].getId(), adapter.to_vision(trans));
 	}
 	
 	for (unsigned int i=0; i<bodyList.size(); i++) delete bodyList[i];
@@ -77,10 +76,9 @@ void simulate_physics(const vector<PolygonObject*> &polygons) {
 }
 
 void vision_loop() {
-	vision_gui.vision_loop();
-	vector<PolygonObject*> actives = vision_gui.getActivePolygons();
+	if (vision_gui.waitForFrame() == -1) return;
+	vector<PolygonObject> actives = vision_gui.getActivePolygons();
 	simulate_physics(actives);	
-  Thread::msleep(50);
 }
 
 void show_physics_gui() {
@@ -111,6 +109,7 @@ void init() {
 		PlaneEquation z_plane(Vec(0,0,vision_gui.getTangramHeight()),Vec(0,0,1));
 	  vision_gui.setCameraTransformer(CameraTransformer(cam, z_plane));
 	}
+	vision_gui.startPipeline();
 }
 
 int main(int n, char **args) {
@@ -123,6 +122,8 @@ int main(int n, char **args) {
 	ExecThread y(show_physics_gui);
 	y.run(false); // no loop
 	
-	return app.exec();
+	int result = app.exec();
+	vision_gui.stopPipeline();
+	return result;
 }
 
@@ -12,11 +12,6 @@
 TangramRobotGui gui;
 PushingSimulatorGui psimgui;
 
-void vision_loop() {
-	gui.vision_loop();
-  Thread::msleep(100);
-}
-
 void show_physics_gui() {
 	glutmain(0, NULL, 640, 480, "Minimal Visualization Example", &psimgui);
 //	glutinit(0, NULL, 640, 480, "Minimal Visualization Example", &psim);
@@ -46,6 +41,7 @@ void init() {
 	}
 	gui.connectToArm(pa("-mem-srv"),
 									 pa("-robot-id"));
+	gui.startPipeline();
 }
 
 int main(int n, char **args) {
@@ -55,11 +51,13 @@ int main(int n, char **args) {
 	paex("-cam-cfg","camera configuration file for screen to world transformation");
 	paex("-tangram-cfg","xml file describing the polygon classes for classifying");
 	paex("-robot-id","id of the robot to use, default: LeftArm");
-  ICLApplication app(n, args, "-input|-i(2) -size|-s(1) -mem-srv(name=xcf:wb) -cam-cfg(1) -tangram-cfg(1) -robot-id(id=LeftArm)", init, vision_loop);
+  ICLApplication app(n, args, "-input|-i(2) -size|-s(1) -mem-srv(name=xcf:wb) -cam-cfg(1) -tangram-cfg(1) -robot-id(id=LeftArm)", init);
   
   ExecThread y(show_physics_gui);
 	y.run(false); // no loop
 	
-  return app.exec();
+  int result = app.exec();
+  gui.stopPipeline();
+  return result;
 }
 
@@ -49,10 +49,10 @@ TangramGui vision_gui;
 PhysicsVisualizer physics_gui;
 VisionAdapter adapter(SCALING);
 
-void set_physics_scene(const vector<PolygonObject*> &polygons) {
+void set_physics_scene(const vector<PolygonObject> &polygons) {
 	static vector<btRigidBody*> bodyList;
 	for (unsigned int i=0; i<polygons.size(); i++) {
-		PolygonObject po = *polygons[i];
+		PolygonObject po = polygons[i];
 		po.addTransformation(Transformation(0,-160,-120));
 		btRigidBody *b = adapter.to_bullet(po);
 		bodyList.push_back(b);
@@ -62,9 +62,8 @@ void set_physics_scene(const vector<PolygonObject*> &polygons) {
 }
 
 void vision_loop() {
-	vision_gui.vision_loop();
+	if (vision_gui.waitForFrame() == -1) return;
 	set_physics_scene(vision_gui.getActivePolygons());	
-  Thread::msleep(50);
 }
 
 void show_physics_gui() {
@@ -91,6 +90,7 @@ void init() {
 		PlaneEquation z_plane(Vec(0,0,vision_gui.getTangramHeight()),Vec(0,0,1));
 	  vision_gui.setCameraTransformer(CameraTransformer(cam, z_plane));
 	}
+	vision_gui.startPipeline();
 }
 
 int main(int n, char **args) {
@@ -103,6 +103,8 @@ int main(int n, char **args) {
 	ExecThread y(show_physics_gui);
 	y.run(false); // no loop
 	
-	return app.exec();
+	int result = app.exec();
+	vision_gui.stopPipeline();
+	return result;
 }
 
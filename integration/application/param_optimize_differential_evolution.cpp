@@ -6,6 +6,7 @@
 #include <Shapes.h>
 #include <DESolver.h>
 #include <PushingRecorder.h>
+#include <SceneBatch.h>
 
 #include <ICLUtils/StringUtils.h>
 #include <vector>
@@ -31,54 +32,39 @@ PushingRecorder prec(&psim);
 
 using namespace std;
 
-/// Returns number of loaded entries
-int loadTrainData(const string &filename, vector<PushingSceneInfo> &data, Shapes::ShapeType shapeType) {
-  ifstream f(filename.c_str());
-  string line;
-  getline(f, line); // first line has column names
-	int counter = 0;
-  while (f.good()) {
-    getline(f, line);
-    vector<float> v = icl::parseVecStr<float>(line, " ");
-    if (v.size() != 10) continue;
-    if (abs(v[0]-v[3]) < 0.5) continue; // pushing against center of object -> too chaotic
-    if (abs(v[0]-v[3]) > 2.5 && abs(v[0]-v[3]) < 3.5) continue;
-    if (abs(v[0]-v[3]) > 7.5 && abs(v[0]-v[3]) < 8.5) continue;
-    // file data columns: tx0 ty0 trot0 ax0 ay0 ax1 ay1 tx1 ty1 trot1
-    PushingSceneInfo si;
-    si.setTangramPos(v[0]/100,v[1]/100,v[2]/180*M_PI,v[7]/100,v[8]/100,v[9]/180*M_PI);
-    si.setPusherPos(v[3]/100,v[4]/100,v[5]/100,v[6]/100);
-		si.tmass = TANGRAM_MASS;
-		si.tlength = TANGRAM_LENGTH;
-		si.theight = TANGRAM_HEIGHT;
-		si.pspeed = PUSHER_SPEED;
-		si.pdiam = PUSHER_DIAMETER;
-		si.tcorners = Shapes::getCorners(shapeType, TANGRAM_LENGTH);
-		si.ttype = shapeType;
-		data.push_back(si);
-		counter++;
-  }
-  f.close();
-  return counter;
+/// Returns true for pushes too close to the center and for the test data offsets (3 and 8 cm)
+bool skipTrial(float offset_in_cm) {
+  if (offset_in_cm < 0.5) return true; // pushing against center of object -> too chaotic
+  if (offset_in_cm > 2.5 && offset_in_cm < 3.5) return true;
+  if (offset_in_cm > 7.5 && offset_in_cm < 8.5) return true;
+  return false;
+}
+
+bool useTrial(const SceneBatch &batch, int i) {
+  return !skipTrial(100*batch.getPushOffset(i));
+}
+
+/// Values for the scene properties that are not part of the data files
+PushingSceneInfo getDefaults() {
+  PushingSceneInfo defaults;
+  defaults.tmass = TANGRAM_MASS;
+  defaults.tlength = TANGRAM_LENGTH;
+  defaults.theight = TANGRAM_HEIGHT;
+  defaults.pspeed = PUSHER_SPEED;
+  defaults.pdiam = PUSHER_DIAMETER;
+  defaults.ttype = Shapes::UNKNOWN;
+  return defaults;
 }
 
 /// Returns mean corner distance to target in mm
-float calculateError( PhysicsParameters &params,
-		vector<PushingSceneInfo> &sceneInfos, float pusher_diam=-1) {
+float calculateError(PhysicsParameters &params, const SceneView &scenes) {
 	float error = 0;
-	int n = sceneInfos.size();
+	int n = scenes.size();
 	static PushingScene scene;
   static SimulationSettings simsets(1); // 1 repetition
 	for (int i=0; i<n; i++) {
-		PushingSceneInfo &sceneInfo = sceneInfos[i];
-		float real_dx = (sceneInfo.tx1-sceneInfo.tx0);
-		float real_dy = (sceneInfo.ty1-sceneInfo.ty0);
-		float real_drot = (sceneInfo.trot1-sceneInfo.trot0);
-		float old_diam = sceneInfo.pdiam;
-		if (pusher_diam != -1) sceneInfo.pdiam = pusher_diam;
-		prec.simulateSingleParameterSetting(scene, simsets, params, sceneInfo);
-		if (pusher_diam != -1) sceneInfo.pdiam = old_diam;
-		scene.calcStatistics(Transformation(real_drot, real_dx, real_dy));
+		prec.simulateSingleParameterSetting(scene, simsets, params, scenes, i);
+		scene.calcStatistics(scenes.getDelta(i));
 
 		float dist = scene.pbodies[0].getDistanceToReference();
 		error += dist;
@@ -88,28 +74,21 @@ float calculateError( PhysicsParameters &params,
 
 /// Returns mean corner distance to target in mm
 float calculateError( PhysicsParameters &params,
-		vector<PushingSceneInfo> &sceneInfos, double sf_sq, double sf_pa, double sf_st, double sf_lt, float pusher_diam=-1) {
+		const SceneView &scenes, double sf_sq, double sf_pa, double sf_st, double sf_lt) {
 	float error = 0;
-	int n = sceneInfos.size();
+	int n = scenes.size();
 	static PushingScene scene;
   static SimulationSettings simsets(1); // 1 repetition
 	for (int i=0; i<n; i++) {
-		PushingSceneInfo &sceneInfo = sceneInfos[i];
-		switch (sceneInfo.ttype) {
+		switch (scenes.getType(i)) {
 			case Shapes::SQUARE: params["fixed_shape_factor"] = sf_sq; break;
 			case Shapes::PARALLELOGRAM: params["fixed_shape_factor"] = sf_pa; break;
 			case Shapes::SMALL_TRIANGLE: params["fixed_shape_factor"] = sf_st; break;
 			case Shapes::LARGE_TRIANGLE: params["fixed_shape_factor"] = sf_lt; break;
 			default: break;
 		}
-		float real_dx = (sceneInfo.tx1-sceneInfo.tx0);
-		float real_dy = (sceneInfo.ty1-sceneInfo.ty0);
-		float real_drot = (sceneInfo.trot1-sceneInfo.trot0);
-		float old_diam = sceneInfo.pdiam;
-		if (pusher_diam != -1) sceneInfo.pdiam = pusher_diam;
-		prec.simulateSingleParameterSetting(scene, simsets, params, sceneInfo);
-		if (pusher_diam != -1) sceneInfo.pdiam = old_diam;
-		scene.calcStatistics(Transformation(real_drot, real_dx, real_dy));
+		prec.simulateSingleParameterSetting(scene, simsets, params, scenes, i);
+		scene.calcStatistics(scenes.getDelta(i));
 
 		float dist = scene.pbodies[0].getDistanceToReference();
 		error += dist;
@@ -127,7 +106,7 @@ float calculateError( PhysicsParameters &params,
 class ParamOptimizer : public DESolver
 {
 public:
-	ParamOptimizer(int dim, int pop, const vector<PushingSceneInfo> &target_data) :
+	ParamOptimizer(int dim, int pop, const SceneView &target_data) :
 		DESolver(dim,pop), count(0), dim(dim), target_data(target_data) {;}
 	double EnergyFunction(double trial[],bool &bAtSolution);
 	
@@ -137,7 +116,7 @@ public:
 private:
 	int count;
 	int dim;
-	vector<PushingSceneInfo> target_data;
+	SceneView target_data;
 };
 
 double ParamOptimizer::EnergyFunction(double *trial,bool &bAtSolution)
@@ -197,7 +176,7 @@ double ParamOptimizer::f1(double *trial,bool &bAtSolution) {
 	return(result);
 }
 
-void optimizeParams(const vector<PushingSceneInfo> &data, bool optimize_shape_factors) {
+void optimizeParams(const SceneView &data, bool optimize_shape_factors) {
 	psim.init();
 	#if VISUALIZE
 		psim.setFastForward(2);
@@ -246,6 +225,8 @@ int main(int argc, char **argv) {
   if (argc != 2) {
     cout << "usage: " << argv[0] << " <shape-type>" << endl;
     cout << "  shape-types: all, sq, pa, st, mt, lt." << endl;
+    cout << "  Instead of a shape type a file with pushing actions recorded in the" << endl;
+    cout << "  TangramRobotGui can be passed (e.g. ./data/pushing_actions.dat)." << endl;
     return -1;
   }
   string name(argv[1]);
@@ -255,6 +236,10 @@ int main(int argc, char **argv) {
   vector<Shapes::ShapeType> shape_types;
 
 	string filename = "push_data.txt";
+  if (name.size() > 4 && name.substr(name.size()-4) == ".dat") {
+  	data_files.push_back(name);
+  	shape_types.push_back(Shapes::UNKNOWN);
+  }
   if (name == "all" || name == "sq") {
   	data_files.push_back(string("./data/pushing_real_closed_loop/square/")+filename);
   	shape_types.push_back(Shapes::SQUARE);
@@ -276,13 +261,14 @@ int main(int argc, char **argv) {
   	shape_types.push_back(Shapes::SMALL_TRIANGLE);
   }
   
-	vector<PushingSceneInfo> data;
+	SceneBatch batch;
 	for (unsigned int i=0; i<data_files.size(); ++i) {
 		// read real pushing results from file
   	cout << "loading data from file " << data_files[i] << "...";
-  	int count = loadTrainData(data_files[i], data, shape_types[i]);
+  	int count = batch.load(data_files[i], shape_types[i], getDefaults());
   	cout << "OK (" << count << ") trials loaded" << endl;
 	}
+	SceneView data = SceneView(batch).select(useTrial);
 	cout << "in total, " << data.size() << " trials were loaded." << endl;
   if (data.size() < 2) {
     cout << "Number of trials too small, exiting..." << endl;
@@ -6,6 +6,7 @@
 #include <Shapes.h>
 #include <DESolver.h>
 #include <PushingRecorder.h>
+#include <SceneBatch.h>
 #include "gsl/gsl_multimin.h"
 
 #include <ICLUtils/StringUtils.h>
@@ -34,64 +35,33 @@ PushingSimulatorFast psim;
 PushingRecorder prec(&psim);
 
 struct ParamStruct {
-	vector<PushingSceneInfo> sceneInfos;
+	SceneView scenes;
 	
-	ParamStruct(vector<PushingSceneInfo> sceneInfos):
-		sceneInfos(sceneInfos) {}
+	ParamStruct(const SceneView &scenes):
+		scenes(scenes) {}
 };
 
-/// Returns number of loaded entries
-int loadData(const string &filename, vector<PushingSceneInfo> &data, Shapes::ShapeType shapeType, vector<float> data_selector) {
-  ifstream f(filename.c_str());
-  string line;
-  getline(f, line); // first line has column names
-	int counter = 0;
-  while (f.good()) {
-    getline(f, line);
-    vector<float> v = icl::parseVecStr<float>(line, " ");
-    if (v.size() != 10) continue;
-    bool use_this = false;
-    for (unsigned int i=0; i<data_selector.size(); i++) {
-    	if (data_selector[i]-0.5 < abs(v[0]-v[3]) && data_selector[i]+0.5 > abs(v[0]-v[3])) {
-    		use_this = true; break;
-    	}
-    }
-    if (!use_this) continue;
-    // file data columns: tx0 ty0 trot0 ax0 ay0 ax1 ay1 tx1 ty1 trot1
-    PushingSceneInfo si;
-    si.setTangramPos(v[0]/100,v[1]/100,v[2]/180*M_PI,v[7]/100,v[8]/100,v[9]/180*M_PI);
-    si.setPusherPos(v[3]/100,v[4]/100,v[5]/100,v[6]/100);
-		si.tmass = TANGRAM_MASS;
-		si.tlength = TANGRAM_LENGTH;
-		si.theight = TANGRAM_HEIGHT;
-		si.pspeed = PUSHER_SPEED;
-		si.pdiam = PUSHER_DIAMETER;
-		si.tcorners = Shapes::getCorners(shapeType, TANGRAM_LENGTH);
-		si.ttype = shapeType;
-		data.push_back(si);
-		counter++;
-  }
-  f.close();
-  return counter;
+/// Values for the scene properties that are not part of the data files
+PushingSceneInfo getDefaults() {
+  PushingSceneInfo defaults;
+  defaults.tmass = TANGRAM_MASS;
+  defaults.tlength = TANGRAM_LENGTH;
+  defaults.theight = TANGRAM_HEIGHT;
+  defaults.pspeed = PUSHER_SPEED;
+  defaults.pdiam = PUSHER_DIAMETER;
+  defaults.ttype = Shapes::UNKNOWN;
+  return defaults;
 }
 
 /// Returns mean corner distance to target in mm
-float calculateError(PhysicsParameters &params,
-		vector<PushingSceneInfo> &sceneInfos, float pusher_diam=-1) {
+float calculateError(PhysicsParameters &params, const SceneView &scenes) {
 	float error = 0;
-	int n = sceneInfos.size();
+	int n = scenes.size();
 	static PushingScene scene;
   static SimulationSettings simsets(1); // 1 repetition
 	for (int i=0; i<n; i++) {
-		PushingSceneInfo &sceneInfo = sceneInfos[i];
-		float real_dx = (sceneInfo.tx1-sceneInfo.tx0);
-		float real_dy = (sceneInfo.ty1-sceneInfo.ty0);
-		float real_drot = (sceneInfo.trot1-sceneInfo.trot0);
-		float old_diam = sceneInfo.pdiam;
-		if (pusher_diam != -1) sceneInfo.pdiam = pusher_diam;
-		prec.simulateSingleParameterSetting(scene, simsets, params, sceneInfo);
-		if (pusher_diam != -1) sceneInfo.pdiam = old_diam;
-		scene.calcStatistics(Transformation(real_drot, real_dx, real_dy));
+		prec.simulateSingleParameterSetting(scene, simsets, params, scenes, i);
+		scene.calcStatistics(scenes.getDelta(i));
 
 		float dist = scene.pbodies[0].getDistanceToReference();
 		error += dist;
@@ -101,28 +71,21 @@ float calculateError(PhysicsParameters &params,
 
 /// Returns mean corner distance to target in mm
 float calculateError( PhysicsParameters &params,
-		vector<PushingSceneInfo> &sceneInfos, double sf_sq, double sf_pa, double sf_st, double sf_lt, float pusher_diam=-1) {
+		const SceneView &scenes, double sf_sq, double sf_pa, double sf_st, double sf_lt) {
 	float error = 0;
-	int n = sceneInfos.size();
+	int n = scenes.size();
 	static PushingScene scene;
   static SimulationSettings simsets(5); // 5 repetition
 	for (int i=0; i<n; i++) {
-		PushingSceneInfo &sceneInfo = sceneInfos[i];
-		switch (sceneInfo.ttype) {
+		switch (scenes.getType(i)) {
 			case Shapes::SQUARE: params["fixed_shape_factor"] = sf_sq; break;
 			case Shapes::PARALLELOGRAM: params["fixed_shape_factor"] = sf_pa; break;
 			case Shapes::SMALL_TRIANGLE: params["fixed_shape_factor"] = sf_st; break;
 			case Shapes::LARGE_TRIANGLE: params["fixed_shape_factor"] = sf_lt; break;
 			default: break;
 		}
-		float real_dx = (sceneInfo.tx1-sceneInfo.tx0);
-		float real_dy = (sceneInfo.ty1-sceneInfo.ty0);
-		float real_drot = (sceneInfo.trot1-sceneInfo.trot0);
-		float old_diam = sceneInfo.pdiam;
-		if (pusher_diam != -1) sceneInfo.pdiam = pusher_diam;
-		prec.simulateSingleParameterSetting(scene, simsets, params, sceneInfo);
-		if (pusher_diam != -1) sceneInfo.pdiam = old_diam;
-		scene.calcStatistics(Transformation(real_drot, real_dx, real_dy));
+		prec.simulateSingleParameterSetting(scene, simsets, params, scenes, i);
+		scene.calcStatistics(scenes.getDelta(i));
 
 		float dist = scene.pbodies[0].getDistanceToReference();
 		error += dist;
@@ -150,7 +113,7 @@ double EnergyFunction(const gsl_vector *v, void *paramStruct)
 //	params["world_scaling_factor"] = 10;
 	
 	if (p0 > 0 && p0 < 2 && p1 > 0 && p1 < 2 && p2 >= 0.3 && p2 <= 1)
-		return calculateError(params, ps->sceneInfos);
+		return calculateError(params, ps->scenes);
 	else
 		return 1e20;
 }
@@ -171,12 +134,12 @@ double EnergyFunctionCustomShapeFactor(const gsl_vector *v, void *paramStruct)
 	if (p0 > 0 && p0 < 2 && p1 > 0 && p1 < 2 &&
 			sq > 0.3 && sq <= 1 && pa > 0.3 && pa <= 1 &&
 			st > 0.3 && st <= 1 &&	lt > 0.3 && lt <= 1)
-		return calculateError(params, ps->sceneInfos, sq, pa, st, lt);
+		return calculateError(params, ps->scenes, sq, pa, st, lt);
 	else
 		return 1e20;
 }
 
-void optimizeParams(const vector<PushingSceneInfo> &train_data, const vector<PushingSceneInfo> &test_data, const vector<PushingSceneInfo> &all_data, bool optimize_shape_factors, ostream &out) {
+void optimizeParams(const SceneView &train_data, const SceneView &test_data, const SceneView &all_data, bool optimize_shape_factors, ostream &out) {
 	psim.init();
 	#if VISUALIZE
 		psim.setFastForward(2);
@@ -306,6 +269,8 @@ int main(int argc, char **argv) {
   if (argc != 3) {
     cout << "usage: " << argv[0] << " <shape-type> <output-filename>" << endl;
     cout << "  shape-types: all, sq, pa, st, mt, lt." << endl;
+    cout << "  Instead of a shape type a file with pushing actions recorded in the" << endl;
+    cout << "  TangramRobotGui can be passed (e.g. ./data/pushing_actions.dat)." << endl;
     return -1;
   }
   string name(argv[1]);
@@ -316,6 +281,10 @@ int main(int argc, char **argv) {
 
 	string filename = "push_data.txt";
 	if (name == "all") filename = "push_data_15.txt";
+  if (name.size() > 4 && name.substr(name.size()-4) == ".dat") {
+  	data_files.push_back(name);
+  	shape_types.push_back(Shapes::UNKNOWN);
+  }
   if (name == "all" || name == "sq") {
   	data_files.push_back(string("./data/pushing_real_closed_loop/square/")+filename);
   	shape_types.push_back(Shapes::SQUARE);
@@ -343,13 +312,14 @@ int main(int argc, char **argv) {
   train_data_selector.push_back(1);train_data_selector.push_back(5);train_data_selector.push_back(11);
   vector<float> test_data_selector;
   test_data_selector.push_back(3);test_data_selector.push_back(8);
-	vector<PushingSceneInfo> train_data, test_data, all_data;
+	SceneBatch batch;
 	for (unsigned int i=0; i<data_files.size(); ++i) {
 		// read real pushing results from file
-  	loadData(data_files[i], train_data, shape_types[i], train_data_selector);
-  	loadData(data_files[i], test_data, shape_types[i], test_data_selector);
-  	loadData(data_files[i], all_data, shape_types[i], all_data_selector);
+  	batch.load(data_files[i], shape_types[i], getDefaults());
 	}
+	SceneView train_data = SceneView(batch).selectPushOffsets(train_data_selector);
+	SceneView test_data = SceneView(batch).selectPushOffsets(test_data_selector);
+	SceneView all_data = SceneView(batch).selectPushOffsets(all_data_selector);
 	cout << "in total, " << train_data.size() << " training and " << test_data.size() << " testing trials were loaded." << endl;
   if (train_data.size() < 2 || test_data.size() < 2) {
     cout << "Number of trials too small, exiting..." << endl;
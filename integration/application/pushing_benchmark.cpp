@@ -0,0 +1,331 @@
+// Copyright 2009 Erik Weitnauer
+/// Benchmark of PushingSimulatorFast::simulate on tangram pushing scenes.
+/**
+ * The scenes are simulated through the PushingRecorder like in the
+ * parameter optimization, so the time includes creating the convex hull
+ * shapes of the tangrams. For each shape type, the pushes of the closed loop
+ * experiments are used if their data files are passed with -data. Otherwise
+ * the tangram is pushed with offsets of 1, 3 and 5 cm to its center, like in
+ * the experiments. Multi-body scenes place 2, 4 or all 7 pieces of a tangram
+ * set on a grid 30 cm apart, the pusher moves through the first column.
+ *
+ * Each scene set is simulated with the default parameters and with one
+ * parameter changed at a time: sim_stepsize, solver_iterations, each solver
+ * mode and use_modified_shape. For each case, simulations per second, ns
+ * per simulation step, heap allocations per simulation (operator new and
+ * Bullet's aligned allocator) and contact points per step are reported.
+ *
+ * With -json, the results are written to a file. With -baseline, they are
+ * compared with such a file; the exit code is 1 if a case got slower by
+ * more than the tolerance (default 10%) in ns per step.
+ *
+ * usage: pushing_benchmark [-reps n] [-json out.json] [-baseline base.json] [-tolerance 0.1]
+ *                          [-data sq|pa|st|mt|lt push_data.txt]...
+ */
+
+#include <PushingSimulatorFast.h>
+#include <PushingRecorder.h>
+#include <PushingScene.h>
+#include <SceneBatch.h>
+#include <Shapes.h>
+#include <ICLUtils/Time.h>
+#include <LinearMath/btAlignedAllocator.h>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+
+using namespace std;
+
+#define TANGRAM_LENGTH 0.096 // 9.6 cm
+#define TANGRAM_HEIGHT 0.018 // 1.8 cm
+#define SQ_MASS 0.138 // 138 g
+#define LT_MASS 0.268 // 268 g
+#define MT_MASS 0.138 // 138 g
+#define ST_MASS 0.072 // 72 g
+#define PA_MASS 0.138 // 138 g
+#define PUSHER_SPEED 0.05 // 5 cm / s
+#define PUSHER_DIAMETER 0.022 // 2.2 cm
+
+// count all heap allocations, the benchmark runs in one thread
+static long long allocations = 0;
+
+#if __cplusplus >= 201103L
+void *operator new(size_t size) {
+#else
+void *operator new(size_t size) throw(std::bad_alloc) {
+#endif
+  allocations++;
+  void *p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) throw() {
+  free(p);
+}
+
+void *countingAlloc(size_t size) {
+  allocations++;
+  return malloc(size);
+}
+
+void countingFree(void *p) {
+  free(p);
+}
+
+Shapes::ShapeType shapeTypes[] = {Shapes::SQUARE, Shapes::PARALLELOGRAM,
+  Shapes::SMALL_TRIANGLE, Shapes::MEDIUM_TRIANGLE, Shapes::LARGE_TRIANGLE};
+const char *shapeNames[] = {"sq", "pa", "st", "mt", "lt"};
+float shapeMasses[] = {SQ_MASS, PA_MASS, ST_MASS, MT_MASS, LT_MASS};
+
+PushingSceneInfo getDefaults(int shape) {
+  PushingSceneInfo si;
+  si.tmass = shapeMasses[shape];
+  si.tlength = TANGRAM_LENGTH;
+  si.theight = TANGRAM_HEIGHT;
+  si.ttype = shapeTypes[shape];
+  si.tcorners = Shapes::getCorners(si.ttype, TANGRAM_LENGTH);
+  si.pspeed = PUSHER_SPEED;
+  si.pdiam = PUSHER_DIAMETER;
+  return si;
+}
+
+/// Tangram at (x, y), pushed along the y axis with an offset in x.
+void addPush(SceneBatch &batch, int shape, float x, float y, float rot, float offset) {
+  PushingSceneInfo si = getDefaults(shape);
+  si.setTangramPos(x, y, rot, x, y, rot);
+  si.setPusherPos(x+offset, y-0.1, x+offset, y+0.05);
+  batch.add(si);
+}
+
+struct SceneSet {
+  string name;
+  SceneView scenes;
+  bool multi_body; ///< all scenes of the view are simulated together
+};
+
+struct Variant {
+  string name;
+  PhysicsParameters params;
+};
+
+struct CaseResult {
+  CaseResult(): sims(0), seconds(0), steps(0), contacts(0), allocations(0) {}
+  int sims;
+  double seconds;
+  long long steps, contacts, allocations;
+
+  double simsPerSecond() const { return seconds > 0 ? sims/seconds : 0; }
+  double nsPerStep() const { return steps ? 1e9*seconds/steps : 0; }
+  double allocationsPerSim() const { return sims ? double(allocations)/sims : 0; }
+  double contactsPerStep() const { return steps ? double(contacts)/steps : 0; }
+};
+
+/// Simulates all scenes of the set 'reps' times.
+CaseResult run(PushingSimulatorFast &psim, PushingRecorder &prec, const PhysicsParameters &params,
+    const SceneSet &set, int reps) {
+  CaseResult r;
+  PushingScene scene;
+  SimulationSettings simsets(1);
+  int n = set.multi_body ? 1 : set.scenes.size();
+  for (int k=0; k<reps; k++) {
+    for (int i=0; i<n; i++) {
+      long long allocations_before = allocations;
+      icl::Time start = icl::Time::now();
+      if (set.multi_body) prec.simulateMultipleBodies(scene, simsets, params, set.scenes);
+      else prec.simulateSingleParameterSetting(scene, simsets, params, set.scenes, i);
+      r.seconds += (icl::Time::now()-start).toSecondsDouble();
+      r.allocations += allocations - allocations_before;
+      r.sims++;
+      r.steps += psim.getStepCount();
+      r.contacts += psim.getContactCount();
+    }
+  }
+  return r;
+}
+
+/// Reads the number after "key": in the line.
+bool readValue(const string &line, const string &key, double &value) {
+  size_t pos = line.find("\"" + key + "\":");
+  if (pos == string::npos) return false;
+  stringstream ss(line.substr(pos + key.size() + 3));
+  return (ss >> value);
+}
+
+/// Reads the ns per step of all cases from a file written with -json.
+bool loadBaseline(const string &filename, map<string, double> &ns_per_step) {
+  ifstream f(filename.c_str());
+  if (!f) return false;
+  string line;
+  while (getline(f, line)) {
+    size_t pos = line.find("\"name\": \"");
+    double value;
+    if (pos == string::npos || !readValue(line, "ns_per_step", value)) continue;
+    size_t begin = pos + 9, end = line.find('"', begin);
+    ns_per_step[line.substr(begin, end-begin)] = value;
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  int reps = 3;
+  float tolerance = 0.1;
+  string json_file, baseline_file;
+  SceneBatch batch;
+  vector<int> loaded(5, 0); // scenes per shape type loaded from files
+  for (int i=1; i<argc; i++) {
+    string arg(argv[i]);
+    if (arg == "-reps" && i+1 < argc) reps = atoi(argv[++i]);
+    else if (arg == "-json" && i+1 < argc) json_file = argv[++i];
+    else if (arg == "-baseline" && i+1 < argc) baseline_file = argv[++i];
+    else if (arg == "-tolerance" && i+1 < argc) tolerance = atof(argv[++i]);
+    else if (arg == "-data" && i+2 < argc) {
+      string type(argv[++i]), filename(argv[++i]);
+      int shape = 0;
+      while (shape < 5 && type != shapeNames[shape]) shape++;
+      if (shape == 5) {
+        cerr << "unknown shape type " << type << ", use one of sq, pa, st, mt, lt" << endl;
+        return -1;
+      }
+      loaded[shape] += batch.loadClosedLoopData(filename, shapeTypes[shape], getDefaults(shape));
+    } else {
+      cerr << "usage: " << argv[0] << " [-reps n] [-json out.json] [-baseline base.json]"
+           << " [-tolerance 0.1] [-data sq|pa|st|mt|lt push_data.txt]..." << endl;
+      return -1;
+    }
+  }
+
+  // single body scenes, standard pushes for the shapes without data
+  vector<SceneSet> sets;
+  for (int shape=0; shape<5; shape++) {
+    vector<int> indices;
+    for (int i=0; i<batch.size(); i++) if (batch.getType(i) == shapeTypes[shape]) indices.push_back(i);
+    if (loaded[shape] == 0) {
+      float offsets[] = {0.01, 0.03, 0.05};
+      for (int k=0; k<3; k++) {
+        addPush(batch, shape, 0, 0, 0, offsets[k]);
+        indices.push_back(batch.size()-1);
+      }
+    }
+    SceneSet set = { shapeNames[shape], SceneView(batch, indices), false };
+    sets.push_back(set);
+  }
+  // multi body scenes with the pieces of a tangram set on a grid, pushed through the first column
+  int pieces[] = {4, 4, 3, 0, 1, 2, 2};
+  vector<int> grid;
+  for (int k=0; k<7; k++) {
+    addPush(batch, pieces[k], 0.3*(k%3), 0.3*(k/3), 0.3*k, 0.01);
+    grid.push_back(batch.size()-1);
+  }
+  // the pusher of the first piece starts clear of the rotated piece and passes the whole first column
+  batch.py0[grid[0]] = -0.2;
+  batch.py1[grid[0]] = 0.7;
+  int bodies[] = {2, 4, 7};
+  for (int k=0; k<3; k++) {
+    SceneSet set = { "multi" + icl::str(bodies[k]), SceneView(batch, vector<int>(grid.begin(), grid.begin()+bodies[k])), true };
+    sets.push_back(set);
+  }
+
+  // the default parameters and one change at a time
+  PhysicsParameters defaults;
+  vector<Variant> variants;
+  Variant v = { "default", defaults };
+  variants.push_back(v);
+  float stepsizes[] = {1./30, 1./120, 1./240};
+  for (int k=0; k<3; k++) {
+    v.params = defaults; v.params["sim_stepsize"] = stepsizes[k];
+    v.name = "sim_stepsize=1/" + icl::str(round(1/stepsizes[k]));
+    variants.push_back(v);
+  }
+  int iterations[] = {2, 5, 20};
+  for (int k=0; k<3; k++) {
+    v.params = defaults; v.params["solver_iterations"] = iterations[k];
+    v.name = "solver_iterations=" + icl::str(iterations[k]);
+    variants.push_back(v);
+  }
+  const char *modes[] = {"solver_mode_randomize", "solver_mode_friction_separate",
+    "solver_mode_use_warmstarting", "solver_mode_use_friction_warmstarting",
+    "solver_mode_use_2_friction_directions", "solver_mode_enable_friction_direction_caching",
+    "solver_mode_disable_velocity_dependent_friction"};
+  for (int k=0; k<7; k++) {
+    v.params = defaults; v.params[modes[k]] = 1;
+    v.name = modes[k];
+    variants.push_back(v);
+  }
+  v.params = defaults; v.params["use_modified_shape"] = 0;
+  v.name = "use_modified_shape=0";
+  variants.push_back(v);
+
+  btAlignedAllocSetCustom(countingAlloc, countingFree);
+  PushingSimulatorFast psim;
+  psim.init();
+  psim.setContactCounting(true);
+  PushingRecorder prec(&psim);
+  prec.setVerifyDeterminism(false);
+
+  map<string, double> baseline;
+  if (!baseline_file.empty() && !loadBaseline(baseline_file, baseline)) {
+    cerr << "could not read the baseline from " << baseline_file << endl;
+    return -1;
+  }
+
+  vector<string> names;
+  vector<CaseResult> results;
+  int regressions = 0;
+  cout << setw(52) << left << "case" << right << setw(10) << "sims/s" << setw(10) << "ns/step"
+       << setw(12) << "allocs/sim" << setw(14) << "contacts/step";
+  if (!baseline.empty()) cout << setw(12) << "vs. base";
+  cout << endl;
+  for (unsigned int i=0; i<variants.size(); i++) {
+    for (unsigned int j=0; j<sets.size(); j++) {
+      string name = variants[i].name + "/" + sets[j].name;
+      CaseResult r = run(psim, prec, variants[i].params, sets[j], reps);
+      names.push_back(name);
+      results.push_back(r);
+      cout << setw(52) << left << name << right << fixed << setprecision(1)
+           << setw(10) << r.simsPerSecond() << setw(10) << r.nsPerStep()
+           << setw(12) << r.allocationsPerSim() << setw(14) << setprecision(2) << r.contactsPerStep();
+      map<string, double>::const_iterator base = baseline.find(name);
+      if (base != baseline.end() && base->second > 0) {
+        double change = r.nsPerStep()/base->second - 1;
+        cout << setw(11) << showpos << setprecision(1) << 100*change << "%" << noshowpos;
+        if (change > tolerance) {
+          cout << " SLOWER";
+          regressions++;
+        }
+      }
+      cout << endl;
+    }
+  }
+
+  if (!json_file.empty()) {
+    ofstream out(json_file.c_str());
+    if (!out) {
+      cerr << "could not write " << json_file << endl;
+      return -1;
+    }
+    out << "{" << endl;
+    out << "  \"reps\": " << reps << "," << endl;
+    out << "  \"cases\": [" << endl;
+    // fixed point, so the baseline keeps all digits of ns_per_step
+    out << fixed << setprecision(3);
+    for (unsigned int i=0; i<results.size(); i++) {
+      const CaseResult &r = results[i];
+      out << "    {\"name\": \"" << names[i] << "\", \"sims\": " << r.sims << ", \"steps\": " << r.steps
+          << ", \"sims_per_s\": " << r.simsPerSecond() << ", \"ns_per_step\": " << r.nsPerStep()
+          << ", \"allocs_per_sim\": " << r.allocationsPerSim()
+          << ", \"contacts_per_step\": " << r.contactsPerStep() << "}"
+          << (i+1 < results.size() ? "," : "") << endl;
+    }
+    out << "  ]" << endl << "}" << endl;
+  }
+  if (!baseline.empty()) {
+    cout << regressions << " of " << results.size() << " cases are more than "
+         << 100*tolerance << "% slower than the baseline" << endl;
+  }
+  return regressions ? 1 : 0;
+}
@@ -6,6 +6,10 @@
 #include <Shapes.h>
 #include <DESolver.h>
 #include <PushingRecorder.h>
+#include <ResultStore.h>
+#include <SceneBatch.h>
+#include <corner_distance.h>
+#include <map>
 
 #include <ICLUtils/StringUtils.h>
 #include <vector>
@@ -28,69 +32,46 @@ PushingSimulatorFast psim;
 #define PUSHER_DIAMETER 0.019 // 1.9 cm
 
 PushingRecorder prec(&psim);
+ResultStore *store = NULL;
 
 using namespace std;
 
 /// Returns number of loaded entries
-int loadData(const string &filename, vector<PushingSceneInfo> &data, Shapes::ShapeType shapeType, vector<float> data_selector) {
-  ifstream f(filename.c_str());
-  string line;
-  getline(f, line); // first line has column names
-	int counter = 0;
-  while (f.good()) {
-    getline(f, line);
-    vector<float> v = icl::parseVecStr<float>(line, " ");
-    if (v.size() != 10) continue;
-    bool use_this = false;
-    for (unsigned int i=0; i<data_selector.size(); i++) {
-    	if (data_selector[i]-0.5 < abs(v[0]-v[3]) && data_selector[i]+0.5 > abs(v[0]-v[3])) {
-    		use_this = true; break;
-    	}
-    }
-    if (!use_this) continue;
-    // file data columns: tx0 ty0 trot0 ax0 ay0 ax1 ay1 tx1 ty1 trot1
-    PushingSceneInfo si;
-    si.setTangramPos(v[0]/100,v[1]/100,v[2]/180*M_PI,v[7]/100,v[8]/100,v[9]/180*M_PI);
-    si.setPusherPos(v[3]/100,v[4]/100,v[5]/100,v[6]/100);
-		si.tmass = TANGRAM_MASS;
-		si.tlength = TANGRAM_LENGTH;
-		si.theight = TANGRAM_HEIGHT;
-		si.pspeed = PUSHER_SPEED;
-		si.pdiam = PUSHER_DIAMETER;
-		si.tcorners = Shapes::getCorners(shapeType, TANGRAM_LENGTH);
-		si.ttype = shapeType;
-		data.push_back(si);
-		counter++;
-  }
-  f.close();
-  return counter;
+int loadData(const string &filename, SceneBatch &batch, Shapes::ShapeType shapeType) {
+  PushingSceneInfo defaults;
+  defaults.tmass = TANGRAM_MASS;
+  defaults.tlength = TANGRAM_LENGTH;
+  defaults.theight = TANGRAM_HEIGHT;
+  defaults.pspeed = PUSHER_SPEED;
+  defaults.pdiam = PUSHER_DIAMETER;
+  return batch.loadClosedLoopData(filename, shapeType, defaults);
 }
 
 // returns the stddev of tangram end positions in identical trials averaged over all groups of identical trials
-float calculateStdDevReal(vector< vector<PushingSceneInfo> > &h_data) {
+float calculateStdDevReal(const vector<SceneView> &h_data) {
   float std_dev = 0;
   int total_n = 0;
 	for (unsigned int dt=0; dt<h_data.size(); ++dt) {
-	  vector<PushingSceneInfo> &data = h_data[dt];
+	  const SceneView &data = h_data[dt];
 	  if (data.size() == 0) continue;
-		PolygonShape ps = PolygonShape(data[0].tcorners);
+		CornerDistance cd(PolygonShape(data.getCorners(0)));
+    PoseArray deltas;
     float x=0, y=0, rot=0;
     int n = data.size();
     for (int i=0; i<n; ++i) {
-	    rot += data[i].trot1-data[i].trot0;
-	    x += data[i].tx1-data[i].tx0;
-	    y += data[i].ty1-data[i].ty0;
+      Transformation t = data.getDelta(i);
+      deltas.push_back(t);
+	    rot += t.getRotation();
+	    x += t.getTx();
+	    y += t.getTy();
     }
     x = x/n; y = y/n; rot = rot/n;
     Transformation t_mean(rot,x,y);
-    PolygonShape ps_mean = t_mean*ps;
+    vector<float> dists;
+    cd.compute(deltas, t_mean, dists);
 
     float var = 0;
-    for (int i=0; i<n; ++i) {
-	    Transformation t_curr(data[i].trot1-data[i].trot0, data[i].tx1-data[i].tx0, data[i].ty1-data[i].ty0);
-      float dist = ps_mean.getMeanCornerDistance(t_curr*ps);
-	    var += dist*dist;
-    }
+    for (int i=0; i<n; ++i) var += dists[i]*dists[i];
     std_dev += sqrt(var/n); 
     total_n++;
   }
@@ -98,30 +79,26 @@ float calculateStdDevReal(vector< vector<PushingSceneInfo> > &h_data) {
 }
 
 // returns the mean corner distance of the 5 end positions in the identical trials
-float calculateMinimalError(vector< vector<PushingSceneInfo> > &h_data) {
+float calculateMinimalError(const vector<SceneView> &h_data) {
   float total_min_err = 0;
   int total_n = 0;
 	for (unsigned int dt=0; dt<h_data.size(); ++dt) {
-	  vector<PushingSceneInfo> &data = h_data[dt];
+	  const SceneView &data = h_data[dt];
 	  if (data.size() == 0) continue;
-		PolygonShape ps = PolygonShape(data[0].tcorners);
+		CornerDistance cd(PolygonShape(data.getCorners(0)));
+    PoseArray deltas;
     float x=0, y=0, rot=0;
     int n = data.size();
     for (int i=0; i<n; ++i) {
-	    rot += data[i].trot1-data[i].trot0;
-	    x += data[i].tx1-data[i].tx0;
-	    y += data[i].ty1-data[i].ty0;
+      Transformation t = data.getDelta(i);
+      deltas.push_back(t);
+	    rot += t.getRotation();
+	    x += t.getTx();
+	    y += t.getTy();
     }
     x = x/n; y = y/n; rot = rot/n;
     Transformation t_mean(rot,x,y);
-    PolygonShape ps_mean = t_mean*ps;
-
-    float min_err = 0;
-    for (int i=0; i<n; ++i) {
-	    Transformation t_curr(data[i].trot1-data[i].trot0, data[i].tx1-data[i].tx0, data[i].ty1-data[i].ty0);
-      float dist = ps_mean.getMeanCornerDistance(t_curr*ps);
-	    min_err += dist;
-    }
+    float min_err = cd.sum(deltas, t_mean);
     total_n += n;
     total_min_err += min_err;
   }
@@ -129,38 +106,48 @@ float calculateMinimalError(vector< vector<PushingSceneInfo> > &h_data) {
 }
 
 /// Returns corner distance from start to end position in mm
-float calculateMaximalError(vector<PushingSceneInfo> &sceneInfos) {
+float calculateMaximalError(const SceneView &scenes) {
+	// group the deltas by shape to evaluate all scenes of a shape in one batch
+	map<int, PoseArray> deltas;
+	int n = scenes.size();
+	for (int i=0; i<n; i++) deltas[scenes.getBatch().shape_id[scenes[i]]].push_back(scenes.getDelta(i));
 	float error = 0;
-	int n = sceneInfos.size();
-	for (int i=0; i<n; i++) {
-    PushingSceneInfo &data = sceneInfos[i];
-		PolygonShape ps = PolygonShape(data.tcorners);
-		Transformation t_curr(data.trot1-data.trot0, data.tx1-data.tx0, data.ty1-data.ty0);
-		error += ps.getMeanCornerDistance(t_curr*ps);
+	for (map<int, PoseArray>::const_iterator it = deltas.begin(); it != deltas.end(); ++it) {
+		CornerDistance cd(PolygonShape(scenes.getBatch().shapes.getCorners(it->first)));
+		error += cd.sum(it->second, Transformation());
 	}
 	return 1000. * error / n;
 }
 
 /// Returns mean corner distance to target in mm
-float calculateError( PhysicsParameters &params,
-		vector<PushingSceneInfo> &sceneInfos, float pusher_diam=-1) {
+float calculateError(PhysicsParameters &params, const SceneView &scenes) {
 	float error = 0;
-	int n = sceneInfos.size();
+	int n = scenes.size();
 	static PushingScene scene;
   static SimulationSettings simsets(4); // 4 repetitions
 	for (int i=0; i<n; i++) {
-		PushingSceneInfo &sceneInfo = sceneInfos[i];
-		float real_dx = (sceneInfo.tx1-sceneInfo.tx0);
-		float real_dy = (sceneInfo.ty1-sceneInfo.ty0);
-		float real_drot = (sceneInfo.trot1-sceneInfo.trot0);
-		prec.simulateSingleParameterSetting(scene, simsets, params, sceneInfo);
-		scene.calcStatistics(Transformation(real_drot, real_dx, real_dy));
-		
-		float dist = scene.pbodies[0].getDistanceToReference();
+		PushingSceneInfo sceneInfo;
+		scenes.getBatch().get(scenes[i], sceneInfo, false);
+		Transformation treal = scenes.getDelta(i);
+		float dist = 0;
+		ResultRecord r;
+		ResultStore::Query query = ResultStore::Query()
+			.scene(ResultStore::sceneId(sceneInfo, scenes.getCorners(i)))
+			.params(ResultStore::paramsHash(params))
+			.settings(ResultStore::settingsHash(simsets));
+		if (store && store->findLatest(query, r) && !r.end_deltas.empty()) {
+			// reuse the end positions of an earlier simulation
+			CornerDistance cd(PolygonShape(scenes.getCorners(i)));
+			PoseArray ends;
+			for (unsigned int j=0; j<r.end_deltas.size(); j++) ends.push_back(r.end_deltas[j]);
+			dist = cd.sum(ends, treal) / r.end_deltas.size();
+		} else {
+			prec.simulateSingleParameterSetting(scene, simsets, params, scenes, i);
+			scene.calcStatistics(treal);
+			prec.storeResults(scene, simsets, params, scenes, i);
+			dist = scene.pbodies[0].getDistanceToReference();
+		}
 		error += dist;
-		
-		PolygonShape pstart(sceneInfo.tcorners);
-		Transformation treal(real_drot,real_dx,real_dy);
 	}
 	return 1000. * error / n;
 }
@@ -204,8 +191,9 @@ void collectFilenames(string name, vector<string> &data_files, vector<Shapes::Sh
   }
 }
 
-vector<PushingSceneInfo> loadScenesByName(string name, vector<float> data_selector) {
-  vector<PushingSceneInfo> data;
+/// Loads the data of all files for the shape type into the batch, returns one view per file.
+vector<SceneView> loadScenesByName(string name, SceneBatch &batch) {
+  vector<SceneView> files;
   
   vector<string> data_files;
   vector<Shapes::ShapeType> shape_types;
@@ -213,38 +201,30 @@ vector<PushingSceneInfo> loadScenesByName(string name, vector<float> data_select
 	
   for (unsigned int i=0; i<data_files.size(); ++i) {
 		// read real pushing results from file
-  	//cout << "loading data from file " << data_files[i] << "...";
-  	//int count = loadData(data_files[i], data, shape_types[i], data_selector);
-  	//cout << "OK (" << count << ") trials loaded" << endl;
-  	loadData(data_files[i], data, shape_types[i], data_selector);
+  	int begin = batch.size();
+  	loadData(data_files[i], batch, shape_types[i]);
+  	files.push_back(SceneView(batch).slice(begin, batch.size()));
 	}
-	//cout << "in total, " << data.size() << " trials were loaded." << endl;
-  return data;
+  return files;
 }
 
-vector< vector<PushingSceneInfo> > loadScenesByNameHierachical(string name, vector<float> data_selector) {
-  vector< vector<PushingSceneInfo> > data;
-  vector<string> data_files;
-  vector<Shapes::ShapeType> shape_types;
-  collectFilenames(name, data_files, shape_types);
-	
+/// Returns one group of identical trials per push offset and file.
+vector<SceneView> groupScenes(const vector<SceneView> &files, vector<float> data_selector) {
+  vector<SceneView> data;
   for (unsigned int ds=0; ds<data_selector.size(); ++ds) {
     vector<float> single_data_selector;
     single_data_selector.push_back(data_selector[ds]);
-    for (unsigned int i=0; i<data_files.size(); ++i) {
-		  // read real pushing results from file
-		  data.push_back(vector<PushingSceneInfo>());
-  	  //int count = loadData(data_files[i], data.back(), shape_types[i], single_data_selector);
-  	  //cout << "OK (" << count << ") trials loaded" << endl;
-  	  loadData(data_files[i], data.back(), shape_types[i], single_data_selector);
+    for (unsigned int i=0; i<files.size(); ++i) {
+		  data.push_back(files[i].selectPushOffsets(single_data_selector));
 	  }
   }
-  //cout << "in total, " << data.size() << " trial types were loaded." << endl;
   return data;
 }
 
 int main(int argc, char **argv) {
   init();
+  ResultStore result_store("./data/pushing_sim/results.store");
+  store = &result_store;
 
 	vector<float> train_data_selector;
   train_data_selector.push_back(1);train_data_selector.push_back(5);train_data_selector.push_back(11);
@@ -256,14 +236,16 @@ int main(int argc, char **argv) {
   vector<float> x1_selector;
   x1_selector.push_back(1);
   PhysicsParameters params; params["collision_margin"] = 0.005;
-  vector<PushingSceneInfo> scene_infos;
-  vector< vector<PushingSceneInfo> > h_scene_infos;
+  SceneView scene_infos;
+  vector<SceneView> h_scene_infos;
 
   vector<string> types;
   types.push_back("sq"); types.push_back("pa"); types.push_back("st"); types.push_back("lt"); types.push_back("all");
   
   for (unsigned int i=0; i<types.size(); i++) {
     string type = types[i];
+    SceneBatch batch;
+    vector<SceneView> files = loadScenesByName(type, batch);
     
 //    if (type=="lt") {
 //      params["friction_polygon"] = 0.6213;//0.626651;
@@ -288,20 +270,20 @@ int main(int argc, char **argv) {
 //      Shapes::setCorrectShapeFactors(0.6166,0.7197,0.5388,1,0.5911);
 //    }
     
-    scene_infos = loadScenesByName(type,train_data_selector);
-    h_scene_infos = loadScenesByNameHierachical(type,train_data_selector);
+    scene_infos = SceneView(batch).selectPushOffsets(train_data_selector);
+    h_scene_infos = groupScenes(files,train_data_selector);
     cout << "[" << type << "] training error: " << calculateError(params, scene_infos)*0.1 << " cm." << endl;
     cout << "            minimal: " << calculateMinimalError(h_scene_infos) *0.1 << " cm." << endl;
     cout << "            std dev: " << calculateStdDevReal(h_scene_infos) *0.1 << " cm." << endl;
     cout << "            maximal: " << calculateMaximalError(scene_infos) *0.1 << " cm." << endl;
-    scene_infos = loadScenesByName(type,test_data_selector);
-    h_scene_infos = loadScenesByNameHierachical(type,test_data_selector);
+    scene_infos = SceneView(batch).selectPushOffsets(test_data_selector);
+    h_scene_infos = groupScenes(files,test_data_selector);
     cout << "[" << type << "]  testing error: " << calculateError(params, scene_infos)*0.1 << " cm." << endl;
     cout << "            minimal: " << calculateMinimalError(h_scene_infos) *0.1 << " cm." << endl;
     cout << "            std dev: " << calculateStdDevReal(h_scene_infos) *0.1 << " cm." << endl;
     cout << "            maximal: " << calculateMaximalError(scene_infos) *0.1 << " cm." << endl;
-    scene_infos = loadScenesByName(type,all_data_selector);
-    h_scene_infos = loadScenesByNameHierachical(type,all_data_selector);
+    scene_infos = SceneView(batch).selectPushOffsets(all_data_selector);
+    h_scene_infos = groupScenes(files,all_data_selector);
     cout << "[" << type << "]    total error: " << calculateError(params, scene_infos)*0.1 << " cm." << endl;
     cout << "            minimal: " << calculateMinimalError(h_scene_infos) *0.1 << " cm." << endl;
     cout << "            std dev: " << calculateStdDevReal(h_scene_infos) *0.1 << " cm." << endl;
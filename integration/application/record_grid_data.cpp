@@ -6,6 +6,7 @@
 #include <Shapes.h>
 #include <DESolver.h>
 #include <PushingRecorder.h>
+#include <SceneBatch.h>
 
 #include <ICLUtils/StringUtils.h>
 #include <vector>
@@ -32,51 +33,30 @@ PushingRecorder prec(&psim);
 using namespace std;
 
 /// Returns number of loaded entries
-int loadData(const string &filename, vector<PushingSceneInfo> &data, Shapes::ShapeType shapeType) {
-  ifstream f(filename.c_str());
-  string line;
-  getline(f, line); // first line has column names
-	int counter = 0;
-  while (f.good()) {
-    getline(f, line);
-    vector<float> v = icl::parseVecStr<float>(line, " ");
-    if (v.size() != 10) continue;
-    if (abs(v[0]-v[3]) < 0.5) continue; // pushing against center of object -> too chaotic
-    // file data columns: tx0 ty0 trot0 ax0 ay0 ax1 ay1 tx1 ty1 trot1
-    PushingSceneInfo si;
-    si.setTangramPos(v[0]/100,v[1]/100,v[2]/180*M_PI,v[7]/100,v[8]/100,v[9]/180*M_PI);
-    si.setPusherPos(v[3]/100,v[4]/100,v[5]/100,v[6]/100);
-		si.tmass = TANGRAM_MASS;
-		si.tlength = TANGRAM_LENGTH;
-		si.theight = TANGRAM_HEIGHT;
-		si.pspeed = PUSHER_SPEED;
-		si.pdiam = PUSHER_DIAMETER;
-		si.tcorners = Shapes::getCorners(shapeType, TANGRAM_LENGTH);
-		si.ttype = shapeType;
-		data.push_back(si);
-		counter++;
-  }
-  f.close();
-  return counter;
+int loadData(const string &filename, SceneBatch &batch, Shapes::ShapeType shapeType) {
+  PushingSceneInfo defaults;
+  defaults.tmass = TANGRAM_MASS;
+  defaults.tlength = TANGRAM_LENGTH;
+  defaults.theight = TANGRAM_HEIGHT;
+  defaults.pspeed = PUSHER_SPEED;
+  defaults.pdiam = PUSHER_DIAMETER;
+  return batch.loadClosedLoopData(filename, shapeType, defaults);
+}
+
+/// Pushing against the center of the object is too chaotic
+bool notCentered(const SceneBatch &batch, int i) {
+  return 100*batch.getPushOffset(i) >= 0.5;
 }
 
 /// Returns mean corner distance to target in mm
-float calculateError( PhysicsParameters &params,
-		vector<PushingSceneInfo> &sceneInfos, float pusher_diam=-1) {
+float calculateError(PhysicsParameters &params, const SceneView &scenes) {
 	float error = 0;
-	int n = sceneInfos.size();
+	int n = scenes.size();
 	static PushingScene scene;
   static SimulationSettings simsets(2); // 4 repetitions
 	for (int i=0; i<n; i++) {
-		PushingSceneInfo &sceneInfo = sceneInfos[i];
-		float real_dx = (sceneInfo.tx1-sceneInfo.tx0);
-		float real_dy = (sceneInfo.ty1-sceneInfo.ty0);
-		float real_drot = (sceneInfo.trot1-sceneInfo.trot0);
-		float old_diam = sceneInfo.pdiam;
-		if (pusher_diam != -1) sceneInfo.pdiam = pusher_diam;
-		prec.simulateSingleParameterSetting(scene, simsets, params, sceneInfo);
-		if (pusher_diam != -1) sceneInfo.pdiam = old_diam;
-		scene.calcStatistics(Transformation(real_drot, real_dx, real_dy));
+		prec.simulateSingleParameterSetting(scene, simsets, params, scenes, i);
+		scene.calcStatistics(scenes.getDelta(i));
 
 		float dist = scene.pbodies[0].getDistanceToReference();
 		error += dist;
@@ -95,7 +75,7 @@ float calculateError( PhysicsParameters &params,
   * references. */
 void record_grid(vector<float> &par1, vector<float> &par2, vector<float> &errors,
 		const SimulationSettings &simset1, const SimulationSettings &simset2,
-		const PhysicsParameters &params_const, vector<PushingSceneInfo> &sceneInfos) {
+		const PhysicsParameters &params_const, const SceneView &scenes) {
 	PhysicsParameters params = params_const;
 //	int N = simset1.steps * simset2.steps;
 	for (int i=0; i<simset1.steps; i++) {
@@ -105,7 +85,7 @@ void record_grid(vector<float> &par1, vector<float> &par2, vector<float> &errors
 			float value2 = simset2.getValue(j);
 			params[simset1.param_name] = value1;
 			params[simset2.param_name] = value2;
-			float error = calculateError(params, sceneInfos);
+			float error = calculateError(params, scenes);
 			par1.push_back(value1);
 			par2.push_back(value2);
 			errors.push_back(error);
@@ -157,13 +137,14 @@ int main(int argc, char **argv) {
   	shape_types.push_back(Shapes::SMALL_TRIANGLE);
   }
   
-	vector<PushingSceneInfo> data;
+	SceneBatch batch;
 	for (unsigned int i=0; i<data_files.size(); ++i) {
 		// read real pushing results from file
   	cout << "loading data from file " << data_files[i] << "...";
-  	int count = loadData(data_files[i], data, shape_types[i]);
+  	int count = loadData(data_files[i], batch, shape_types[i]);
   	cout << "OK (" << count << ") trials loaded" << endl;
 	}
+	SceneView data = SceneView(batch).select(notCentered);
 	cout << "in total, " << data.size() << " trials were loaded." << endl;
   if (data.size() < 2) {
     cout << "Number of trials too small, exiting..." << endl;
@@ -14,6 +14,7 @@
 #include <string>
 #include <ICLUtils/StringUtils.h>
 #include <PushingSimulatorDebug.h>
+#include <ResultStore.h>
 
 using namespace std;
 
@@ -104,6 +105,8 @@ void loadSceneFromFile(const string &filename, vector<PushingSceneInfo> &data, f
 
 int main() {
 	psim.init();
+	ResultStore store("./data/pushing_sim/results.store");
+	prec.setResultStore(&store);
 	#if VISUALIZE
 		psim.setFastForward(4);
 		icl::ExecThread y(show_physics_gui);
@@ -13,11 +13,6 @@
 TangramRobotGui gui;
 PushingSimulatorFast psim;
 
-void vision_loop() {
-	gui.vision_loop();
-  Thread::msleep(100);
-}
-
 void init() {
 	gui.init();
 	psim.init();
@@ -41,6 +36,7 @@ void init() {
 	}
 	gui.connectToArm(pa("-mem-srv-arm"),pa("-robot-arm-id"));
         gui.connectToHand(pa("-mem-srv-hand"),pa("-robot-hand-id"));
+	gui.startPipeline();
 }
 
 int main(int n, char **args) {
@@ -58,8 +54,10 @@ int main(int n, char **args) {
         ICLApplication app(n, args, "-input|-i(2) -size|-s(Size=VGA) -mem-srv-arm(string=xcf:mem-arm) "
                 "-mem-srv-hand(string=xcf:mem-hand) -cam-cfg(string) -tangram-cfg(string) "
                 "-robot-arm-id(string=LeftArm) -robot-hand-id(string=LeftHand) -grid(float=-1)",
-                init, vision_loop);
+                init);
   
-  return app.exec();
+  int result = app.exec();
+  gui.stopPipeline();
+  return result;
 }
 
@@ -2,6 +2,7 @@
 #define __PUSHED_BODY_EWEITNAU_H__
 
 #include <transformation.h>
+#include <corner_distance.h>
 #include <vision_adapter.h>
 #include <algorithm>
 #include <iostream>
@@ -12,7 +13,7 @@
 class PushedBody {
 	public:
 		PushedBody(btRigidBody *body, PolygonShape unscaled_pshape, float scaling):
-				m_adapter(scaling), m_body(body), m_pshape(unscaled_pshape) {
+				m_adapter(scaling), m_body(body), m_pshape(unscaled_pshape), m_corner_distance(unscaled_pshape) {
 			body->getMotionState()->getWorldTransform(m_start_position);
 			m_start_t = m_adapter.to_vision(m_start_position);
 		}
@@ -45,7 +46,12 @@ class PushedBody {
       //myMotionState->m_graphicsWorldTrans = m_start_position;
 		}
 		
-		int getNumberOfEndPositions() { return m_end_positions.size(); }
+		int getNumberOfEndPositions() const { return m_end_positions.size(); }
+
+		/// Returns the delta transformation between start and i-th end position.
+		Transformation getEndDelta(int i) const {
+			return m_adapter.to_vision(m_end_positions[i]) - m_start_t;
+		}
 		
 		void clearEndPositions() { m_end_positions.clear(); }
 		
@@ -58,11 +64,13 @@ class PushedBody {
 		void calcStatistics(const Transformation &reference_delta_t=Transformation(0,0,0)) {
 			if (m_end_positions.empty()) return;
 			int n = m_end_positions.size();
-			PolygonShape ref_shape = reference_delta_t*m_pshape;
+			PoseArray deltas;
+			deltas.reserve(n);
 			// calculate min, max and mean translations
 			for (int i=0; i<n; ++i) {
 				Transformation end_t = m_adapter.to_vision(m_end_positions[i]);
 				Transformation delta_t = end_t - m_start_t;
+				deltas.push_back(delta_t);
 				if (i==0) {
 					m_mean_t = delta_t;	m_max_t = delta_t; m_min_t = delta_t;
 				} else {
@@ -76,27 +84,16 @@ class PushedBody {
 			m_mean_t.setTranslation(m_mean_t.getTx()/n, m_mean_t.getTy()/n);
 			m_mean_t.setRotation(m_mean_t.getRotation()/n);
 			
-			// calculate distance to reference
-			PolygonShape mean_shape = m_mean_t*m_pshape;
-			
 			// calculate variance of distance to mean
+			std::vector<float> mean_dists;
+			m_corner_distance.compute(deltas, m_mean_t, mean_dists);
 			m_variance = 0;
-			m_ref_distance = 0;
-			m_start_end_dist = 0;
-			for (int i=0; i<n; ++i) {
-				Transformation end_t = m_adapter.to_vision(m_end_positions[i]);
-				Transformation delta_t = end_t - m_start_t;
-				PolygonShape curr_shape = delta_t*m_pshape;
-				float mean_dist = mean_shape.getMeanCornerDistance(curr_shape);
-				float ref_dist = curr_shape.getMeanCornerDistance(ref_shape);
-				float start_end_dist = curr_shape.getMeanCornerDistance(m_pshape);
-				m_variance += mean_dist*mean_dist;
-				m_ref_distance += ref_dist;
-				m_start_end_dist += start_end_dist;
-			}
+			for (int i=0; i<n; ++i) m_variance += mean_dists[i]*mean_dists[i];
 			m_variance /= n;
-			m_ref_distance /= n;
-			m_start_end_dist /= n;
+			
+			// calculate distance to reference and to start position
+			m_ref_distance = m_corner_distance.sum(deltas, reference_delta_t) / n;
+			m_start_end_dist = m_corner_distance.sum(deltas, Transformation()) / n;
 		}
 
 		const Transformation &getMeanDelta() const { return m_mean_t; }
@@ -111,6 +108,7 @@ class PushedBody {
 		VisionAdapter m_adapter;
 		btRigidBody *m_body;
 		PolygonShape m_pshape;
+		CornerDistance m_corner_distance;
 		btTransform m_start_position;
 		std::vector<btTransform> m_end_positions;
 		Transformation m_mean_t;
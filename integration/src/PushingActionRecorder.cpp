@@ -0,0 +1,201 @@
+// Copyright 2009 Erik Weitnauer
+#include <PushingActionRecorder.h>
+#include <stdexcept>
+#include <cstring>
+
+using namespace std;
+using namespace icl;
+
+namespace {
+	template<class T> void put(vector<char> &buffer, const T &value) {
+		const char *p = reinterpret_cast<const char*>(&value);
+		buffer.insert(buffer.end(), p, p+sizeof(T));
+	}
+
+	template<class T> bool get(istream &in, T &value) {
+		return in.read(reinterpret_cast<char*>(&value), sizeof(T)).good();
+	}
+
+	bool get(istream &in, Transformation &t) {
+		float rot, tx, ty;
+		if (!get(in,rot) || !get(in,tx) || !get(in,ty)) return false;
+		t = Transformation(rot, tx, ty);
+		return true;
+	}
+
+	bool get(istream &in, Point32f &p) {
+		return get(in, p.x) && get(in, p.y);
+	}
+}
+
+const unsigned int PushingActionRecorder::MAGIC;
+const unsigned int PushingActionRecorder::VERSION;
+
+PushingActionRecorder::PushingActionRecorder(const string &filename, int batch_size):
+		m_filename(filename), m_batch_size(batch_size), m_writing(0),
+		m_stop(false), m_flush(false) {
+	ifstream probe(filename.c_str());
+	bool is_new = !probe.good() || probe.peek() == EOF;
+	probe.close();
+	m_out.open(filename.c_str(), ios::out | ios::app | ios::binary);
+	if (!m_out.good()) throw runtime_error("PushingActionRecorder: could not open " + filename);
+	if (is_new) {
+		vector<char> header;
+		put(header, MAGIC);
+		put(header, VERSION);
+		m_out.write(&header[0], header.size());
+		m_out.flush();
+	}
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_cond_init(&m_work_cond, NULL);
+	pthread_cond_init(&m_done_cond, NULL);
+	pthread_create(&m_thread, NULL, &PushingActionRecorder::run, this);
+}
+
+PushingActionRecorder::~PushingActionRecorder() {
+	pthread_mutex_lock(&m_mutex);
+	m_stop = true;
+	pthread_cond_signal(&m_work_cond);
+	pthread_mutex_unlock(&m_mutex);
+	pthread_join(m_thread, NULL);
+	pthread_cond_destroy(&m_done_cond);
+	pthread_cond_destroy(&m_work_cond);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void PushingActionRecorder::record(const PushingAction &action) {
+	pthread_mutex_lock(&m_mutex);
+	m_queue.push_back(action);
+	if (m_queue.size() >= m_batch_size) pthread_cond_signal(&m_work_cond);
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void PushingActionRecorder::flush() {
+	pthread_mutex_lock(&m_mutex);
+	m_flush = true;
+	pthread_cond_signal(&m_work_cond);
+	while (!m_queue.empty() || m_writing > 0) pthread_cond_wait(&m_done_cond, &m_mutex);
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void PushingActionRecorder::requestFlush() {
+	pthread_mutex_lock(&m_mutex);
+	m_flush = true;
+	pthread_cond_signal(&m_work_cond);
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void *PushingActionRecorder::run(void *self) {
+	static_cast<PushingActionRecorder*>(self)->writeLoop();
+	return NULL;
+}
+
+void PushingActionRecorder::writeLoop() {
+	vector<PushingAction> batch;
+	vector<char> buffer;
+	pthread_mutex_lock(&m_mutex);
+	while (true) {
+		while (!m_stop && !m_flush && m_queue.size() < m_batch_size)
+			pthread_cond_wait(&m_work_cond, &m_mutex);
+		batch.swap(m_queue);
+		m_writing = batch.size();
+		m_flush = false;
+		bool stop = m_stop;
+		pthread_mutex_unlock(&m_mutex);
+
+		buffer.clear();
+		for (unsigned int i=0; i<batch.size(); i++) serialize(batch[i], buffer);
+		if (!buffer.empty()) {
+			m_out.write(&buffer[0], buffer.size());
+			m_out.flush();
+			if (!m_out.good()) cerr << "PushingActionRecorder: error writing to " << m_filename << endl;
+		}
+		batch.clear();
+
+		pthread_mutex_lock(&m_mutex);
+		m_writing = 0;
+		pthread_cond_broadcast(&m_done_cond);
+		if (stop && m_queue.empty()) break;
+	}
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void PushingActionRecorder::serialize(const PushingAction &action, vector<char> &buffer) {
+	const string name = action.shape.getName();
+	put(buffer, (unsigned int)name.size());
+	buffer.insert(buffer.end(), name.begin(), name.end());
+	put(buffer, action.shape.getHeight());
+	const vector<Point32f> &corners = action.shape.getCorners();
+	put(buffer, (unsigned int)corners.size());
+	for (unsigned int i=0; i<corners.size(); i++) { put(buffer, corners[i].x); put(buffer, corners[i].y); }
+	const Transformation *ts[2] = { &action.pos_begin, &action.pos_end };
+	for (int i=0; i<2; i++) {
+		put(buffer, ts[i]->getRotation()); put(buffer, ts[i]->getTx()); put(buffer, ts[i]->getTy());
+	}
+	put(buffer, action.push_begin.x); put(buffer, action.push_begin.y);
+	put(buffer, action.push_end.x); put(buffer, action.push_end.y);
+}
+
+PushingActionReader::PushingActionReader(const string &filename) {
+	m_in.open(filename.c_str(), ios::in | ios::binary);
+	unsigned int magic, version;
+	if (!get(m_in, magic) || !get(m_in, version) || magic != PushingActionRecorder::MAGIC)
+		throw runtime_error("PushingActionReader: " + filename + " is no pushing action file");
+	if (version != PushingActionRecorder::VERSION)
+		throw runtime_error("PushingActionReader: unsupported version of " + filename);
+}
+
+bool PushingActionReader::next(PushingAction &action) {
+	unsigned int length, n;
+	float height;
+	if (!get(m_in, length) || length > 1024) return false;
+	string name(length, ' ');
+	if (length > 0 && !m_in.read(&name[0], length).good()) return false;
+	if (!get(m_in, height) || !get(m_in, n) || n > 1024) return false;
+	vector<Point32f> corners(n);
+	for (unsigned int i=0; i<n; i++) if (!get(m_in, corners[i])) return false;
+	if (!get(m_in, action.pos_begin) || !get(m_in, action.pos_end) ||
+	    !get(m_in, action.push_begin) || !get(m_in, action.push_end)) return false;
+	action.shape = PolygonShape(corners, height);
+	action.shape.setName(name);
+	return true;
+}
+
+bool PushingActionReader::next(PushingSceneInfo &sceneInfo) {
+	PushingAction action;
+	if (!next(action)) return false;
+	convert(action, m_defaults, sceneInfo);
+	return true;
+}
+
+void PushingActionReader::convert(const PushingAction &action, const PushingSceneInfo &defaults,
+		PushingSceneInfo &si) {
+	const float mm = 0.001;
+	si = defaults;
+	// the transformations rotate the shape around its centroid, so the tangram
+	// position is the transformed centroid
+	Point32f c = action.shape.getCenter();
+	si.setTangramPos((c.x+action.pos_begin.getTx())*mm, (c.y+action.pos_begin.getTy())*mm,
+	                 action.pos_begin.getRotation(),
+	                 (c.x+action.pos_end.getTx())*mm, (c.y+action.pos_end.getTy())*mm,
+	                 action.pos_end.getRotation());
+	si.setPusherPos(action.push_begin.x*mm, action.push_begin.y*mm,
+	                action.push_end.x*mm, action.push_end.y*mm);
+	Shapes::ShapeType type = getShapeType(action.shape.getName());
+	if (type != Shapes::UNKNOWN) si.ttype = type;
+	const vector<Point32f> &corners = action.shape.getCorners();
+	si.tcorners.clear();
+	for (unsigned int i=0; i<corners.size(); i++) {
+		si.tcorners.push_back((corners[i].x-c.x)*mm);
+		si.tcorners.push_back((corners[i].y-c.y)*mm);
+	}
+}
+
+Shapes::ShapeType PushingActionReader::getShapeType(const string &name) {
+	if (name == "Square") return Shapes::SQUARE;
+	if (name == "Parallelogram") return Shapes::PARALLELOGRAM;
+	if (name == "Triangle Small") return Shapes::SMALL_TRIANGLE;
+	if (name == "Triangle Medium") return Shapes::MEDIUM_TRIANGLE;
+	if (name == "Triangle Large") return Shapes::LARGE_TRIANGLE;
+	return Shapes::UNKNOWN;
+}
@@ -1,20 +1,27 @@
+// Copyright 2009 Erik Weitnauer
 #ifndef __PUSHING_ACTION_RECORDER_H__
 #define __PUSHING_ACTION_RECORDER_H__
 
 #include <polygon_shape.h>
 #include <transformation.h>
+#include <PushingSceneInfo.h>
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <vector>
+#include <pthread.h>
 
-/// Class for recording, writing and reading pushing actions.
-class PushingActionRecorder {
-	public:
+/// A pushing action performed on a single tangram piece.
+/** All values are in the vision world coordinate system (mm / radiants). The
+ * shape is the untransformed model shape, pos_begin and pos_end are the
+ * transformations of the tangram before and after pushing. */
+struct PushingAction {
 	PolygonShape shape;
 	Transformation pos_begin;
 	Transformation pos_end;
 	icl::Point32f push_begin;
 	icl::Point32f push_end;
-	
+
 	void writeToStream(std::ostream &shape_stream, std::ostream &data_stream) const {
 		shape_stream << shape << std::endl;
 		pos_begin.write_plain(data_stream) << std::endl;
@@ -24,5 +31,90 @@ class PushingActionRecorder {
 	}
 };
 
-#endif /* __PUSHING_ACTION_RECORDER_H__ */
+/// Writes pushing actions to a binary file in the background.
+/** record() only copies the action into a queue and returns immediately, so it
+ * can be called from the gui thread. A writer thread appends the queued
+ * actions in batches of up to 'batch_size' actions to the file. Call
+ * requestFlush() to have the queued actions written without waiting for a
+ * full batch, or flush() to wait until all recorded actions are written. The
+ * destructor flushes.
+ *
+ * File format (host byte order): the magic "TRPA" and the format version as
+ * uint32, then for each action: uint32 name length, name, float height,
+ * uint32 corner count, corners as x,y floats, pos_begin and pos_end as
+ * rotation,tx,ty floats, push_begin and push_end as x,y floats. */
+class PushingActionRecorder {
+	public:
+		/// Opens the file for appending. Throws a std::runtime_error on failure.
+		PushingActionRecorder(const std::string &filename, int batch_size=16);
+		~PushingActionRecorder();
+
+		/// Queues the action for writing.
+		void record(const PushingAction &action);
+
+		/// Blocks until all queued actions are written to the file.
+		void flush();
+
+		/// Wakes up the writer thread to write all queued actions and returns immediately.
+		void requestFlush();
+
+		const std::string &getFilename() const { return m_filename; }
+
+		static const unsigned int MAGIC = 0x41505254; // "TRPA"
+		static const unsigned int VERSION = 1;
+
+		/// Appends the binary representation of the action to the buffer.
+		static void serialize(const PushingAction &action, std::vector<char> &buffer);
+
+	private:
+		static void *run(void *self);
+		void writeLoop();
 
+		std::string m_filename;
+		std::ofstream m_out;
+		unsigned int m_batch_size;
+		std::vector<PushingAction> m_queue;
+		/// number of actions taken from the queue but not yet written
+		unsigned int m_writing;
+		bool m_stop;
+		bool m_flush;
+		pthread_t m_thread;
+		pthread_mutex_t m_mutex;
+		pthread_cond_t m_work_cond;
+		pthread_cond_t m_done_cond;
+};
+
+/// Reads pushing actions written by a PushingActionRecorder one by one.
+/** The actions can also be read as PushingSceneInfo records, which can be
+ * passed to the PushingRecorder directly. The properties that are not part
+ * of a recorded action (mass, base length, height, pusher diameter and speed)
+ * are copied from a default PushingSceneInfo. */
+class PushingActionReader {
+	public:
+		/// Opens the file. Throws a std::runtime_error if it is no pushing action file.
+		PushingActionReader(const std::string &filename);
+
+		/// Reads the next action, returns false at the end of the file.
+		bool next(PushingAction &action);
+
+		/// Reads the next action and converts it, returns false at the end of the file.
+		/** The corners of the recorded shape are moved so the centroid is at
+		 * (0,0). Positions are converted from mm to meter. */
+		bool next(PushingSceneInfo &sceneInfo);
+
+		/// Sets the values for properties that are not recorded.
+		void setDefaults(const PushingSceneInfo &defaults) { m_defaults = defaults; }
+
+		/// Converts a recorded action into a PushingSceneInfo.
+		static void convert(const PushingAction &action, const PushingSceneInfo &defaults,
+			PushingSceneInfo &sceneInfo);
+
+		/// Returns the shape type for the shape names used by the TangramClassifier.
+		static Shapes::ShapeType getShapeType(const std::string &name);
+
+	private:
+		std::ifstream m_in;
+		PushingSceneInfo m_defaults;
+};
+
+#endif /* __PUSHING_ACTION_RECORDER_H__ */
@@ -11,42 +11,79 @@ void PushingRecorder::simulate(PushingScene &scene,
 	vector<btRigidBody*> bodies = scene.getBodies();
 	
 	PushingSimulatorDebug *psim_debug = dynamic_cast<PushingSimulatorDebug*>(psim);
+	bool hashing = psim->getStateHashing();
+	if (verify_determinism) psim->setStateHashing(true);
+	DeterminismCheck::HashStream reference_hashes;
 	for (int n=0; n<simsets.repetitions; n++) {
   	scene.init();
 		if (psim_debug) psim_debug->openFileLogStream();
 		psim->simulate(scene.push, bodies, simsets.before_time_s, simsets.after_time_s);
 		if (psim_debug) psim_debug->closeFileLogStream();
 		scene.record();
-	}		
+		if (!verify_determinism) continue;
+		if (n == 0) reference_hashes = psim->getStateHashes();
+		else {
+			int step = DeterminismCheck::findDivergence(reference_hashes, psim->getStateHashes());
+			if (step >= 0) cerr << "WARNING: repetition " << n << " diverges from repetition 0 in step "
+			                    << step << " of " << reference_hashes.size() << endl;
+		}
+	}
+	psim->setStateHashing(hashing);
 }
 
 void PushingRecorder::simulateSingleParameterSetting(PushingScene &scene,
 		btCollisionShape *scaled_shape, btVector3 localInertia, const SimulationSettings &simsets,
-		const PhysicsParameters &params, const PushingSceneInfo &sceneInfo) {
-	const float &scaling = params["world_scaling_factor"];
+		const PhysicsParameters &params, const PushingSceneInfo &sceneInfo,
+		const vector<float> &corners) {
+	scene.push = createPush(params, sceneInfo);
+	scene.clearBodies();
+	scene.pbodies.push_back(createBody(scaled_shape, localInertia, params, sceneInfo, corners));
+	
+	scene.resetStatistics();
+	simulate(scene, params, simsets);
+}
+
+PushMovement PushingRecorder::createPush(const PhysicsParameters &params, const PushingSceneInfo &sceneInfo) {
+	float scaling = params["world_scaling_factor"];
 	float h = scaling*sceneInfo.theight;
+	btVector3 push_begin(sceneInfo.px0*scaling,h*0.25,sceneInfo.py0*scaling);
+	btVector3 push_end(sceneInfo.px1*scaling,h*0.25,sceneInfo.py1*scaling);
+	btVector3 pusher_dims(0.5*sceneInfo.pdiam*scaling,h*3.,0.5*sceneInfo.pdiam*scaling);
+	return PushMovement(push_begin, push_end, pusher_dims, sceneInfo.pspeed*scaling);
+}
+
+PushedBody PushingRecorder::createBody(btCollisionShape *scaled_shape, btVector3 localInertia,
+		const PhysicsParameters &params, const PushingSceneInfo &sceneInfo,
+		const vector<float> &corners) {
+	float scaling = params["world_scaling_factor"];
 	VisionAdapter adapter(scaling);
 	btTransform trans = adapter.to_bullet(
 		Transformation(sceneInfo.trot0, sceneInfo.tx0, sceneInfo.ty0), 
 		sceneInfo.theight*0.5, params["collision_margin"]);
-	btVector3 push_begin(sceneInfo.px0*scaling,h*0.25,sceneInfo.py0*scaling);
-	btVector3 push_end(sceneInfo.px1*scaling,h*0.25,sceneInfo.py1*scaling);
-	btVector3 pusher_dims(0.5*sceneInfo.pdiam*scaling,h*3.,0.5*sceneInfo.pdiam*scaling);
-	
 	btRigidBody *body = createDynamicRigidBody(trans, scaled_shape, sceneInfo.tmass, localInertia);
-	PushedBody pbody(body, PolygonShape(sceneInfo.tcorners), scaling);
-	scene.push = PushMovement(push_begin, push_end, pusher_dims, sceneInfo.pspeed*scaling);
-	scene.clearBodies();
-	scene.pbodies.push_back(pbody);
-	
-	scene.resetStatistics();
-	simulate(scene, params, simsets);
+	return PushedBody(body, PolygonShape(corners), scaling);
 }
 
 
 void PushingRecorder::simulateSingleParameterSetting(PushingScene &scene,
 		const SimulationSettings &simsets, const PhysicsParameters &params,
 		const PushingSceneInfo &sceneInfo, float shapeFactor) {
+	simulateSingleParameterSetting(scene, simsets, params, sceneInfo, sceneInfo.tcorners, shapeFactor);
+}
+
+void PushingRecorder::simulateSingleParameterSetting(PushingScene &scene,
+		const SimulationSettings &simsets, const PhysicsParameters &params,
+		const PushingSceneInfo &sceneInfo, const vector<float> &corners, float shapeFactor) {
+	btVector3 inertia;
+	btCollisionShape *shape = createShape(params, sceneInfo, corners, shapeFactor, inertia);
+	// do the actual simulation
+	simulateSingleParameterSetting(scene, shape, inertia, simsets, params, sceneInfo, corners);
+	delete shape;
+}
+
+btCollisionShape *PushingRecorder::createShape(const PhysicsParameters &params,
+		const PushingSceneInfo &sceneInfo, const vector<float> &corners,
+		float shapeFactor, btVector3 &inertia) {
 	// init helper variables
 	float scaling = params["world_scaling_factor"];
 	float h = scaling*sceneInfo.theight;
@@ -55,11 +92,11 @@ void PushingRecorder::simulateSingleParameterSetting(PushingScene &scene,
 
 	// create collision shape
 	btCollisionShape *shape = Shapes::createFlatObject(
-		sceneInfo.tcorners, scaling, h, shapeFactor);
+		corners, scaling, h, shapeFactor);
 	
 	// calculate inertia
 	shape->setMargin(margin);
-	btVector3 inertia(0,0,0);
+	inertia.setValue(0,0,0);
 	if (params["use_custom_inertia_tensor"]) {
 		inertia = Shapes::getInertiaTensor(sceneInfo.ttype, l+2*margin, h+margin, sceneInfo.tmass);
 	} else {	
@@ -71,24 +108,51 @@ void PushingRecorder::simulateSingleParameterSetting(PushingScene &scene,
 	  shape->calculateLocalInertia(sceneInfo.tmass, inertia);
 	}
   inertia *= params["inertia_scaling"];
-	
-	// do the actual simulation
-	simulateSingleParameterSetting(scene, shape, inertia, simsets, params, sceneInfo);
-	delete shape;
+	return shape;
+}
+
+float PushingRecorder::getShapeFactor(const PhysicsParameters &params, Shapes::ShapeType type) {
+	if (!params["use_modified_shape"]) return 1;
+	float sf = params["fixed_shape_factor"];
+	if (sf > 0) return sf;
+	return Shapes::getCorrectShapeFactor(type);
 }
 
 void PushingRecorder::simulateSingleParameterSetting(
 		PushingScene &scene, const SimulationSettings &simsets,
 		const PhysicsParameters &params, const PushingSceneInfo &sceneInfo) {
-	float shapeFactor = 1;
-	if (params["use_modified_shape"]) {
-		float sf = params["fixed_shape_factor"];
-		if (sf > 0) shapeFactor = sf;
-		else shapeFactor = Shapes::getCorrectShapeFactor(sceneInfo.ttype);
-	}
-	simulateSingleParameterSetting(scene, simsets, params, sceneInfo, shapeFactor);
+	simulateSingleParameterSetting(scene, simsets, params, sceneInfo,
+		getShapeFactor(params, sceneInfo.ttype));
+}
+
+void PushingRecorder::simulateSingleParameterSetting(
+		PushingScene &scene, const SimulationSettings &simsets,
+		const PhysicsParameters &params, const SceneView &scenes, int i) {
+	PushingSceneInfo sceneInfo;
+	scenes.getBatch().get(scenes[i], sceneInfo, false);
+	simulateSingleParameterSetting(scene, simsets, params, sceneInfo, scenes.getCorners(i),
+		getShapeFactor(params, sceneInfo.ttype));
 }
 		
+void PushingRecorder::simulateMultipleBodies(PushingScene &scene,
+		const SimulationSettings &simsets, const PhysicsParameters &params,
+		const SceneView &scenes) {
+	scene.clearBodies();
+	vector<btCollisionShape*> shapes;
+	PushingSceneInfo sceneInfo;
+	for (int i=0; i<scenes.size(); i++) {
+		scenes.getBatch().get(scenes[i], sceneInfo, false);
+		if (i == 0) scene.push = createPush(params, sceneInfo);
+		btVector3 inertia;
+		shapes.push_back(createShape(params, sceneInfo, scenes.getCorners(i),
+			getShapeFactor(params, sceneInfo.ttype), inertia));
+		scene.pbodies.push_back(createBody(shapes.back(), inertia, params, sceneInfo, scenes.getCorners(i)));
+	}
+	scene.resetStatistics();
+	simulate(scene, params, simsets);
+	for (unsigned int i=0; i<shapes.size(); i++) delete shapes[i];
+}
+
 void PushingRecorder::writeDataset(ostream &out,
 		const SimulationSettings &simsets, const PhysicsParameters &params_const,
 		const PushingSceneInfo &sceneInfo, Transformation reference_t, bool writeHeader) {
@@ -99,6 +163,7 @@ void PushingRecorder::writeDataset(ostream &out,
 		simulateSingleParameterSetting(scene, simsets, params, sceneInfo);
 		scene.calcStatistics(reference_t);
 		scene.writeStatistics(out, params);
+		storeResults(scene, simsets, params, sceneInfo);
 	} else { // a parameter to vary
 		for (int i=0; i<simsets.steps; i++) {
 			float value = simsets.getValue(i);
@@ -106,10 +171,38 @@ void PushingRecorder::writeDataset(ostream &out,
 			simulateSingleParameterSetting(scene, simsets, params, sceneInfo);
 			scene.calcStatistics(reference_t);
 			scene.writeStatistics(out, params);
+			storeResults(scene, simsets, params, sceneInfo);
 		}
 	}
 }
 
+void PushingRecorder::storeResults(const PushingScene &scene, const SimulationSettings &simsets,
+		const PhysicsParameters &params, const PushingSceneInfo &sceneInfo) {
+	storeResults(scene, simsets, params, sceneInfo, sceneInfo.tcorners);
+}
+
+void PushingRecorder::storeResults(const PushingScene &scene, const SimulationSettings &simsets,
+		const PhysicsParameters &params, const SceneView &scenes, int i) {
+	if (!store) return;
+	PushingSceneInfo sceneInfo;
+	scenes.getBatch().get(scenes[i], sceneInfo, false);
+	storeResults(scene, simsets, params, sceneInfo, scenes.getCorners(i));
+}
+
+void PushingRecorder::storeResults(const PushingScene &scene, const SimulationSettings &simsets,
+		const PhysicsParameters &params, const PushingSceneInfo &sceneInfo,
+		const vector<float> &corners) {
+	if (!store) return;
+	ResultRecord r;
+	r.scene_id = ResultStore::sceneId(sceneInfo, corners);
+	r.params_hash = ResultStore::paramsHash(params);
+	r.settings_hash = ResultStore::settingsHash(simsets);
+	for (unsigned int i=0; i<scene.pbodies.size(); i++) {
+		r.setResults(scene.pbodies[i]);
+		store->append(r);
+	}
+}
+
 btRigidBody* PushingRecorder::createDynamicRigidBody(btTransform transform,
 		btCollisionShape* shape, float mass, btVector3 localInertia) {
   btDefaultMotionState* motionState = new btDefaultMotionState(transform);
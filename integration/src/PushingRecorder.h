@@ -7,9 +7,13 @@
 #include <PushMovement.h>
 #include <PushingScene.h>
 #include <PushingSimulator.h>
+#include <DeterminismCheck.h>
+#include <PushingSceneInfo.h>
+#include <ResultStore.h>
+#include <SceneBatch.h>
 #include <stdexcept>
 
-std::vector<float> &operator<<(std::vector<float>& vec, float value) {
+inline std::vector<float> &operator<<(std::vector<float>& vec, float value) {
 	vec.push_back(value);
 	return vec;
 }
@@ -65,48 +69,39 @@ struct SimulationSettings {
 	}
 };
 
-/// All values in meter / radiants / kg
-struct PushingSceneInfo {
-  float tx0, ty0, trot0; // tangram start pos
-  float tx1, ty1, trot1; // tangram end pos
-  float tmass; // tragram mass
-  float tlength; // base length of tangram
-  float theight; // height of tangram
-  Shapes::ShapeType ttype; // tangram shape type
-  std::vector<float> tcorners; // tangram corners [x0,y0,x1,y1,...]
-  float px0, py0; // pusher start pos
-  float px1, py1; // pusher end pos
-  float pdiam; // pusher diameter
-  float pspeed; // pusher speed in m/s
-  
-  PushingSceneInfo(float tx0, float ty0, float trot0,
-  								 float tmass, float tlength, float theight,
-  								 Shapes::ShapeType ttype, std::vector<float> tcorners,
-              		 float px0, float py0, float px1, float py1, float pdiam, float pspeed):
-      tx0(tx0), ty0(ty0), trot0(trot0), tx1(tx0), ty1(ty0), trot1(trot0),
-      tmass(tmass), tlength(tlength), theight(theight), ttype(ttype), tcorners(tcorners),
-      px0(px0), py0(py0), px1(px1), py1(py1), pdiam(pdiam), pspeed(pspeed) {}
-      
-  PushingSceneInfo() {}
-  
-  void setTangramPos(float x0, float y0, float rot0, float x1, float y1, float rot1) {
-  	tx0 = x0; ty0 = y0;
-  	trot0 = rot0;
-  	tx1 = x1; ty1 = y1;
-  	trot1 = rot1;
-  }
-  
-  void setPusherPos(float x0, float y0, float x1, float y1) {
-	  px0 = x0; py0 = y0;
-  	px1 = x1; py1 = y1;
-  }
-};
-
-std::ostream &operator<<(std::ostream &out, const PushingSceneInfo &si);
 
 class PushingRecorder {
 	public:
-		PushingRecorder(PushingSimulator *psim): psim(psim) {}
+		PushingRecorder(PushingSimulator *psim): psim(psim), store(NULL) {
+#ifdef TANGRAM_VERIFY_DETERMINISM
+			verify_determinism = true;
+#else
+			verify_determinism = false;
+#endif
+		}
+
+		/// If switched on, all repetitions of a simulation are checked to yield identical results.
+		/** The state hashes of each step of each repetition are compared with
+		 * those of the first repetition and a warning is printed to std::cerr
+		 * at the first divergent step. Switched on by default in debug builds,
+		 * which define TANGRAM_VERIFY_DETERMINISM. */
+		void setVerifyDeterminism(bool value) { verify_determinism = value; }
+		bool getVerifyDeterminism() const { return verify_determinism; }
+
+		/// If a store is set, writeDataset() appends all its results to it.
+		/** The store is not owned by the PushingRecorder. Pass NULL to switch off. */
+		void setResultStore(ResultStore *value) { store = value; }
+		ResultStore *getResultStore() { return store; }
+
+		/// Appends the statistics of all bodies in the scene to the result store.
+		/** Call scene.calcStatistics() before. Does nothing if no store was set. */
+		void storeResults(const PushingScene &scene, const SimulationSettings &simsets,
+			const PhysicsParameters &params, const PushingSceneInfo &sceneInfo);
+
+		/// Appends the statistics of all bodies in the scene to the result store.
+		/** The scene must have been simulated for the i-th scene of the view. */
+		void storeResults(const PushingScene &scene, const SimulationSettings &simsets,
+			const PhysicsParameters &params, const SceneView &scenes, int i);
 		
 		void simulate(PushingScene &scene, const PhysicsParameters &params,
 			const SimulationSettings &simsets);
@@ -122,6 +117,20 @@ class PushingRecorder {
 		void simulateSingleParameterSetting(PushingScene &scene,
 			const SimulationSettings &simsets, const PhysicsParameters &params_const,
 			const PushingSceneInfo &sceneInfo, float ShapeFactor);
+
+		/// Runs a simulation of the i-th scene of the view.
+		/** The shape corners are read directly from the shape table of the batch. */
+		void simulateSingleParameterSetting(PushingScene &scene,
+			const SimulationSettings &simsets, const PhysicsParameters &params_const,
+			const SceneView &scenes, int i);
+
+		/// Runs a simulation with the tangrams of all scenes of the view in one scene.
+		/** Each tangram is placed at the start position of its scene, they
+		 * should not overlap. The pusher of the first scene is used. Removes
+		 * all former bodies from the pushing scene. */
+		void simulateMultipleBodies(PushingScene &scene,
+			const SimulationSettings &simsets, const PhysicsParameters &params,
+			const SceneView &scenes);
 		
 		/// Runs simulations for all parameter settings described in simsets and writes the results to out.
 		/** As reference transformation the resulting mean transformation of a trial
@@ -133,15 +142,44 @@ class PushingRecorder {
 			const PushingSceneInfo &sceneInfo, Transformation reference_t, bool writeHeader=true);
 
 	protected:
+		/// The tangram corners are passed separately, sceneInfo.tcorners is not used.
+		void simulateSingleParameterSetting(PushingScene &scene,
+			const SimulationSettings &simsets, const PhysicsParameters &params_const,
+			const PushingSceneInfo &sceneInfo, const std::vector<float> &corners, float shapeFactor);
+
 		void simulateSingleParameterSetting(PushingScene &scene, btCollisionShape *scaled_shape,
 			btVector3 localInertia,	const SimulationSettings &simsets,
-			const PhysicsParameters &params_const, const PushingSceneInfo &sceneInfo);
+			const PhysicsParameters &params_const, const PushingSceneInfo &sceneInfo,
+			const std::vector<float> &corners);
+
+		void storeResults(const PushingScene &scene, const SimulationSettings &simsets,
+			const PhysicsParameters &params, const PushingSceneInfo &sceneInfo,
+			const std::vector<float> &corners);
+
+		/// Shape factor set in the parameters or the correct one for the shape type.
+		static float getShapeFactor(const PhysicsParameters &params, Shapes::ShapeType type);
+
+		/// Creates the scaled collision shape of a tangram and calculates its inertia.
+		/** The caller must delete the shape after the simulation. */
+		static btCollisionShape *createShape(const PhysicsParameters &params,
+			const PushingSceneInfo &sceneInfo, const std::vector<float> &corners,
+			float shapeFactor, btVector3 &inertia);
+
+		/// Creates the body of a tangram at its start position in the scene.
+		PushedBody createBody(btCollisionShape *scaled_shape, btVector3 localInertia,
+			const PhysicsParameters &params, const PushingSceneInfo &sceneInfo,
+			const std::vector<float> &corners);
+
+		/// Pusher movement of the scene in scaled world coordinates.
+		static PushMovement createPush(const PhysicsParameters &params, const PushingSceneInfo &sceneInfo);
 			
 		btRigidBody* createDynamicRigidBody(btTransform transform,
 			btCollisionShape* shape, float mass, btVector3 localInertia);
 
 	private:
 		PushingSimulator *psim;
+		bool verify_determinism;
+		ResultStore *store;
 };
 
 #endif /* __PUHSING_RECORDER_WEITNAU_H__ */
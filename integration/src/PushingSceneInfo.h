@@ -0,0 +1,48 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __PUSHING_SCENE_INFO_EWEITNAU_H__
+#define __PUSHING_SCENE_INFO_EWEITNAU_H__
+
+#include <iostream>
+#include <vector>
+#include <Shapes.h>
+
+/// All values in meter / radiants / kg
+struct PushingSceneInfo {
+  float tx0, ty0, trot0; // tangram start pos
+  float tx1, ty1, trot1; // tangram end pos
+  float tmass; // tragram mass
+  float tlength; // base length of tangram
+  float theight; // height of tangram
+  Shapes::ShapeType ttype; // tangram shape type
+  std::vector<float> tcorners; // tangram corners [x0,y0,x1,y1,...]
+  float px0, py0; // pusher start pos
+  float px1, py1; // pusher end pos
+  float pdiam; // pusher diameter
+  float pspeed; // pusher speed in m/s
+  
+  PushingSceneInfo(float tx0, float ty0, float trot0,
+  								 float tmass, float tlength, float theight,
+  								 Shapes::ShapeType ttype, std::vector<float> tcorners,
+              		 float px0, float py0, float px1, float py1, float pdiam, float pspeed):
+      tx0(tx0), ty0(ty0), trot0(trot0), tx1(tx0), ty1(ty0), trot1(trot0),
+      tmass(tmass), tlength(tlength), theight(theight), ttype(ttype), tcorners(tcorners),
+      px0(px0), py0(py0), px1(px1), py1(py1), pdiam(pdiam), pspeed(pspeed) {}
+      
+  PushingSceneInfo() {}
+  
+  void setTangramPos(float x0, float y0, float rot0, float x1, float y1, float rot1) {
+  	tx0 = x0; ty0 = y0;
+  	trot0 = rot0;
+  	tx1 = x1; ty1 = y1;
+  	trot1 = rot1;
+  }
+  
+  void setPusherPos(float x0, float y0, float x1, float y1) {
+	  px0 = x0; py0 = y0;
+  	px1 = x1; py1 = y1;
+  }
+};
+
+std::ostream &operator<<(std::ostream &out, const PushingSceneInfo &si);
+
+#endif /* __PUSHING_SCENE_INFO_EWEITNAU_H__ */
@@ -0,0 +1,276 @@
+// Copyright 2009 Erik Weitnauer
+#include <ResultStore.h>
+#include <PushingRecorder.h>
+#include <PushedBody.h>
+#include <stdexcept>
+#include <cstring>
+#include <ctime>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+using namespace std;
+using namespace icl;
+
+namespace {
+	const unsigned int RECORD_MAGIC = 0x31525254; // "TRR1"
+	const unsigned int MAX_PAYLOAD = 1 << 20;
+	const unsigned int FRAME_HEAD = 2*sizeof(unsigned int);
+	const unsigned int FRAME_TAIL = sizeof(unsigned int);
+	/// reads of a refresh, if the last frame was cut off while others kept appending
+	const int MAX_READ_ATTEMPTS = 3;
+
+	template<class T> void put(vector<char> &buffer, const T &value) {
+		const char *p = reinterpret_cast<const char*>(&value);
+		buffer.insert(buffer.end(), p, p+sizeof(T));
+	}
+
+	void put(vector<char> &buffer, const Transformation &t) {
+		put(buffer, t.getRotation()); put(buffer, t.getTx()); put(buffer, t.getTy());
+	}
+
+	template<class T> bool get(const char *&p, const char *end, T &value) {
+		if (p+sizeof(T) > end) return false;
+		memcpy(&value, p, sizeof(T));
+		p += sizeof(T);
+		return true;
+	}
+
+	bool get(const char *&p, const char *end, Transformation &t) {
+		float rot, tx, ty;
+		if (!get(p,end,rot) || !get(p,end,tx) || !get(p,end,ty)) return false;
+		t = Transformation(rot, tx, ty);
+		return true;
+	}
+
+	unsigned int checksum(const char *data, unsigned int length) {
+		StateHash hash;
+		hash.add(data, length);
+		return (unsigned int)hash.value();
+	}
+}
+
+void ResultRecord::setResults(const PushedBody &body) {
+	start = body.getStartPosition();
+	mean_delta = body.getMeanDelta();
+	min_delta = body.getMinDelta();
+	max_delta = body.getMaxDelta();
+	variance = body.getVariance();
+	ref_distance = body.getDistanceToReference();
+	start_end_distance = body.getStartToEndDistance();
+	end_deltas.clear();
+	for (int i=0; i<body.getNumberOfEndPositions(); i++) end_deltas.push_back(body.getEndDelta(i));
+}
+
+ResultStore::ResultStore(const string &filename): m_filename(filename), m_offset(0) {
+	m_fd = open(filename.c_str(), O_RDWR | O_APPEND | O_CREAT, 0644);
+	if (m_fd < 0) throw runtime_error("ResultStore: could not open " + filename);
+	refreshUnlocked();
+}
+
+ResultStore::~ResultStore() {
+	close(m_fd);
+}
+
+void ResultStore::append(const ResultRecord &record) {
+	ResultRecord r = record;
+	r.timestamp = time(NULL);
+	vector<char> payload;
+	serialize(r, payload);
+	vector<char> frame;
+	put(frame, RECORD_MAGIC);
+	put(frame, (unsigned int)payload.size());
+	frame.insert(frame.end(), payload.begin(), payload.end());
+	put(frame, checksum(&payload[0], payload.size()));
+
+	Mutex::Locker l(m_mutex);
+	flock(m_fd, LOCK_EX);
+	unsigned int written = 0;
+	while (written < frame.size()) {
+		ssize_t n = write(m_fd, &frame[written], frame.size()-written);
+		if (n <= 0) break;
+		written += n;
+	}
+	flock(m_fd, LOCK_UN);
+	if (written < frame.size()) throw runtime_error("ResultStore: could not write to " + m_filename);
+	refreshUnlocked();
+}
+
+void ResultStore::refresh() {
+	Mutex::Locker l(m_mutex);
+	refreshUnlocked();
+}
+
+void ResultStore::refreshUnlocked() {
+	// if the last frame is incomplete, read again as long as the file grows
+	long long end = -1;
+	for (int attempt=0; attempt<MAX_READ_ATTEMPTS; attempt++) {
+		vector<char> data;
+		long long new_end = readNewData(data);
+		if (new_end == end) break;
+		end = new_end;
+		if (!parseFrames(data)) break;
+	}
+}
+
+long long ResultStore::readNewData(vector<char> &data) {
+	flock(m_fd, LOCK_SH);
+	struct stat st;
+	unsigned int read_bytes = 0;
+	if (fstat(m_fd, &st) == 0 && st.st_size > m_offset) {
+		data.resize(st.st_size - m_offset);
+		while (read_bytes < data.size()) {
+			ssize_t n = pread(m_fd, &data[read_bytes], data.size()-read_bytes, m_offset+read_bytes);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) break;
+			read_bytes += n;
+		}
+	}
+	flock(m_fd, LOCK_UN);
+	data.resize(read_bytes);
+	return m_offset + read_bytes;
+}
+
+bool ResultStore::parseFrames(const vector<char> &data) {
+	// parse all complete frames, skip over corrupted ones
+	bool incomplete = false;
+	unsigned int pos = 0;
+	while (pos + FRAME_HEAD <= data.size()) {
+		unsigned int magic, length, sum;
+		memcpy(&magic, &data[pos], sizeof(magic));
+		memcpy(&length, &data[pos+sizeof(magic)], sizeof(length));
+		if (magic != RECORD_MAGIC || length > MAX_PAYLOAD) { pos++; continue; }
+		if (pos + FRAME_HEAD + length + FRAME_TAIL > data.size()) { incomplete = true; break; }
+		const char *payload = &data[pos+FRAME_HEAD];
+		memcpy(&sum, payload+length, sizeof(sum));
+		ResultRecord r;
+		if (sum != checksum(payload, length) || !deserialize(payload, length, r)) { pos++; continue; }
+		m_records.push_back(r);
+		addToIndex(r);
+		pos += FRAME_HEAD + length + FRAME_TAIL;
+	}
+	m_offset += pos;
+	return incomplete;
+}
+
+int ResultStore::size() {
+	Mutex::Locker l(m_mutex);
+	refreshUnlocked();
+	return m_records.size();
+}
+
+void ResultStore::addToIndex(const ResultRecord &r) {
+	int idx = m_records.size()-1;
+	m_scene_index[r.scene_id].push_back(idx);
+	m_params_index[r.params_hash].push_back(idx);
+	m_settings_index[r.settings_hash].push_back(idx);
+}
+
+const vector<int> *ResultStore::candidates(const Query &query, bool &empty) const {
+	const vector<int> *best = NULL;
+	const Index *indices[3] = { &m_scene_index, &m_params_index, &m_settings_index };
+	const bool used[3] = { query.m_use_scene, query.m_use_params, query.m_use_settings };
+	const key_type keys[3] = { query.m_scene, query.m_params, query.m_settings };
+	empty = false;
+	for (int i=0; i<3; i++) {
+		if (!used[i]) continue;
+		Index::const_iterator it = indices[i]->find(keys[i]);
+		if (it == indices[i]->end()) { empty = true; return NULL; }
+		if (!best || it->second.size() < best->size()) best = &it->second;
+	}
+	return best;
+}
+
+void ResultStore::find(const Query &query, vector<ResultRecord> &result) {
+	Mutex::Locker l(m_mutex);
+	refreshUnlocked();
+	bool empty;
+	const vector<int> *cands = candidates(query, empty);
+	if (empty) return;
+	if (!cands) {
+		result.insert(result.end(), m_records.begin(), m_records.end());
+		return;
+	}
+	for (unsigned int i=0; i<cands->size(); i++) {
+		const ResultRecord &r = m_records[(*cands)[i]];
+		if (query.matches(r)) result.push_back(r);
+	}
+}
+
+bool ResultStore::findLatest(const Query &query, ResultRecord &result) {
+	Mutex::Locker l(m_mutex);
+	refreshUnlocked();
+	bool empty;
+	const vector<int> *cands = candidates(query, empty);
+	if (empty) return false;
+	if (!cands) {
+		if (m_records.empty()) return false;
+		result = m_records.back();
+		return true;
+	}
+	for (int i=cands->size()-1; i>=0; i--) {
+		const ResultRecord &r = m_records[(*cands)[i]];
+		if (query.matches(r)) { result = r; return true; }
+	}
+	return false;
+}
+
+ResultStore::key_type ResultStore::sceneId(const PushingSceneInfo &si) {
+	return sceneId(si, si.tcorners);
+}
+
+ResultStore::key_type ResultStore::sceneId(const PushingSceneInfo &si, const vector<float> &corners) {
+	StateHash hash;
+	hash.add(si.tx0); hash.add(si.ty0); hash.add(si.trot0);
+	hash.add(si.tx1); hash.add(si.ty1); hash.add(si.trot1);
+	hash.add(si.tmass); hash.add(si.tlength); hash.add(si.theight);
+	int type = si.ttype;
+	hash.add(&type, sizeof(type));
+	for (unsigned int i=0; i<corners.size(); i++) hash.add(corners[i]);
+	hash.add(si.px0); hash.add(si.py0); hash.add(si.px1); hash.add(si.py1);
+	hash.add(si.pdiam); hash.add(si.pspeed);
+	return hash.value();
+}
+
+ResultStore::key_type ResultStore::paramsHash(const PhysicsParameters &params) {
+	StateHash hash;
+	for (PhysicsParameters::const_iterator it = params.begin(); it != params.end(); ++it) {
+		hash.add(it->first.c_str(), it->first.size()+1);
+		hash.add(it->second);
+	}
+	return hash.value();
+}
+
+ResultStore::key_type ResultStore::settingsHash(const SimulationSettings &simsets) {
+	StateHash hash;
+	hash.add(&simsets.repetitions, sizeof(simsets.repetitions));
+	hash.add(simsets.before_time_s);
+	hash.add(simsets.after_time_s);
+	return hash.value();
+}
+
+void ResultStore::serialize(const ResultRecord &r, vector<char> &buffer) {
+	put(buffer, r.scene_id); put(buffer, r.params_hash); put(buffer, r.settings_hash);
+	put(buffer, r.timestamp);
+	put(buffer, r.start);
+	put(buffer, r.mean_delta); put(buffer, r.min_delta); put(buffer, r.max_delta);
+	put(buffer, r.variance); put(buffer, r.ref_distance); put(buffer, r.start_end_distance);
+	put(buffer, (unsigned int)r.end_deltas.size());
+	for (unsigned int i=0; i<r.end_deltas.size(); i++) put(buffer, r.end_deltas[i]);
+}
+
+bool ResultStore::deserialize(const char *data, unsigned int length, ResultRecord &r) {
+	const char *p = data, *end = data+length;
+	unsigned int n;
+	if (!(get(p,end,r.scene_id) && get(p,end,r.params_hash) && get(p,end,r.settings_hash) &&
+	      get(p,end,r.timestamp) && get(p,end,r.start) &&
+	      get(p,end,r.mean_delta) && get(p,end,r.min_delta) && get(p,end,r.max_delta) &&
+	      get(p,end,r.variance) && get(p,end,r.ref_distance) && get(p,end,r.start_end_distance) &&
+	      get(p,end,n))) return false;
+	if (n > length/(3*sizeof(float))) return false;
+	r.end_deltas.resize(n);
+	for (unsigned int i=0; i<n; i++) if (!get(p,end,r.end_deltas[i])) return false;
+	return p == end;
+}
@@ -0,0 +1,148 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __RESULT_STORE_EWEITNAU_H__
+#define __RESULT_STORE_EWEITNAU_H__
+
+#include <map>
+#include <string>
+#include <vector>
+#include <ICLUtils/Mutex.h>
+#include <StateHash.h>
+#include <PhysicsParameters.h>
+#include <transformation.h>
+
+class PushedBody;
+struct PushingSceneInfo;
+struct SimulationSettings;
+
+/// Outcome of the simulation of one body in one pushing scene.
+/** All transformations are in vision coordinates (meters / radiants) and are
+ * the deltas between start and end position like in PushedBody. */
+struct ResultRecord {
+	typedef StateHash::value_type key_type;
+
+	ResultRecord(): scene_id(0), params_hash(0), settings_hash(0), timestamp(0),
+		variance(0), ref_distance(0), start_end_distance(0) {}
+
+	/// Copies start position, all end positions and the statistics from the body.
+	/** Call PushedBody::calcStatistics() before. */
+	void setResults(const PushedBody &body);
+
+	key_type scene_id;
+	key_type params_hash;
+	key_type settings_hash;
+	/// seconds since epoch of when the record was appended
+	long long timestamp;
+
+	Transformation start;
+	Transformation mean_delta;
+	Transformation min_delta;
+	Transformation max_delta;
+	float variance;
+	float ref_distance;
+	float start_end_distance;
+	/// delta transformation of each repetition
+	std::vector<Transformation> end_deltas;
+};
+
+/// Embedded, append-only store for simulation results.
+/** The records are appended to a single binary file. Each record is framed by
+ * a magic number, its length and a checksum, so a record that was only
+ * partially written (e.g. because a process crashed) is skipped when reading.
+ * The file is written in host byte order.
+ *
+ * Several threads may share one ResultStore and several processes may open
+ * the same file at the same time: each record is written with a single
+ * write() call while holding an exclusive flock() on the file. Records
+ * appended by other processes become visible on the next refresh(), which is
+ * called automatically by all query methods.
+ *
+ * All records are kept in memory and indexed by each of the three key
+ * components (scene id, parameter hash, settings hash).
+ *
+ * Usage:
+ *   ResultStore store("./data/pushing_sim/results.store");
+ *   std::vector<ResultRecord> rs;
+ *   store.find(ResultStore::Query().scene(ResultStore::sceneId(si)).params(ResultStore::paramsHash(params)), rs);
+ */
+class ResultStore {
+public:
+	typedef ResultRecord::key_type key_type;
+
+	/// Selects records by any combination of the key components.
+	/** Key components that are not set match every record. */
+	class Query {
+	public:
+		Query(): m_use_scene(false), m_use_params(false), m_use_settings(false) {}
+		Query &scene(key_type id) { m_scene = id; m_use_scene = true; return *this; }
+		Query &params(key_type hash) { m_params = hash; m_use_params = true; return *this; }
+		Query &settings(key_type hash) { m_settings = hash; m_use_settings = true; return *this; }
+		bool matches(const ResultRecord &r) const {
+			return (!m_use_scene || r.scene_id == m_scene) &&
+			       (!m_use_params || r.params_hash == m_params) &&
+			       (!m_use_settings || r.settings_hash == m_settings);
+		}
+	private:
+		friend class ResultStore;
+		key_type m_scene, m_params, m_settings;
+		bool m_use_scene, m_use_params, m_use_settings;
+	};
+
+	/// Opens or creates the store file. Throws a std::runtime_error on failure.
+	ResultStore(const std::string &filename);
+	~ResultStore();
+
+	/// Appends the record to the file. The timestamp is set automatically.
+	void append(const ResultRecord &record);
+
+	/// Reads the records appended by other processes since the last refresh.
+	void refresh();
+
+	/// Number of records read so far.
+	int size();
+
+	/// Appends all records matching the query to 'result' in the order they were stored.
+	void find(const Query &query, std::vector<ResultRecord> &result);
+
+	/// Returns true and writes the most recently stored matching record into 'result' if there is one.
+	bool findLatest(const Query &query, ResultRecord &result);
+
+	/// Hash over all start and end positions, the tangram and the pusher properties.
+	static key_type sceneId(const PushingSceneInfo &si);
+	/// Same as above, but uses the passed corners instead of si.tcorners.
+	static key_type sceneId(const PushingSceneInfo &si, const std::vector<float> &corners);
+	/// Hash over the names and values of all parameters.
+	static key_type paramsHash(const PhysicsParameters &params);
+	/// Hash over the repetitions and the before and after simulation times.
+	static key_type settingsHash(const SimulationSettings &simsets);
+
+	const std::string &getFilename() const { return m_filename; }
+
+private:
+	typedef std::map<key_type, std::vector<int> > Index;
+
+	void refreshUnlocked();
+	/// Reads the file from m_offset to its end while holding a shared lock.
+	/** Returns the file offset up to which was read. */
+	long long readNewData(std::vector<char> &data);
+	/// Adds the complete, valid frames at the start of data and advances m_offset past them.
+	/** Returns true if it stopped at a frame that is cut off at the end of data. */
+	bool parseFrames(const std::vector<char> &data);
+	void addToIndex(const ResultRecord &r);
+	/// Returns the smallest candidate list for the query or NULL if all records are candidates.
+	const std::vector<int> *candidates(const Query &query, bool &empty) const;
+	static void serialize(const ResultRecord &r, std::vector<char> &buffer);
+	/// Returns false if the payload is malformed.
+	static bool deserialize(const char *data, unsigned int length, ResultRecord &r);
+
+	std::string m_filename;
+	int m_fd;
+	/// number of bytes of the file already parsed
+	long long m_offset;
+	std::vector<ResultRecord> m_records;
+	Index m_scene_index;
+	Index m_params_index;
+	Index m_settings_index;
+	icl::Mutex m_mutex;
+};
+
+#endif /* __RESULT_STORE_EWEITNAU_H__ */
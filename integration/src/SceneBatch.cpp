@@ -0,0 +1,106 @@
+// Copyright 2009 Erik Weitnauer
+#include <SceneBatch.h>
+#include <PushingActionRecorder.h>
+#include <ICLUtils/StringUtils.h>
+#include <fstream>
+
+using namespace std;
+
+int ShapeTable::add(Shapes::ShapeType type, const vector<float> &corners) {
+	Key key((int)type, corners);
+	map<Key, int>::const_iterator it = m_ids.find(key);
+	if (it != m_ids.end()) return it->second;
+	int id = m_types.size();
+	m_types.push_back(type);
+	m_corners.push_back(corners);
+	m_ids[key] = id;
+	return id;
+}
+
+int SceneBatch::add(const PushingSceneInfo &si) {
+	tx0.push_back(si.tx0); ty0.push_back(si.ty0); trot0.push_back(si.trot0);
+	tx1.push_back(si.tx1); ty1.push_back(si.ty1); trot1.push_back(si.trot1);
+	tmass.push_back(si.tmass); tlength.push_back(si.tlength); theight.push_back(si.theight);
+	shape_id.push_back(shapes.add(si.ttype, si.tcorners));
+	px0.push_back(si.px0); py0.push_back(si.py0);
+	px1.push_back(si.px1); py1.push_back(si.py1);
+	pdiam.push_back(si.pdiam); pspeed.push_back(si.pspeed);
+	return size()-1;
+}
+
+void SceneBatch::get(int i, PushingSceneInfo &si, bool with_corners) const {
+	si.setTangramPos(tx0[i], ty0[i], trot0[i], tx1[i], ty1[i], trot1[i]);
+	si.tmass = tmass[i]; si.tlength = tlength[i]; si.theight = theight[i];
+	si.ttype = getType(i);
+	if (with_corners) si.tcorners = getCorners(i);
+	si.setPusherPos(px0[i], py0[i], px1[i], py1[i]);
+	si.pdiam = pdiam[i]; si.pspeed = pspeed[i];
+}
+
+int SceneBatch::loadClosedLoopData(const string &filename, Shapes::ShapeType type,
+		const PushingSceneInfo &defaults) {
+	ifstream f(filename.c_str());
+	string line;
+	getline(f, line); // first line has column names
+	PushingSceneInfo si = defaults;
+	si.ttype = type;
+	si.tcorners = Shapes::getCorners(type, defaults.tlength);
+	int counter = 0;
+	while (f.good()) {
+		getline(f, line);
+		vector<float> v = icl::parseVecStr<float>(line, " ");
+		if (v.size() != 10) continue;
+		// file data columns: tx0 ty0 trot0 ax0 ay0 ax1 ay1 tx1 ty1 trot1
+		si.setTangramPos(v[0]/100,v[1]/100,v[2]/180*M_PI,v[7]/100,v[8]/100,v[9]/180*M_PI);
+		si.setPusherPos(v[3]/100,v[4]/100,v[5]/100,v[6]/100);
+		add(si);
+		counter++;
+	}
+	f.close();
+	return counter;
+}
+
+int SceneBatch::loadRecordedActions(const string &filename, const PushingSceneInfo &defaults) {
+	PushingActionReader reader(filename);
+	reader.setDefaults(defaults);
+	int counter = 0;
+	PushingSceneInfo si;
+	while (reader.next(si)) {
+		add(si);
+		counter++;
+	}
+	return counter;
+}
+
+int SceneBatch::load(const string &filename, Shapes::ShapeType type, const PushingSceneInfo &defaults) {
+	if (filename.size() > 4 && filename.substr(filename.size()-4) == ".dat")
+		return loadRecordedActions(filename, defaults);
+	return loadClosedLoopData(filename, type, defaults);
+}
+
+SceneView::SceneView(const SceneBatch &batch): m_batch(&batch), m_indices(batch.size()) {
+	for (int i=0; i<batch.size(); i++) m_indices[i] = i;
+}
+
+SceneView SceneView::slice(int begin, int end) const {
+	return SceneView(*m_batch, vector<int>(m_indices.begin()+begin, m_indices.begin()+end));
+}
+
+SceneView SceneView::selectPushOffsets(const vector<float> &offsets_in_cm) const {
+	vector<int> indices;
+	for (int i=0; i<size(); i++) {
+		float offset = 100*m_batch->getPushOffset(m_indices[i]);
+		for (unsigned int j=0; j<offsets_in_cm.size(); j++) {
+			if (offsets_in_cm[j]-0.5 < offset && offsets_in_cm[j]+0.5 > offset) {
+				indices.push_back(m_indices[i]); break;
+			}
+		}
+	}
+	return SceneView(*m_batch, indices);
+}
+
+SceneView SceneView::select(bool (*keep)(const SceneBatch &batch, int i)) const {
+	vector<int> indices;
+	for (int i=0; i<size(); i++) if (keep(*m_batch, m_indices[i])) indices.push_back(m_indices[i]);
+	return SceneView(*m_batch, indices);
+}
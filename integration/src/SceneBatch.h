@@ -0,0 +1,120 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __SCENE_BATCH_EWEITNAU_H__
+#define __SCENE_BATCH_EWEITNAU_H__
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <Shapes.h>
+#include <transformation.h>
+#include <PushingSceneInfo.h>
+
+/// Table of tangram shapes that are referenced by id.
+/** Adding a shape that is already in the table returns the id of the
+ * existing entry, so all scenes with the same tangram share one entry. */
+class ShapeTable {
+public:
+	/// Returns the id of the shape, adds it if it is not yet in the table.
+	int add(Shapes::ShapeType type, const std::vector<float> &corners);
+
+	int size() const { return m_types.size(); }
+	Shapes::ShapeType getType(int id) const { return m_types[id]; }
+	/// Corners in meter as [x0,y0,x1,y1,...], centered at (0,0).
+	const std::vector<float> &getCorners(int id) const { return m_corners[id]; }
+
+private:
+	typedef std::pair<int, std::vector<float> > Key;
+	std::map<Key, int> m_ids;
+	std::vector<Shapes::ShapeType> m_types;
+	std::vector< std::vector<float> > m_corners;
+};
+
+/// A set of pushing scenes stored as structure of arrays.
+/** Each property of the PushingSceneInfo is stored in its own contiguous
+ * array, element i of all arrays belongs to scene i. The tangram geometry
+ * is stored only once per shape in the shape table and referenced by id.
+ * All values are in meter / radiants / kg like in the PushingSceneInfo.
+ *
+ * Subsets of the batch (e.g. training and test data) are selected with a
+ * SceneView, which only holds the indices of the scenes. */
+struct SceneBatch {
+	std::vector<float> tx0, ty0, trot0; // tangram start pos
+	std::vector<float> tx1, ty1, trot1; // tangram end pos
+	std::vector<float> tmass, tlength, theight;
+	std::vector<int> shape_id; // index into 'shapes'
+	std::vector<float> px0, py0; // pusher start pos
+	std::vector<float> px1, py1; // pusher end pos
+	std::vector<float> pdiam, pspeed;
+	ShapeTable shapes;
+
+	int size() const { return shape_id.size(); }
+
+	/// Appends the scene and returns its index.
+	int add(const PushingSceneInfo &si);
+
+	/// Writes scene i into 'si'.
+	/** If 'with_corners' is false, si.tcorners is left untouched, use
+	 * getCorners() to access the shared corners instead of copying them. */
+	void get(int i, PushingSceneInfo &si, bool with_corners=true) const;
+
+	const std::vector<float> &getCorners(int i) const { return shapes.getCorners(shape_id[i]); }
+	Shapes::ShapeType getType(int i) const { return shapes.getType(shape_id[i]); }
+
+	/// Transformation from the start to the end position of the tangram.
+	Transformation getDelta(int i) const {
+		return Transformation(trot1[i]-trot0[i], tx1[i]-tx0[i], ty1[i]-ty0[i]);
+	}
+
+	/// Horizontal distance between tangram and pusher at the start in meter.
+	float getPushOffset(int i) const { return std::fabs(tx0[i]-px0[i]); }
+
+	/// Loads a push_data file of the closed loop experiments, returns the number of loaded scenes.
+	/** The file columns are tx0 ty0 trot0 ax0 ay0 ax1 ay1 tx1 ty1 trot1 in cm
+	 * and degrees, the first line holds the column names. Mass, size, height,
+	 * pusher diameter and speed are taken from 'defaults'. */
+	int loadClosedLoopData(const std::string &filename, Shapes::ShapeType type,
+		const PushingSceneInfo &defaults);
+
+	/// Loads a file written by the PushingActionRecorder, returns the number of loaded scenes.
+	int loadRecordedActions(const std::string &filename, const PushingSceneInfo &defaults);
+
+	/// Calls loadRecordedActions() for '.dat' files and loadClosedLoopData() otherwise.
+	int load(const std::string &filename, Shapes::ShapeType type, const PushingSceneInfo &defaults);
+};
+
+/// Selection of scenes of a SceneBatch.
+/** Views only store the indices of the selected scenes, the scene data stays
+ * in the batch, which must outlive all its views. */
+class SceneView {
+public:
+	SceneView(): m_batch(0) {}
+	/// View on all scenes of the batch.
+	SceneView(const SceneBatch &batch);
+	SceneView(const SceneBatch &batch, const std::vector<int> &indices):
+		m_batch(&batch), m_indices(indices) {}
+
+	int size() const { return m_indices.size(); }
+	/// Index of the i-th scene of the view in the batch.
+	int operator[](int i) const { return m_indices[i]; }
+	const SceneBatch &getBatch() const { return *m_batch; }
+
+	const std::vector<float> &getCorners(int i) const { return m_batch->getCorners(m_indices[i]); }
+	Shapes::ShapeType getType(int i) const { return m_batch->getType(m_indices[i]); }
+	Transformation getDelta(int i) const { return m_batch->getDelta(m_indices[i]); }
+
+	/// Scenes [begin, end) of this view.
+	SceneView slice(int begin, int end) const;
+
+	/// Scenes with a push offset within +-0.5 cm of one of the passed offsets in cm.
+	SceneView selectPushOffsets(const std::vector<float> &offsets_in_cm) const;
+
+	/// Scenes for which 'keep' returns true.
+	SceneView select(bool (*keep)(const SceneBatch &batch, int i)) const;
+
+private:
+	const SceneBatch *m_batch;
+	std::vector<int> m_indices;
+};
+
+#endif /* __SCENE_BATCH_EWEITNAU_H__ */
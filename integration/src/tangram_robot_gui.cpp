@@ -46,7 +46,7 @@ void TangramRobotGui::predictPushingResults() {
     if (m_psim == NULL) return;
     //	static string &mouseMode = m_gui.getValue<string>("mouse-input-mode");
     static vector<btRigidBody*> bodyList;
-    vector<PolygonObject*> polygons = getActivePolygons();
+    vector<PolygonObject> polygons = getActivePolygons();
     if (polygons.empty()) return;
     if (m_arm_pos[2] == -1) return;
     // create pushing movement
@@ -56,7 +56,7 @@ void TangramRobotGui::predictPushingResults() {
             10. * ROBOT_TO_BULLET_SCALING);
     // convert and collect all active polygon objects
     for (unsigned int i = 0; i < polygons.size(); i++)
-        bodyList.push_back(m_adapter.to_bullet(*polygons[i]));
+        bodyList.push_back(m_adapter.to_bullet(polygons[i]));
 
 
     btTransform trans;
@@ -83,7 +83,7 @@ void TangramRobotGui::predictPushingResults() {
     if (!m_arm_moving) {
         for (unsigned int i = 0; i < polygons.size(); i++) {
             bodyList[i]->getMotionState()->getWorldTransform(trans);
-            polygons[i]->setPredictedTransformation(m_adapter.to_vision(trans));
+            setPredictedTransformation(polygons[i].getId(), m_adapter.to_vision(trans));
         }
     }
     // clear the physic rigid bodies
@@ -271,11 +271,23 @@ void TangramRobotGui::writeTangramDataToFile() {
     string filename = m_tangram_filename_gen.next();
     cout << "writing to file " << filename << "...";
     ofstream out(filename.c_str());
+    if (!m_action_recorder) m_action_recorder = new PushingActionRecorder("./data/pushing_actions.dat");
+    Vec push_begin = robot2vision(m_posA_world);
+    Vec push_end = robot2vision(m_posB_world);
     for (unsigned int i=0; i<m_tangrams_start.size(); i++) {
         out << m_tangrams_start[i].toString() << ","
             << m_tangrams_end[i].toString() << ","
             << m_tangrams_start[i].shape_name << endl;
+        PushingAction action;
+        action.shape = m_tangrams_start[i].shape;
+        action.pos_begin = m_tangrams_start[i].transformation;
+        action.pos_end = m_tangrams_end[i].transformation;
+        action.push_begin = Point32f(push_begin[0], push_begin[1]);
+        action.push_end = Point32f(push_end[0], push_end[1]);
+        m_action_recorder->record(action);
     }
+    // write the actions of this push in the background, without waiting for a full batch
+    m_action_recorder->requestFlush();
     m_tangrams_start.clear();
     m_tangrams_end.clear();
     out.close();
@@ -285,7 +297,7 @@ void TangramRobotGui::writeTangramDataToFile() {
 void TangramRobotGui::saveCurrentPolygons(vector<TangramInfo> &tangrams) {
     cout << "saving polygons: " << endl;
     tangrams.clear();
-    vector<PolygonObject*> polygons = getActivePolygons();
+    vector<PolygonObject> polygons = getActivePolygons();
     for (unsigned int i=0; i<polygons.size(); i++) {
         tangrams.push_back(TangramInfo(polygons[i]));
         cout << tangrams.back().toString() << "," << tangrams.back().shape_name << endl;
@@ -425,11 +437,11 @@ void TangramRobotGui::setAllLabels() {
 	else labelTangramDetected = "Single tangram detected: Fail";
 }
 
-void TangramRobotGui::draw(ICLDrawWidget *w, const std::vector<icl::Region> &rs) {
+void TangramRobotGui::draw(ICLDrawWidget *w, const VisionFrame &frame) {
 	Mutex::Locker l(m_arm_position_mutex);
   predictPushingResults();
 
-	TangramGui::draw(w, rs);
+	TangramGui::draw(w, frame);
 
 	setAllLabels();
 	
@@ -40,7 +40,7 @@ public:
     TangramRobotGui(float low_z = 1, float high_z = 8) : TangramGui(),
             m_arm_pos(-1, -1, -1, 1), m_target_world(10, 20, 1, 1),
             m_posA_world(30, 60, 1, 1), m_posB_world(30, 10, 1, 1),
-            m_low_z(low_z), m_high_z(high_z), m_psim(NULL),
+            m_low_z(low_z), m_high_z(high_z), m_action_recorder(NULL), m_psim(NULL),
             m_adapter(ROBOT_TO_BULLET_SCALING / 10), m_arm_moving(false),
             m_trajectory_filename_gen("./data/arm_trajectory##.txt"),
             m_tangram_filename_gen("./data/tangram_positions##.txt"),
@@ -48,7 +48,12 @@ public:
         m_tab_names += ",Pushing Actions";
     }
 
-    virtual void draw(icl::ICLDrawWidget *w, const std::vector<icl::Region> &rs);
+    virtual ~TangramRobotGui() {
+        stopPipeline();
+        delete m_action_recorder;
+    }
+
+    virtual void draw(icl::ICLDrawWidget *w, const VisionFrame &frame);
 
     virtual void init();
 
@@ -72,15 +77,19 @@ protected:
     struct TangramInfo {
         float x,y,rot;
         string shape_name;
+        PolygonShape shape; ///< untransformed model shape in vision coords.
+        Transformation transformation; ///< in vision coords.
         TangramInfo(float x, float y, float rot, string shape_name) :
         x(x), y(y), rot(rot), shape_name(shape_name) {}
 
-        TangramInfo(PolygonObject* p) {
-            const Transformation &t = p->getTransformation();
+        TangramInfo(const PolygonObject &p) {
+            const Transformation &t = p.getTransformation();
             x = vision2robot(t.getTx());
             y = vision2robot(t.getTy());
             rot = t.getRotation()*180 / M_PI;
-            shape_name = p->getShape().getName();
+            shape_name = p.getShape().getName();
+            shape = p.getShape();
+            transformation = t;
         }
 
         string toString() {
@@ -123,6 +132,9 @@ protected:
     void writeTrajectoryToFile();
     
     /// Write positions of active tangrams to a file (in order of their shape name)
+    /** Additionally, the start and end positions together with the pushing
+     * movement from position A to B are appended to the binary pushing action
+     * file ./data/pushing_actions.dat. */
     void writeTangramDataToFile();
 
     /// Returns a string with comma separated x,y pos. and the rot. of the passed PolygonObject.
@@ -147,7 +159,7 @@ private:
     icl::Mutex m_arm_position_mutex;
     float m_low_z; //! world z-coord. of finger tip (height over table) for pushing
     float m_high_z; //! world z-coord. of finger tip (height over table) for positioning
-    PushingActionRecorder m_recorder;
+    PushingActionRecorder *m_action_recorder;
     PushingSimulator *m_psim;
     VisionAdapter m_adapter;
     bool m_arm_moving;
@@ -0,0 +1,120 @@
+// Copyright 2009 Erik Weitnauer
+#include <DeterminismCheck.h>
+#include <btBulletDynamicsCommon.h>
+#include <pthread.h>
+#include <stdexcept>
+
+using namespace std;
+
+void DeterminismCheck::addBody(btCollisionShape *shape, float mass,
+                               const btVector3 &inertia, const btTransform &start) {
+	BodyInfo info;
+	info.shape = shape;
+	info.mass = mass;
+	info.inertia = inertia;
+	info.start = start;
+	m_bodies.push_back(info);
+}
+
+void DeterminismCheck::record(PushingSimulator &psim, HashStream &hashes) const {
+	vector<btCollisionShape*> shapes;
+	for (unsigned int i=0; i<m_bodies.size(); i++) shapes.push_back(m_bodies[i].shape);
+	record(psim, shapes, hashes);
+}
+
+void DeterminismCheck::record(PushingSimulator &psim, const vector<btCollisionShape*> &shapes,
+                              HashStream &hashes) const {
+	vector<btRigidBody*> bodies;
+	for (unsigned int i=0; i<m_bodies.size(); i++) {
+		btDefaultMotionState* motionState = new btDefaultMotionState(m_bodies[i].start);
+		btRigidBody::btRigidBodyConstructionInfo bodyCI(m_bodies[i].mass, motionState,
+		                                                shapes[i], m_bodies[i].inertia);
+		btRigidBody* body = new btRigidBody(bodyCI);
+		body->setActivationState(DISABLE_DEACTIVATION);
+		bodies.push_back(body);
+	}
+	bool hashing = psim.getStateHashing();
+	psim.setStateHashing(true);
+	psim.simulate(m_push, bodies, m_before_time, m_after_time);
+	psim.setStateHashing(hashing);
+	hashes = psim.getStateHashes();
+	for (unsigned int i=0; i<bodies.size(); i++) {
+		delete bodies[i]->getMotionState();
+		delete bodies[i];
+	}
+}
+
+DeterminismCheck::Result DeterminismCheck::verify(PushingSimulator &psim, int runs) const {
+	vector<HashStream> streams(runs);
+	for (int i=0; i<runs; i++) record(psim, streams[i]);
+	return compare(streams);
+}
+
+void *DeterminismCheck::runThread(void *data) {
+	ThreadData *td = static_cast<ThreadData*>(data);
+	td->check->record(*td->psim, td->shapes, *td->hashes);
+	return NULL;
+}
+
+DeterminismCheck::Result DeterminismCheck::verifyParallel(const vector<PushingSimulator*> &sims) const {
+	vector<HashStream> streams(sims.size());
+	vector<ThreadData> data(sims.size());
+	vector<pthread_t> threads(sims.size());
+	for (unsigned int i=0; i<sims.size(); i++) {
+		data[i].check = this;
+		data[i].psim = sims[i];
+		data[i].hashes = &streams[i];
+		for (unsigned int j=0; j<m_bodies.size(); j++)
+			data[i].shapes.push_back(copyShape(m_bodies[j].shape));
+	}
+	for (unsigned int i=0; i<sims.size(); i++)
+		pthread_create(&threads[i], NULL, &DeterminismCheck::runThread, &data[i]);
+	for (unsigned int i=0; i<sims.size(); i++) {
+		pthread_join(threads[i], NULL);
+		for (unsigned int j=0; j<data[i].shapes.size(); j++) delete data[i].shapes[j];
+	}
+	return compare(streams);
+}
+
+btCollisionShape *DeterminismCheck::copyShape(const btCollisionShape *shape) {
+	btCollisionShape *copy = NULL;
+	if (const btConvexHullShape *hull = dynamic_cast<const btConvexHullShape*>(shape)) {
+		copy = new btConvexHullShape((const btScalar*)hull->getUnscaledPoints(), hull->getNumPoints());
+	} else {
+		throw runtime_error("DeterminismCheck: can not copy collision shape for parallel run");
+	}
+	copy->setLocalScaling(shape->getLocalScaling());
+	copy->setMargin(shape->getMargin());
+	return copy;
+}
+
+int DeterminismCheck::findDivergence(const HashStream &a, const HashStream &b) {
+	unsigned int n = min(a.size(), b.size());
+	for (unsigned int i=0; i<n; i++) if (a[i] != b[i]) return i;
+	if (a.size() != b.size()) return n;
+	return -1;
+}
+
+DeterminismCheck::Result DeterminismCheck::compare(const vector<HashStream> &streams) {
+	Result r;
+	r.runs = streams.size();
+	if (streams.empty()) return r;
+	r.steps = streams[0].size();
+	for (unsigned int i=1; i<streams.size(); i++) {
+		int step = findDivergence(streams[0], streams[i]);
+		if (step >= 0) {
+			r.deterministic = false;
+			r.divergent_run = i;
+			r.divergent_step = step;
+			break;
+		}
+	}
+	return r;
+}
+
+std::ostream &operator<<(std::ostream &out, const DeterminismCheck::Result &r) {
+	if (r.deterministic)
+		return out << "deterministic: " << r.runs << " runs with " << r.steps << " identical steps";
+	return out << "NOT deterministic: run " << r.divergent_run << " diverges from run 0 in step "
+	           << r.divergent_step << " of " << r.steps;
+}
@@ -0,0 +1,95 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __DETERMINISM_CHECK_EWEITNAU_H__
+#define __DETERMINISM_CHECK_EWEITNAU_H__
+
+#include <vector>
+#include <iostream>
+#include <PushingSimulator.h>
+
+/// Verifies that a pushing simulation yields bit-exact identical results when repeated.
+/** A scene is described by its bodies (shape, mass, inertia and start
+ * transform) and a push movement. For each run fresh rigid bodies are
+ * created, the state hashing of the simulator is switched on and the
+ * resulting stream of per-step state hashes is recorded. The streams of
+ * all runs are compared with the first one.
+ *
+ * Typical usage:
+ *   DeterminismCheck check(push);
+ *   check.addBody(shape, mass, inertia, start_transform);
+ *   DeterminismCheck::Result r = check.verify(psim, 10);
+ *   if (!r.deterministic) cout << r << endl;
+ */
+class DeterminismCheck {
+public:
+	typedef std::vector<StateHash::value_type> HashStream;
+
+	struct Result {
+		Result(): deterministic(true), runs(0), steps(0),
+		          divergent_run(-1), divergent_step(-1) {}
+		bool deterministic;
+		/// number of compared runs
+		int runs;
+		/// number of simulation steps of the first run
+		int steps;
+		/// index of the first run that differs from run 0, -1 if none
+		int divergent_run;
+		/// index of the first step in which divergent_run differs from run 0, -1 if none
+		int divergent_step;
+	};
+
+	DeterminismCheck(const PushMovement &push, float before_time_in_s = 0.1,
+	                 float after_time_in_s = 0.5):
+		m_push(push), m_before_time(before_time_in_s), m_after_time(after_time_in_s) {}
+
+	/// Adds a body to the scene. The shape is not owned by the DeterminismCheck.
+	void addBody(btCollisionShape *shape, float mass, const btVector3 &inertia,
+	             const btTransform &start);
+
+	/// Simulates the scene once using psim and writes the state hashes into 'hashes'.
+	void record(PushingSimulator &psim, HashStream &hashes) const;
+
+	/// Simulates the scene 'runs' times in a row with the same simulator.
+	/** This catches state that is carried from one simulate() call to the next. */
+	Result verify(PushingSimulator &psim, int runs) const;
+
+	/// Simulates the scene once with each simulator, each one in its own thread.
+	/** The simulators must be initialized and distinct. As the collision
+	 * shapes get modified by PushingSimulator::applyParameters, each thread works
+	 * on its own copies of the shapes. Only btConvexHullShapes can be copied,
+	 * for other shapes a std::runtime_error is thrown. */
+	Result verifyParallel(const std::vector<PushingSimulator*> &sims) const;
+
+	/// Returns the index of the first differing step or -1 if the streams are equal.
+	/** If one stream is a prefix of the other, the length of the shorter one is returned. */
+	static int findDivergence(const HashStream &a, const HashStream &b);
+
+	/// Compares all streams to the first one.
+	static Result compare(const std::vector<HashStream> &streams);
+
+private:
+	struct BodyInfo {
+		btCollisionShape *shape;
+		float mass;
+		btVector3 inertia;
+		btTransform start;
+	};
+	struct ThreadData {
+		const DeterminismCheck *check;
+		PushingSimulator *psim;
+		std::vector<btCollisionShape*> shapes;
+		HashStream *hashes;
+	};
+	static void *runThread(void *data);
+	void record(PushingSimulator &psim, const std::vector<btCollisionShape*> &shapes,
+	            HashStream &hashes) const;
+	static btCollisionShape *copyShape(const btCollisionShape *shape);
+
+	PushMovement m_push;
+	float m_before_time;
+	float m_after_time;
+	std::vector<BodyInfo> m_bodies;
+};
+
+std::ostream &operator<<(std::ostream &out, const DeterminismCheck::Result &r);
+
+#endif /* __DETERMINISM_CHECK_EWEITNAU_H__ */
@@ -11,15 +11,21 @@ using namespace icl;
 //}
 
 void PushingSimulator::myTickCallback(btDynamicsWorld *world, btScalar timeStep) {
-  static btTransform transform;
-  static btVector3 vel;
 	PushingSimulator *psim = static_cast<PushingSimulator *>(world->getWorldUserInfo());
+	psim->m_step_count++;
+	if (psim->m_contact_counting) {
+		btDispatcher *dispatcher = world->getDispatcher();
+		for (int i=0; i<dispatcher->getNumManifolds(); i++)
+			psim->m_contact_count += dispatcher->getManifoldByIndexInternal(i)->getNumContacts();
+	}
+	if (psim->m_state_hashing) psim->hashState();
 	if (psim->m_pusher_speed<=0) {
 		psim->m_pusher->setLinearVelocity(btVector3(0,0,0));
 		return;
 	}
+  btTransform transform;
   psim->m_pusher->getMotionState()->getWorldTransform(transform);
-  vel = (psim->m_pusher_target - transform.getOrigin()) / timeStep * 0.7;
+  btVector3 vel = (psim->m_pusher_target - transform.getOrigin()) / timeStep * 0.7;
   if (vel.length() > psim->m_pusher_speed) vel *= psim->m_pusher_speed/vel.length();
 //  cout << "Target " << psim->m_pusher_target << endl;
 //  cout << "Current " << transform.getOrigin() << endl;
@@ -27,6 +33,19 @@ void PushingSimulator::myTickCallback(btDynamicsWorld *world, btScalar timeStep)
   psim->m_pusher->setLinearVelocity(vel);
 }
 
+void PushingSimulator::beginStateHashing(std::vector<btRigidBody*> &bodies) {
+	m_state_hashes.clear();
+	m_hashed_bodies = &bodies;
+}
+
+void PushingSimulator::hashState() {
+	if (!m_hashed_bodies) return;
+	StateHash hash(m_state_hashes.empty() ? StateHash::offsetBasis() : m_state_hashes.back());
+	for (unsigned int i=0; i<m_hashed_bodies->size(); i++) hash.add(*(*m_hashed_bodies)[i]);
+	if (m_pusher) hash.add(*m_pusher);
+	m_state_hashes.push_back(hash.value());
+}
+
 void PushingSimulator::applyParameters(btDynamicsWorld *world, std::vector<btRigidBody*> &bodies) {
 	world->setGravity(m_parameters.getGravity());
 	world->getSolverInfo().m_numIterations = m_parameters["solver_iterations"];
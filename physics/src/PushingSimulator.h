@@ -7,6 +7,7 @@
 #include <BulletDynamics/Dynamics/btDynamicsWorld.h>
 #include <PushMovement.h>
 #include <PhysicsParameters.h>
+#include <StateHash.h>
 
 /// Abstract class with a method for pushing action simulation.
 
@@ -14,7 +15,8 @@ class PushingSimulator {
 public:
 
     PushingSimulator() : m_pusher(NULL), m_pusher_shape(NULL), m_pusher_speed(1.),
-    m_ground_shape(NULL) {
+    m_ground_shape(NULL), m_state_hashing(false), m_hashed_bodies(NULL),
+    m_contact_counting(false), m_step_count(0), m_contact_count(0) {
     }
     /// Simulates a pushing action performed on the rigid bodies passed.
     /** Returns how much world time was simulated (in seconds). */
@@ -35,6 +37,42 @@ public:
         return m_parameters;
     }
 
+    /// Switches the hashing of the world state after each simulation step on or off.
+    /** When switched on, each call of simulate() records one rolling hash per
+     * internal simulation step over the bit-exact transforms and velocities of
+     * all passed bodies and the pusher. Two runs produced exactly the same
+     * results iff their hash streams are equal. */
+    void setStateHashing(bool enabled) {
+        m_state_hashing = enabled;
+    }
+
+    bool getStateHashing() const {
+        return m_state_hashing;
+    }
+
+    /// Returns the state hashes of all steps of the last simulate() call.
+    const std::vector<StateHash::value_type> &getStateHashes() const {
+        return m_state_hashes;
+    }
+
+    /// Switches counting the contact points after each simulation step on or off.
+    /** Counting loops over all contact manifolds of the world in each step,
+     * so it is switched off by default. */
+    void setContactCounting(bool enabled) {
+        m_contact_counting = enabled;
+    }
+
+    /// Returns the number of internal simulation steps of the last simulate() call.
+    int getStepCount() const {
+        return m_step_count;
+    }
+
+    /// Returns the contact points summed up over all steps of the last simulate() call.
+    /** Only counted if contact counting is switched on. */
+    long long getContactCount() const {
+        return m_contact_count;
+    }
+
 protected:
     static void myTickCallback(btDynamicsWorld *world, btScalar timeStep);
     btRigidBody *createGround();
@@ -44,6 +82,19 @@ protected:
     /// Reset some internal cached data in the broadphase.
     virtual void resetSolver(btDynamicsWorld *world);
 
+    /// Clears the state hashes, call at the beginning of simulate().
+    void beginStateHashing(std::vector<btRigidBody*> &bodies);
+    /// Sets the step and contact counts to zero, call at the beginning of simulate().
+    void resetCounters() {
+        m_step_count = 0;
+        m_contact_count = 0;
+    }
+    /// Appends the hash of the current state, call once per simulation step.
+    void hashState();
+    void endStateHashing() {
+        m_hashed_bodies = NULL;
+    }
+
     PhysicsParameters m_parameters;
     btRigidBody *m_pusher;
     btCollisionShape* m_pusher_shape;
@@ -52,6 +103,12 @@ protected:
     btVector3 m_pusher_target;
     btRigidBody *m_ground;
     btCollisionShape* m_ground_shape;
+    bool m_state_hashing;
+    std::vector<btRigidBody*> *m_hashed_bodies;
+    std::vector<StateHash::value_type> m_state_hashes;
+    bool m_contact_counting;
+    int m_step_count;
+    long long m_contact_count;
 };
 
 
@@ -79,6 +79,7 @@ void PushingSimulatorDebug::myTickCallback(btDynamicsWorld *world, btScalar time
   static int tick_count = 0;
   tick_count++;
 	PushingSimulatorDebug *self = static_cast<PushingSimulatorDebug *>(world->getWorldUserInfo());
+	if (self->m_state_hashing) self->hashState();
 	
 	self->m_pusher->getMotionState()->getWorldTransform(transform);
 	transform2 = self->m_pusher->getCenterOfMassTransform();
@@ -122,6 +123,8 @@ float PushingSimulatorDebug::simulate(const PushMovement &push, std::vector<btRi
 	//m_pusher->setCenterOfMassTransform(btTransform(btQuaternion(0,0,0,1), push.start + btVector3(0,m_pusher_dims.getY(),0)));
 	applyParameters(m_dynamicsWorld, bodies);
 	m_bodylist = &bodies;
+	resetCounters();
+	beginStateHashing(bodies);
 	// add all the rigid bodies to the scene, remove the pusher
 	for (unsigned int i=0; i<bodies.size(); i++)
 		m_dynamicsWorld->addRigidBody(bodies[i]);
@@ -167,6 +170,7 @@ float PushingSimulatorDebug::simulate(const PushMovement &push, std::vector<btRi
 	m_dynamicsWorld->removeRigidBody(m_pusher);
 	
 	m_bodylist = 0;
+	endStateHashing();
 	
 	return before_time_in_s + after_time_in_s + time_in_s;
 }
@@ -10,6 +10,8 @@ float PushingSimulatorFast::simulate(const PushMovement &push, std::vector<btRig
 	resetSolver(m_dynamicsWorld);
 	createPusher(push.pusher_dims);
 	applyParameters((btDynamicsWorld*)m_dynamicsWorld, bodies);
+	resetCounters();
+	beginStateHashing(bodies);
 	// add all the rigid bodies to the scene, remove the pusher
 	for (unsigned int i=0; i<bodies.size(); i++)
 		m_dynamicsWorld->addRigidBody(bodies[i]);
@@ -46,6 +48,7 @@ float PushingSimulatorFast::simulate(const PushMovement &push, std::vector<btRig
 	for (unsigned int i=0; i<bodies.size(); i++)
 		m_dynamicsWorld->removeRigidBody(bodies[i]);
 	m_dynamicsWorld->removeRigidBody(m_pusher);
+	endStateHashing();
 	
 	return before_time_in_s + after_time_in_s + time_in_s;
 }
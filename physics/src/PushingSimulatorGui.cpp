@@ -12,6 +12,8 @@ float PushingSimulatorGui::simulate(const PushMovement &push, std::vector<btRigi
 	resetSolver(m_dynamicsWorld);
 	createPusher(push.pusher_dims);
 	applyParameters((btDynamicsWorld*)m_dynamicsWorld, bodies);
+	resetCounters();
+	beginStateHashing(bodies);
 	// add all the rigid bodies to the scene, remove the pusher
 	for (unsigned int i=0; i<bodies.size(); i++)
 		m_dynamicsWorld->addRigidBody(bodies[i]);
@@ -54,6 +56,7 @@ float PushingSimulatorGui::simulate(const PushMovement &push, std::vector<btRigi
 	for (unsigned int i=0; i<bodies.size(); i++)
 		m_dynamicsWorld->removeRigidBody(bodies[i]);
 	m_dynamicsWorld->removeRigidBody(m_pusher);
+	endStateHashing();
 		
 	return before_time_in_s + after_time_in_s + time_in_s;
 }
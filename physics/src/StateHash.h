@@ -0,0 +1,52 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __STATE_HASH_EWEITNAU_H__
+#define __STATE_HASH_EWEITNAU_H__
+
+#include <BulletDynamics/Dynamics/btRigidBody.h>
+
+/// 64 bit FNV-1a hash over the bit patterns of simulation values.
+/** All values are hashed by their binary representation, so two simulation
+ * states get the same hash only if they are bit-exact identical (up to
+ * hash collisions). Pass the value of the previous hash as seed to get a
+ * rolling hash over a sequence of states. */
+class StateHash {
+public:
+	typedef unsigned long long value_type;
+
+	StateHash(value_type seed = offsetBasis()) : m_hash(seed) {}
+
+	/// Adds 'bytes' raw bytes starting at 'data' to the hash.
+	void add(const void *data, unsigned int bytes) {
+		const unsigned char *p = static_cast<const unsigned char*>(data);
+		for (unsigned int i=0; i<bytes; ++i) {
+			m_hash ^= p[i];
+			m_hash *= 1099511628211ULL;
+		}
+	}
+
+	void add(btScalar x) { add(&x, sizeof(x)); }
+
+	/// Only the x, y, z components are hashed, the padding w is ignored.
+	void add(const btVector3 &v) { add(v.getX()); add(v.getY()); add(v.getZ()); }
+
+	void add(const btTransform &t) {
+		add(t.getBasis()[0]); add(t.getBasis()[1]); add(t.getBasis()[2]);
+		add(t.getOrigin());
+	}
+
+	/// Adds world transform, linear and angular velocity of the body.
+	void add(const btRigidBody &body) {
+		add(body.getCenterOfMassTransform());
+		add(body.getLinearVelocity());
+		add(body.getAngularVelocity());
+	}
+
+	value_type value() const { return m_hash; }
+
+	static value_type offsetBasis() { return 14695981039346656037ULL; }
+
+private:
+	value_type m_hash;
+};
+
+#endif /* __STATE_HASH_EWEITNAU_H__ */
@@ -0,0 +1,149 @@
+// Copyright 2009 Erik Weitnauer
+/// Benchmark of the BlobDetector against the icl::RegionDetector.
+/**
+ * Both detectors run on the same binary images with the same size
+ * restrictions. For the RegionDetector the boundaries of all returned regions
+ * are fetched, as BasicCornerDetectionGui needs them. The sizes and centers of
+ * gravity of the detected blobs must be identical.
+ *
+ * The images are read from the passed files, e.g. local threshold images
+ * saved from the vision application. Pixels brighter than 127 in the first
+ * channel are foreground. Without files, synthetic UXGA images with tangram
+ * pieces and noise are used.
+ *
+ * usage: blob_benchmark [repetitions] [min-size] [max-size] [image ...]
+ */
+
+#include <ICLQuick/Common.h>
+#include <ICLBlob/RegionDetector.h>
+#include <ICLUtils/Time.h>
+#include "blob_detector.h"
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+
+/// Reads the first channel of an image file and binarizes it.
+bool loadImage(const string &filename, Img8u &image) {
+  try {
+    FileGrabber grabber(filename);
+    grabber.setDesiredDepth(depth8u);
+    const Img8u *img = grabber.grab()->asImg<icl8u>();
+    image = Img8u(img->getSize(), 1);
+    const icl8u *src = img->getData(0);
+    icl8u *dst = image.getData(0);
+    for (int i=0; i<image.getDim(); i++) dst[i] = src[i] > 127 ? 255 : 0;
+  } catch (ICLException &e) {
+    return false;
+  }
+  return true;
+}
+
+/// Fills a rotated square or triangle of the passed size.
+void drawPiece(Img8u &image, float cx, float cy, float size, float angle, bool square) {
+  float c = cos(angle), s = sin(angle);
+  int r = (int)(1.5*size);
+  for (int y=max(0,(int)cy-r); y<min(image.getHeight(),(int)cy+r); y++) {
+    for (int x=max(0,(int)cx-r); x<min(image.getWidth(),(int)cx+r); x++) {
+      // coordinates in the frame of the piece
+      float u = (c*(x-cx) + s*(y-cy))/size, v = (-s*(x-cx) + c*(y-cy))/size;
+      bool inside = square ? (fabs(u) <= 1 && fabs(v) <= 1) : (u >= -1 && v >= -1 && u+v <= 0);
+      if (inside) image(x,y,0) = 255;
+    }
+  }
+}
+
+/// UXGA image with tangram pieces and salt noise, as after a bad threshold.
+Img8u syntheticImage(int seed) {
+  srand(seed);
+  Img8u image(Size(1600,1200), 1);
+  for (int i=0; i<7; i++) {
+    drawPiece(image, 150+rand()%1300, 150+rand()%900, 40+rand()%60, 0.01*(rand()%314), i%2==0);
+  }
+  icl8u *data = image.getData(0);
+  for (int i=0; i<image.getDim()/200; i++) data[rand()%image.getDim()] = 255;
+  return image;
+}
+
+struct BlobStats {
+  int size;
+  float x, y;
+  bool operator<(const BlobStats &other) const {
+    if (size != other.size) return size < other.size;
+    if (x != other.x) return x < other.x;
+    return y < other.y;
+  }
+};
+
+int main(int argc, char **argv) {
+  int reps = argc > 1 ? atoi(argv[1]) : 20;
+  int min_size = argc > 2 ? atoi(argv[2]) : 400;
+  int max_size = argc > 3 ? atoi(argv[3]) : 100000;
+  vector<Img8u> images;
+  for (int i=4; i<argc; i++) {
+    images.push_back(Img8u());
+    if (!loadImage(argv[i], images.back())) {
+      cerr << "could not read image from " << argv[i] << endl;
+      images.pop_back();
+    }
+  }
+  if (images.empty()) {
+    for (int i=0; i<5; i++) images.push_back(syntheticImage(i));
+  }
+
+  BlobDetector blob_detector(min_size, max_size, 255);
+  RegionDetector region_detector(min_size, max_size, 255, 255);
+
+  int mismatches = 0;
+  int blobs = 0, runs = 0, components = 0;
+  unsigned int boundary_points = 0, region_boundary_points = 0;
+  for (unsigned int i=0; i<images.size(); i++) {
+    const vector<Blob> &bs = blob_detector.detect(images[i]);
+    const vector<Region> &rs = region_detector.detect(&images[i]);
+    blobs += bs.size();
+    runs += blob_detector.getRunCount();
+    components += blob_detector.getComponentCount();
+    vector<BlobStats> a, b;
+    for (unsigned int j=0; j<bs.size(); j++) {
+      BlobStats s = { bs[j].size, bs[j].cog.x, bs[j].cog.y };
+      a.push_back(s);
+      boundary_points += bs[j].boundary.size();
+    }
+    for (unsigned int j=0; j<rs.size(); j++) {
+      BlobStats s = { rs[j].getSize(), rs[j].getCOG().x, rs[j].getCOG().y };
+      b.push_back(s);
+      region_boundary_points += rs[j].getBoundary().size();
+    }
+    sort(a.begin(), a.end());
+    sort(b.begin(), b.end());
+    bool same = a.size() == b.size();
+    for (unsigned int j=0; same && j<a.size(); j++) {
+      same = a[j].size == b[j].size && fabs(a[j].x-b[j].x) < 0.01 && fabs(a[j].y-b[j].y) < 0.01;
+    }
+    if (!same) {
+      mismatches++;
+      cout << "image " << i << ": " << a.size() << " blobs, RegionDetector found " << b.size() << endl;
+    }
+  }
+
+  Time t = Time::now();
+  for (int r=0; r<reps; r++)
+    for (unsigned int i=0; i<images.size(); i++) blob_detector.detect(images[i]);
+  float t_blob = (Time::now()-t).toMicroSecondsDouble();
+  t = Time::now();
+  for (int r=0; r<reps; r++) {
+    for (unsigned int i=0; i<images.size(); i++) {
+      const vector<Region> &rs = region_detector.detect(&images[i]);
+      for (unsigned int j=0; j<rs.size(); j++) rs[j].getBoundary();
+    }
+  }
+  float t_region = (Time::now()-t).toMicroSecondsDouble();
+
+  int n = images.size();
+  cout << n << " images, " << blobs << " blobs of " << components << " components, "
+       << runs << " runs, " << reps << " repetitions" << endl;
+  cout << "boundary points: " << boundary_points << ", RegionDetector: " << region_boundary_points << endl;
+  cout << "BlobDetector:   " << t_blob/(reps*n*1000) << " ms per image" << endl;
+  cout << "RegionDetector: " << t_region/(reps*n*1000) << " ms per image" << endl;
+  cout << "speedup: " << t_region/t_blob << ", mismatches: " << mismatches << endl;
+  return mismatches ? 1 : 0;
+}
@@ -7,6 +7,7 @@
 #include <ICLCore/Line.h>
 #include <ICLUtils/StackTimer.h>
 #include <ICLCore/CornerDetectorCSS.h>
+#include "boundary_thinning.h"
 #include <fstream>
 #include <iostream>
 
@@ -73,7 +74,8 @@ template<class T>
   for(int i=0;i<cs[0].getDim();++i){
     int d = 0;
     for(int c=0;c<3;++c){
-      d += pow( double(cs[c][i] - ref[c]) ,2.0); 	
+      int diff = cs[c][i] - ref[c];
+      d += diff*diff;
     } 
     dst[i] = 255 * (d < t);
   }
@@ -88,25 +90,6 @@ inline std::string to_string (const T& t)
   return ss.str();
 }
 
-const vector< Point32f > &getThinnedBoundary(const vector< Point > &b) {
-  static vector< Point32f > thinned;
-  thinned.clear();
-  if (b.size() < 2) return thinned;
-  Point pre = b[b.size()-2];
-  Point cur = b[b.size()-1];
-  Point post; 
-  for (unsigned i=0; i < b.size(); i++) {
-    // search for the first point not in the 8 neighbourhood of current point
-    if ((abs(b[i].x - cur.x) > 1) || (abs(b[i].y - cur.y) > 1)) {
-      thinned.push_back((Point32f)cur);
-      pre = cur;
-      cur = post;
-      post = b[i];
-    } else post = b[i];
-  }
-  return thinned;
-}
-
 void setCSSParameters() {
 	css.setAngleThreshold(gui.getValue<float>("max_angle"));
   css.setRCCoeff(gui.getValue<float>("rc_coeff"));
@@ -286,11 +269,9 @@ void myrun(){
   const std::vector<icl::Region> &rs = d.detect(&threshedImage);
   setCSSParameters();
   // iterate over all regions and draw information onto the DrawWidgets
+  vector<Point32f> boundary;
   for(unsigned int i=0;i<rs.size();++i) {
-  	vector<Point32f> boundary;
-  	{
-  		boundary = getThinnedBoundary(rs[i].getBoundary());
-  	}
+  	getThinnedBoundary(rs[i].getBoundary(), boundary);
   	{
   		css.detectCorners(boundary);
   	}
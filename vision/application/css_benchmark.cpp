@@ -0,0 +1,243 @@
+// Copyright 2009 Erik Weitnauer
+/// Micro-benchmark for CornerDetectorCSS::detectCorners.
+/**
+ * Runs the corner detection on recorded contours and compares results and
+ * run time with a copy of the original implementation, which allocates all
+ * arrays on the stack and a new gaussian kernel in each call and computes
+ * the derivatives and the curvature in separate loops.
+ *
+ * The contours are read from text files with one "x y" point per line, like
+ * the <prefix>boundary.txt files written by the css_analyzer. Without files,
+ * synthetic tangram contours of different sizes are used.
+ *
+ * Afterwards, the detection is timed once more with resampled contours (see
+ * CornerDetectorCSS::contour_spacing) and the corners are compared with the
+ * ones found on the full contours.
+ *
+ * usage: css_benchmark [repetitions] [boundary.txt ...]
+ */
+
+#include <ICLQuick/Common.h>
+#include <ICLUtils/Time.h>
+#include "corner_detector_css.h"
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+#ifdef HAVE_IPP
+#include <ipp.h>
+#endif
+
+/// Original version of CornerDetectorCSS::detectCorners.
+class ReferenceCSS: public CornerDetectorCSS {
+  public:
+    const vector<Point32f> &detect(const vector<Point32f> &boundary) {
+      ref_corners.clear();
+      ref_angles.clear();
+      int L=boundary.size();
+      float x_in[L], y_in[L];
+      for (int i=0; i<L; i++) { x_in[i] = boundary[i].x; y_in[i] = boundary[i].y; }
+
+      float* h;
+      int W = gaussian(&h, sigma, 0.0001);
+      const int l2w = L+2*W;
+      const int l4w = L+4*W;
+      if (L <= W) { free(h); return ref_corners; }
+
+      float x[l2w], y[l2w];
+      memcpy(x, &x_in[L-W], W*sizeof(float));
+      memcpy(&x[W], x_in, L*sizeof(float));
+      memcpy(&x[L+W], x_in, W*sizeof(float));
+      memcpy(y, &y_in[L-W], W*sizeof(float));
+      memcpy(&y[W], y_in, L*sizeof(float));
+      memcpy(&y[L+W], y_in, W*sizeof(float));
+
+      float xx_big[l4w], yy_big[l4w];
+#ifdef HAVE_IPP
+      ippsConv_32f(x, l2w, h, 2*W+1, xx_big);
+      ippsConv_32f(y, l2w, h, 2*W+1, yy_big);
+#else
+      for (int i=0; i<l4w; i++) {
+        float ax = 0, ay = 0;
+        for (int m=0; m<2*W+1; m++) {
+          int j = i-2*W+m;
+          if (j < 0 || j >= l2w) continue;
+          ax += h[m]*x[j]; ay += h[m]*y[j];
+        }
+        xx_big[i] = ax; yy_big[i] = ay;
+      }
+#endif
+      free(h);
+      float *xx = &xx_big[W], *yy = &yy_big[W];
+
+      float xu[l2w], yu[l2w];
+      xu[0] = xx[1]-xx[0];
+      for (int i=1; i<l2w-1; i++) xu[i] = (xx[i+1]-xx[i-1])/2;
+      xu[l2w-1] = xx[l2w-1]-xx[l2w-2];
+      yu[0] = yy[1]-yy[0];
+      for (int i=1; i<l2w-1; i++) yu[i] = (yy[i+1]-yy[i-1])/2;
+      yu[l2w-1] = yy[l2w-1]-yy[l2w-2];
+
+      float xuu[l2w], yuu[l2w];
+      xuu[0] = xu[1]-xu[0];
+      for (int i=1; i<l2w-1; i++) xuu[i] = (xu[i+1]-xu[i-1])/2;
+      xuu[l2w-1] = xu[l2w-1]-xu[l2w-2];
+      yuu[0] = yu[1]-yu[0];
+      for (int i=1; i<l2w-1; i++) yuu[i] = (yu[i+1]-yu[i-1])/2;
+      yuu[l2w-1] = yu[l2w-1]-yu[l2w-2];
+
+      float k[l2w];
+      for (int i=0; i<l2w; i++) {
+        k[i] = abs((xu[i]*yuu[i] - xuu[i]*yu[i]) / pow((xu[i]*xu[i] + yu[i]*yu[i]),1.5f));
+        k[i] = float(round(k[i]*curvature_cutoff))/curvature_cutoff;
+      }
+
+      vector<int> extrema;
+      vector<float> angles;
+      findExtrema(extrema, k, l2w);
+      removeRoundCorners(rc_coeff, k, extrema);
+      removeFalseCorners(angle_thresh, xx, yy, k, l2w, extrema, angles, straight_line_thresh);
+
+      for (unsigned i=0; i<extrema.size(); i++) {
+        if (extrema[i] >= W and extrema[i] < L+W) {
+          ref_corners.push_back(Point32f(x_in[extrema[i]-W], y_in[extrema[i]-W]));
+          ref_angles.push_back(angles[i]);
+        }
+      }
+      return ref_corners;
+    }
+
+    const vector<float> &getReferenceAngles() { return ref_angles; }
+
+  private:
+    vector<Point32f> ref_corners;
+    vector<float> ref_angles;
+};
+
+/// Reads one contour with one "x y" point per line.
+bool loadContour(const string &filename, vector<Point32f> &contour) {
+  ifstream in(filename.c_str());
+  if (!in.good()) return false;
+  float x, y;
+  while (in >> x >> y) contour.push_back(Point32f(x,y));
+  return !contour.empty();
+}
+
+/// Appends the 8-connected pixel line from a to b (without b) to the contour.
+void addLine(vector<Point32f> &contour, int x0, int y0, int x1, int y1) {
+  int dx = abs(x1-x0), dy = -abs(y1-y0);
+  int sx = x0<x1 ? 1 : -1, sy = y0<y1 ? 1 : -1;
+  int err = dx+dy;
+  while (x0 != x1 || y0 != y1) {
+    contour.push_back(Point32f(x0,y0));
+    int e2 = 2*err;
+    if (e2 >= dy) { err += dy; x0 += sx; }
+    if (e2 <= dx) { err += dx; y0 += sy; }
+  }
+}
+
+/// Thinned contour of a rotated tangram square or triangle with a little noise.
+vector<Point32f> syntheticContour(float size, float angle, bool square) {
+  int n = square ? 4 : 3;
+  float corners[4][2] = {{-1,-1}, {1,-1}, {1,1}, {-1,1}};
+  if (!square) { corners[2][0] = -1; }
+  vector<Point32f> contour;
+  for (int i=0; i<n; i++) {
+    const float *a = corners[i], *b = corners[(i+1)%n];
+    int x0 = round(size*(cos(angle)*a[0] - sin(angle)*a[1])), y0 = round(size*(sin(angle)*a[0] + cos(angle)*a[1]));
+    int x1 = round(size*(cos(angle)*b[0] - sin(angle)*b[1])), y1 = round(size*(sin(angle)*b[0] + cos(angle)*b[1]));
+    addLine(contour, x0, y0, x1, y1);
+  }
+  for (unsigned int i=0; i<contour.size(); i+=7) contour[i].x += (rand()%3)-1;
+  return contour;
+}
+
+int main(int argc, char **argv) {
+  int reps = argc > 1 ? atoi(argv[1]) : 100;
+  vector< vector<Point32f> > contours;
+  for (int i=2; i<argc; i++) {
+    contours.push_back(vector<Point32f>());
+    if (!loadContour(argv[i], contours.back())) {
+      cerr << "could not read contour from " << argv[i] << endl;
+      contours.pop_back();
+    }
+  }
+  if (contours.empty()) {
+    // from tangram pieces in VGA up to long contours in UXGA
+    float sizes[] = {30, 60, 120, 250, 500};
+    for (int i=0; i<5; i++) {
+      contours.push_back(syntheticContour(sizes[i], 0.3*i, true));
+      contours.push_back(syntheticContour(sizes[i], 0.5+0.2*i, false));
+    }
+  }
+
+  CornerDetectorCSS css;
+  ReferenceCSS ref;
+  // The corners must be identical. The angles are computed from the smoothed
+  // contour and may differ in the last bits if the compiler contracts the
+  // multiply-adds of the smoothing differently (or if IPP is used), by up
+  // to 6e-4 deg with -march=native. Bigger differences count as mismatches.
+  const float max_angle_tolerance = 1e-3;
+  int mismatches = 0;
+  float max_angle_diff = 0;
+  unsigned int points = 0;
+  for (unsigned int i=0; i<contours.size(); i++) {
+    points += contours[i].size();
+    vector<Point32f> c1 = css.detectCorners(contours[i]);
+    vector<float> a1 = css.getCornerAngles();
+    vector<Point32f> c2 = ref.detect(contours[i]);
+    vector<float> a2 = ref.getReferenceAngles();
+    bool same = c1.size() == c2.size() && a1.size() == a2.size();
+    for (unsigned int j=0; same && j<c1.size(); j++) {
+      same = c1[j] == c2[j];
+      max_angle_diff = max(max_angle_diff, (float)fabs(a1[j]-a2[j]));
+      same = same && fabs(a1[j]-a2[j]) <= max_angle_tolerance;
+    }
+    if (!same) {
+      mismatches++;
+      cout << "contour " << i << " (" << contours[i].size() << " points): " << c1.size()
+           << " corners, reference found " << c2.size() << " (or the angles differ)" << endl;
+    }
+  }
+
+  Time t = Time::now();
+  for (int r=0; r<reps; r++)
+    for (unsigned int i=0; i<contours.size(); i++) css.detectCorners(contours[i]);
+  float t_css = (Time::now()-t).toMicroSecondsDouble();
+  t = Time::now();
+  for (int r=0; r<reps; r++)
+    for (unsigned int i=0; i<contours.size(); i++) ref.detect(contours[i]);
+  float t_ref = (Time::now()-t).toMicroSecondsDouble();
+
+  cout << contours.size() << " contours, " << points << " points, " << reps << " repetitions" << endl;
+  cout << "CornerDetectorCSS: " << t_css/reps << " us per round, " << 1000*t_css/(reps*points) << " ns per point" << endl;
+  cout << "reference:         " << t_ref/reps << " us per round, " << 1000*t_ref/(reps*points) << " ns per point" << endl;
+  cout << "speedup: " << t_ref/t_css << ", mismatches: " << mismatches
+       << ", max. angle difference: " << max_angle_diff << " deg" << endl;
+
+  // resampled contours: count the contours with a different number of
+  // corners and measure how far the others moved. The full contours of the
+  // synthetic shapes start at a corner, which is sometimes missed there.
+  CornerDetectorCSS css_resampled;
+  css_resampled.contour_spacing = 3;
+  int count_changed = 0;
+  float max_shift = 0;
+  for (unsigned int i=0; i<contours.size(); i++) {
+    vector<Point32f> c1 = css.detectCorners(contours[i]);
+    const vector<Point32f> &c2 = css_resampled.detectCorners(contours[i]);
+    if (c1.size() != c2.size()) { count_changed++; continue; }
+    for (unsigned int j=0; j<c1.size(); j++) {
+      float d = 1e9;
+      for (unsigned int k=0; k<c2.size(); k++) d = min(d, (float)sqrt(pow(c1[j].x-c2[k].x,2) + pow(c1[j].y-c2[k].y,2)));
+      max_shift = max(max_shift, d);
+    }
+  }
+  t = Time::now();
+  for (int r=0; r<reps; r++)
+    for (unsigned int i=0; i<contours.size(); i++) css_resampled.detectCorners(contours[i]);
+  float t_resampled = (Time::now()-t).toMicroSecondsDouble();
+  cout << "resampled to " << css_resampled.contour_spacing << " px: " << t_resampled/reps
+       << " us per round, speedup: " << t_css/t_resampled << endl;
+  cout << "contours with a different corner count: " << count_changed
+       << ", max. corner shift: " << max_shift << " px" << endl;
+  return mismatches ? 1 : 0;
+}
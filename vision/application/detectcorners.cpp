@@ -6,18 +6,17 @@
 
 BasicCornerDetectionGui gui;
 
-void vision_loop() {
-	gui.vision_loop();
-  Thread::msleep(10);
-}
-
 void init() {
 	gui.init();
+	gui.startPipeline();
 }
 
 int main(int n, char **args) {
 	paex("-input","define input device id and parameters");
   paex("-size","defines the input image size");
-  return ICLApplication(n, args, "-size|-s(Size=VGA) -input|-i(device-type=dc,device-params=0)", init, vision_loop).exec();
+  ICLApplication app(n, args, "-size|-s(Size=VGA) -input|-i(device-type=dc,device-params=0)", init);
+  int result = app.exec();
+  gui.stopPipeline();
+  return result;
 }
 
@@ -20,22 +20,24 @@ std::string to_string (const T &t) {
 }
 
 class TangramGui : public BasicCornerDetectionGui {
-	virtual void draw(icl::ICLDrawWidget *w, const std::vector<icl::Region> &rs) {
+	virtual void draw(icl::ICLDrawWidget *w, const VisionFrame &frame) {
 	  static Color4D RED(255,50,50,255);
 		static Point32f cog;
 		static vector<PolygonObject> polygons;
-		// iterate over detected regions
-		for(unsigned int i=0;i<rs.size();++i) {
+		const vector<Blob> &blobs = frame.blobs;
+		// do the corner detection
+		const CornerDetectionBatch &batch = detectCornersCSS(blobs);
+		// iterate over detected blobs
+		for(unsigned int i=0;i<blobs.size();++i) {
 			// draw boundary
 		  w->color(255,0,0,255); w->fill(255,0,0,255);
-		  w->points(rs[i].getBoundary());
-		  // do the corner detection
-		  const vector<Point32f> &corners = detectCornersCSS(rs[i]);
+		  w->points(blobs[i].boundary);
+		  const vector<Point32f> &corners = batch.getCorners(i);
 		  // draw center of gravity
-		  cog = rs[i].getCOG();
+		  cog = blobs[i].cog;
 		  w->color(255,0,0,255); w->fill(255,0,0,255);
 		  w->ellipse(cog.x-1, cog.y-1,2,2);
-		  //w->text(to_string(rs[i].getSize()), cog.x, cog.y-10,-1,-1,10);
+		  //w->text(to_string(blobs[i].size), cog.x, cog.y-10,-1,-1,10);
 		  
 		  drawCorners(w, corners, RED, RED);
 		  // object classification, but only if polygon has less than 6 corners
@@ -57,18 +59,17 @@ class TangramGui : public BasicCornerDetectionGui {
 	}
 } gui;
 
-void vision_loop() {
-	gui.vision_loop();	
-  Thread::msleep(10);
-}
-
 void init() {
 	tc.loadStandardTangramShapes(63.2,0.2); // size in pixel
 	gui.init();
+	gui.startPipeline();
 }
 
 int main(int n, char **args) {
 	paex("-input","define input grabber e.g. -input dc 0 or -input file images/*.ppm");
-  return ICLApplication(n, args, "-input(2) -size(1)", init, vision_loop).exec();
+  ICLApplication app(n, args, "-input(2) -size(1)", init);
+  int result = app.exec();
+  gui.stopPipeline();
+  return result;
 }
 
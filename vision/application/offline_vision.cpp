@@ -0,0 +1,122 @@
+// Copyright 2009 Erik Weitnauer
+/// Detects and tracks tangrams on recorded images without a GUI.
+/**
+ * The images matching the -input pattern are split into as many contiguous
+ * chunks as there are threads. Each thread processes its chunk in order
+ * with its own TangramVisionPipeline, so the polygons are tracked within a
+ * chunk. The results are printed in the order of the images, one line per
+ * image with the number of blobs and corners and the active polygons.
+ *
+ * usage: offline_vision -input 'images/frame_*.ppm' -ref-color 200 40 40 -threads 4
+ */
+
+#include <ICLQuick/Common.h>
+#include <ICLIO/FileList.h>
+#include <ICLUtils/Time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sstream>
+#include "tangram_vision_pipeline.h"
+
+struct Chunk {
+  const FileList *files;
+  int begin, end;
+  VisionConfig config;
+  vector<string> *lines; ///< output line of each image
+  pthread_t thread;
+};
+
+string describe(const string &filename, const VisionFrame &frame, const VisionResult &result) {
+  stringstream ss;
+  int corners = 0;
+  for (unsigned int i=0; i<result.corners.size(); i++) corners += result.corners[i].size();
+  ss << filename << ": " << frame.blobs.size() << " blobs, " << corners << " corners";
+  for (unsigned int i=0; i<result.polygons.size(); i++) {
+    const PolygonObject &p = result.polygons[i];
+    if (!p.isActive(result.timestep)) continue;
+    PolygonShape shape = p.getTransformedShape();
+    ss << ", #" << p.getId() << " " << shape.getName() << " at (" << round(shape.getCenter().x)
+       << ", " << round(shape.getCenter().y) << ") "
+       << round(p.getTransformation().getRotation()*180/M_PI) << " deg";
+  }
+  return ss.str();
+}
+
+void *processChunk(void *data) {
+  Chunk &chunk = *(Chunk*)data;
+  // this thread is one of many, so the corner detection must not start more
+  TangramVisionPipeline vision(1);
+  vision.setConfig(chunk.config);
+  if (pa("-tangram-cfg")) vision.loadShapesFromXMLFile(*pa("-tangram-cfg"));
+  else vision.loadStandardTangramShapes();
+  if (pa("-cam-cfg")) {
+    Camera cam(pa("-cam-cfg").as<std::string>());
+    PlaneEquation z_plane(Vec(0,0,vision.getTangramHeight()),Vec(0,0,1));
+    vision.setCameraTransformer(CameraTransformer(cam, z_plane));
+    vision.setDoWorldTransformation(true);
+  }
+  VisionResult result;
+  for (int i=chunk.begin; i<chunk.end; i++) {
+    const string &filename = (*chunk.files)[i];
+    VisionFrame frame;
+    frame.id = i;
+    try {
+      FileGrabber grabber(filename);
+      grabber.setDesiredDepth(depth8u);
+      grabber.grab()->asImg<icl8u>()->deepCopy(&frame.image);
+    } catch (ICLException &e) {
+      (*chunk.lines)[i] = filename + ": could not read image";
+      continue;
+    }
+    vision.process(frame, result);
+    (*chunk.lines)[i] = describe(filename, frame, result);
+  }
+  return NULL;
+}
+
+int main(int n, char **args) {
+  paex("-input","file pattern of the images, e.g. -input 'images/*.ppm'");
+  paex("-ref-color","rgb color of the tangrams");
+  paex("-threads","number of images processed in parallel, default: number of cores");
+  paex("-tangram-cfg","xml file describing the polygon classes for classifying");
+  paex("-cam-cfg","camera configuration file for screen to world transformation");
+  paex("-tile-size","tangram tile size");
+  painit(n,args,"-input|-i(1) -ref-color(3) -threads(1) -tangram-cfg(1) -cam-cfg(1) -tile-size(1) "
+         "-threshold(1) -mask-size(1)");
+
+  FileList files(*pa("-input"));
+  if (files.size() == 0) {
+    cerr << "no images match " << *pa("-input") << endl;
+    return 1;
+  }
+  int threads = pa("-threads") ? pa("-threads").as<int>() : sysconf(_SC_NPROCESSORS_ONLN);
+  threads = max(1, min(threads, (int)files.size()));
+
+  VisionConfig config;
+  if (pa("-ref-color")) {
+    for (int i=0; i<3; i++) config.ref_color[i] = pa("-ref-color",i).as<double>();
+  }
+  if (pa("-tile-size")) config.tile_size = pa("-tile-size").as<float>();
+  if (pa("-threshold")) config.threshold = pa("-threshold").as<int>();
+  if (pa("-mask-size")) config.mask_size = pa("-mask-size").as<int>();
+
+  vector<string> lines(files.size());
+  vector<Chunk> chunks(threads);
+  Time t = Time::now();
+  for (int i=0; i<threads; i++) {
+    Chunk &c = chunks[i];
+    c.files = &files;
+    c.begin = (long long)files.size()*i/threads;
+    c.end = (long long)files.size()*(i+1)/threads;
+    c.config = config;
+    c.lines = &lines;
+    pthread_create(&c.thread, NULL, &processChunk, &c);
+  }
+  for (int i=0; i<threads; i++) pthread_join(chunks[i].thread, NULL);
+  float seconds = (Time::now()-t).toSecondsDouble();
+
+  for (unsigned int i=0; i<lines.size(); i++) cout << lines[i] << endl;
+  cout << files.size() << " images in " << seconds << " s with " << threads << " threads, "
+       << files.size()/seconds << " fps" << endl;
+  return 0;
+}
@@ -15,34 +15,34 @@ class BlobGui : public BasicCornerDetectionGui {
 		m_grabber->setDesiredSize(Size(800,600));
 	}
 	
-	virtual void draw(icl::ICLDrawWidget *w, const std::vector<icl::Region> &rs) {
+	virtual void draw(icl::ICLDrawWidget *w, const VisionFrame &frame) {
 		if (!m_gui.getValue<bool>("show-regions")) return;
+	  const vector<Blob> &blobs = frame.blobs;
 	  
-	  // iterate over detected regions
-		for(unsigned int i=0;i<rs.size();++i) {
+	  // iterate over detected blobs
+		for(unsigned int i=0;i<blobs.size();++i) {
 			// draw boundary
 		  w->color(255,0,0,255); w->fill(255,0,0,255);
-		  for (unsigned int j=0; j<rs[i].getBoundary().size(); ++j) {
-			  w->rect(rs[i].getBoundary()[j].x,rs[i].getBoundary()[j].y,1,1);
+		  for (unsigned int j=0; j<blobs[i].boundary.size(); ++j) {
+			  w->rect(blobs[i].boundary[j].x,blobs[i].boundary[j].y,1,1);
 		  }
 		  // draw center of gravity
-		  Point32f cog = rs[i].getCOG();
+		  Point32f cog = blobs[i].cog;
 		  w->ellipse(cog.x-1, cog.y-1,2,2);
 		  w->text(str(i),cog.x,cog.y);
 		}
 	}
 } gui;
 
-void vision_loop() {
-	gui.vision_loop();
-  Thread::msleep(100);
-}
-
 void init() {
 	gui.init();
+	gui.startPipeline();
 }
 
 int main(int n, char **args) {
 	paex("-input","define input grabber e.g. -input dc 0 or -input file images/*.ppm");
-	return ICLApplication(n, args, "-input(2) -size(1)", init, vision_loop).exec();
+	ICLApplication app(n, args, "-input(2) -size(1)", init);
+	int result = app.exec();
+	gui.stopPipeline();
+	return result;
 }
@@ -0,0 +1,93 @@
+// Copyright 2009 Erik Weitnauer
+/// Checks that segmenting with the image pyramid gives the same blobs as at full resolution.
+/**
+ * A synthetic image with a square, a triangle and a parallelogram on a noisy
+ * background is segmented with pyramid factors 1, 2 and 4 and two threshold
+ * settings. For each blob of the full resolution, there must be a blob with
+ * the same size and boundary in the results of the reduced images. The exit
+ * code is 1 if any blob differs.
+ *
+ * usage: test_pyramid
+ */
+
+#include <ICLQuick/Common.h>
+#include <cstdlib>
+#include "tangram_vision_pipeline.h"
+
+/// Sets the pixels inside the polygon to the color, using the pixel centers.
+void fillPolygon(Img8u &image, const float *px, const float *py, int n, const icl8u color[3]) {
+  for (int y=0; y<image.getHeight(); y++) {
+    for (int x=0; x<image.getWidth(); x++) {
+      bool inside = false;
+      float cx = x+0.5, cy = y+0.5;
+      for (int i=0, j=n-1; i<n; j=i++) {
+        if ((py[i] > cy) != (py[j] > cy) && cx < (px[j]-px[i])*(cy-py[i])/(py[j]-py[i])+px[i]) inside = !inside;
+      }
+      if (!inside) continue;
+      for (int c=0; c<3; c++) image.getData(c)[y*image.getWidth()+x] = color[c];
+    }
+  }
+}
+
+void createImage(Img8u &image) {
+  image = Img8u(Size(640,480), formatRGB);
+  srand(1);
+  for (int c=0; c<3; c++) {
+    icl8u *data = image.getData(c);
+    for (int i=0; i<image.getDim(); i++) data[i] = 60 + rand()%20;
+  }
+  icl8u red[] = {200, 40, 40};
+  float sx[] = {100, 196, 196, 100}, sy[] = {100, 100, 196, 196};
+  fillPolygon(image, sx, sy, 4, red);
+  float tx[] = {300, 440, 370}, ty[] = {120, 150, 260};
+  fillPolygon(image, tx, ty, 3, red);
+  float px[] = {420, 540, 580, 460}, py[] = {320, 300, 380, 400};
+  fillPolygon(image, px, py, 4, red);
+}
+
+vector<Blob> segment(const Img8u &image, VisionConfig config, int factor) {
+  config.pyramid_factor = factor;
+  TangramVisionPipeline vision(1);
+  vision.setConfig(config);
+  VisionFrame frame;
+  frame.id = 0;
+  image.deepCopy(&frame.image);
+  vision.segment(frame);
+  return frame.blobs;
+}
+
+/// Returns the number of blobs of 'expected' without an identical blob in 'blobs'.
+int countDifferences(const vector<Blob> &expected, const vector<Blob> &blobs) {
+  int differences = 0;
+  for (unsigned int i=0; i<expected.size(); i++) {
+    bool found = false;
+    for (unsigned int j=0; j<blobs.size() && !found; j++) {
+      found = blobs[j].size == expected[i].size && blobs[j].boundary == expected[i].boundary;
+    }
+    if (!found) differences++;
+  }
+  return differences + max(0, (int)blobs.size() - (int)expected.size());
+}
+
+int main() {
+  Img8u image;
+  createImage(image);
+  VisionConfig config;
+  config.ref_color[0] = 200; config.ref_color[1] = 40; config.ref_color[2] = 40;
+  int settings[][2] = {{50, 100}, {-10, 35}}; // threshold, mask size
+  int failures = 0;
+  for (int s=0; s<2; s++) {
+    config.threshold = settings[s][0];
+    config.mask_size = settings[s][1];
+    vector<Blob> expected = segment(image, config, 1);
+    for (int factor=2; factor<=4; factor*=2) {
+      vector<Blob> blobs = segment(image, config, factor);
+      int differences = countDifferences(expected, blobs);
+      cout << "threshold " << config.threshold << ", mask size " << config.mask_size << ", factor " << factor
+           << ": " << blobs.size() << " of " << expected.size() << " blobs, "
+           << differences << " differ" << (differences ? ", FAILED" : ", ok") << endl;
+      if (differences) failures++;
+    }
+  }
+  return failures ? 1 : 0;
+}
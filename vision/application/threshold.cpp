@@ -23,10 +23,11 @@ const Img8u &thresh(const Img8u &input, icl8u t){
   result.setSize(input.getSize());
   
   int t3 = 3*t;
-  for(int x=0;x<input.getWidth();++x){
-    for(int y=0;y<input.getHeight();++y){
-      result(x,y,0) = 255*((input(x,y,0)+input(x,y,1)+input(x,y,2))>t3);
-    }
+  // walk through the channels in memory order
+  const icl8u *r = input.getData(0), *g = input.getData(1), *b = input.getData(2);
+  icl8u *dst = result.getData(0);
+  for(int i=0;i<input.getDim();++i){
+    dst[i] = 255*((r[i]+g[i]+b[i])>t3);
   }
   return result;
 }
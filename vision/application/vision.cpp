@@ -7,11 +7,6 @@
 
 TangramGui gui;
 
-void vision_loop() {
-	gui.vision_loop();
-  Thread::msleep(100);
-}
-
 void init() {
 	gui.init();
 	if (pa("-grid")) {
@@ -31,6 +26,7 @@ void init() {
 		PlaneEquation z_plane(Vec(0,0,gui.getTangramHeight()),Vec(0,0,1));
 	  gui.setCameraTransformer(CameraTransformer(cam, z_plane));
 	}
+	gui.startPipeline();
 }
 
 int main(int n, char **args) {
@@ -39,6 +35,10 @@ int main(int n, char **args) {
 	paex("-cam-cfg","camera configuration file for screen to world transformation");
 	paex("-tangram-cfg","xml file describing the polygon classes for classifying");
 	paex("-grid x","draw grid with a line every x mm");
-  return ICLApplication(n, args, "-input|-i(device-type=dc,device-params=0) -size|-s(Size=VGA) -cam-cfg(1) -tangram-cfg(1) -grid(mm)", init, vision_loop).exec();
+  ICLApplication app(n, args, "-input|-i(device-type=dc,device-params=0) -size|-s(Size=VGA) -cam-cfg(1) -tangram-cfg(1) -grid(mm)", init);
+  int result = app.exec();
+  gui.stopPipeline();
+  cout << gui.getPipeline().getStatistics();
+  return result;
 }
 
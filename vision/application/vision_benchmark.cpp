@@ -0,0 +1,204 @@
+// Copyright 2009 Erik Weitnauer
+/// Replays recorded frames through the TangramVisionPipeline and times each step.
+/**
+ * All images matching the file pattern are loaded before the timing starts,
+ * so reading and decoding them is not measured. The images are then passed
+ * through the pipeline in order, as if they were grabbed one after the
+ * other, for the passed number of repetitions. The first repetition is run
+ * without measuring, unless -no-warmup is passed.
+ *
+ * For each step of the pipeline (see VisionTimings) and for the whole
+ * frame, the mean, the 50th, 90th and 99th percentile and the maximum time
+ * are printed, as well as the frames per second. With -json, the same
+ * numbers and the configuration are written to a file, so the results of
+ * different builds can be compared.
+ *
+ * The corner detection uses one thread by default, so the times are
+ * reproducible. Pass -threads 0 to use one thread per core.
+ *
+ * usage: vision_benchmark -input file 'images/frame_*.ppm' -ref-color 200 40 40 -json result.json
+ */
+
+#include <ICLQuick/Common.h>
+#include <ICLIO/FileList.h>
+#include <ICLUtils/Time.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include "tangram_vision_pipeline.h"
+
+/// Times of one step in ms for all measured frames.
+struct Step {
+  Step(const string &name): name(name) {}
+  string name;
+  vector<float> ms;
+
+  float mean() const {
+    double sum = 0;
+    for (unsigned int i=0; i<ms.size(); i++) sum += ms[i];
+    return ms.empty() ? 0 : sum/ms.size();
+  }
+  /// p in [0,100], the values must be sorted.
+  float percentile(float p) const {
+    if (ms.empty()) return 0;
+    int i = (int)ceil(p/100*ms.size())-1;
+    return ms[max(0, min((int)ms.size()-1, i))];
+  }
+};
+
+/// Returns the string with quotes, backslashes and control characters escaped for JSON.
+string escapeJSON(const string &s) {
+  string result;
+  for (unsigned int i=0; i<s.size(); i++) {
+    unsigned char c = s[i];
+    if (c == '"' || c == '\\') result += string("\\") + s[i];
+    else if (c < 0x20) {
+      char code[8];
+      sprintf(code, "\\u%04x", c);
+      result += code;
+    } else result += s[i];
+  }
+  return result;
+}
+
+int main(int n, char **args) {
+  paex("-input","recorded frames, e.g. -input file 'images/*.ppm'");
+  paex("-ref-color","rgb color of the tangrams");
+  paex("-repetitions","how often all frames are replayed, default: 5");
+  paex("-no-warmup","measure the first repetition, too");
+  paex("-threads","threads of the corner detection, 0 for one per core, default: 1");
+  paex("-pyramid","segmentation resolution 1, 2 or 4, see BasicCornerDetectionGui");
+  paex("-skip-unchanged","reuse the segmentation of unchanged tiles");
+  paex("-region-cache","reuse the corners of unchanged regions");
+  paex("-tangram-cfg","xml file describing the polygon classes for classifying");
+  paex("-json","write the results to this file");
+  painit(n,args,"-input|-i(2) -ref-color(3) -repetitions|-r(int=5) "
+         "-no-warmup -threads(int=1) -tile-size(float=96) -threshold(int=50) -mask-size(int=100) "
+         "-pyramid(int=1) -skip-unchanged -region-cache -tangram-cfg(1) -json(1)");
+
+  if (pa("-input",0).as<string>() != "file") {
+    cerr << "only recorded frames can be replayed, use -input file <pattern>" << endl;
+    return 1;
+  }
+  string pattern = pa("-input",1).as<string>();
+  FileList files(pattern);
+  vector<Img8u> images;
+  for (int i=0; i<files.size(); i++) {
+    Img8u image;
+    try {
+      FileGrabber grabber(files[i]);
+      grabber.setDesiredDepth(depth8u);
+      grabber.grab()->asImg<icl8u>()->deepCopy(&image);
+    } catch (ICLException &e) {
+      cerr << "could not read image from " << files[i] << endl;
+      continue;
+    }
+    images.push_back(image);
+  }
+  if (images.empty()) {
+    cerr << "no images match " << pattern << endl;
+    return 1;
+  }
+
+  VisionConfig config;
+  if (pa("-ref-color")) {
+    for (int i=0; i<3; i++) config.ref_color[i] = pa("-ref-color",i).as<double>();
+  }
+  config.tile_size = pa("-tile-size").as<float>();
+  config.threshold = pa("-threshold").as<int>();
+  config.mask_size = pa("-mask-size").as<int>();
+  config.pyramid_factor = pa("-pyramid").as<int>();
+  if (pa("-skip-unchanged")) config.skip_unchanged = true;
+  if (pa("-region-cache")) config.region_cache = true;
+
+  TangramVisionPipeline vision(pa("-threads").as<int>());
+  vision.setConfig(config);
+  if (pa("-tangram-cfg")) vision.loadShapesFromXMLFile(*pa("-tangram-cfg"));
+  else vision.loadStandardTangramShapes();
+
+  const char *names[] = {"color_distance", "threshold", "regions", "thinning", "css",
+                         "tracking", "classification", "mapping", "frame"};
+  vector<Step> steps;
+  for (int i=0; i<9; i++) steps.push_back(Step(names[i]));
+  int repetitions = max(1, pa("-repetitions").as<int>());
+  bool warmup = !pa("-no-warmup");
+  long long blobs = 0, corners = 0, polygons = 0;
+  double total_ms = 0;
+  int frame_id = 0;
+  VisionResult result;
+  for (int r=warmup ? -1 : 0; r<repetitions; r++) {
+    for (unsigned int i=0; i<images.size(); i++) {
+      VisionFrame frame;
+      frame.id = frame_id++;
+      images[i].deepCopy(&frame.image);
+      Time start = Time::now();
+      vision.process(frame, result);
+      float ms = (Time::now()-start).toMicroSecondsDouble()/1000;
+      if (r < 0) continue;
+      const VisionTimings &t = result.timings;
+      float step_ms[] = {t.color_distance, t.threshold, t.regions, t.thinning, t.css,
+                         t.tracking, t.classification, t.mapping, ms};
+      for (int k=0; k<9; k++) steps[k].ms.push_back(step_ms[k]);
+      total_ms += ms;
+      blobs += frame.blobs.size();
+      for (unsigned int k=0; k<result.corners.size(); k++) corners += result.corners[k].size();
+      for (unsigned int k=0; k<result.polygons.size(); k++)
+        if (result.polygons[k].isActive(result.timestep)) polygons++;
+    }
+  }
+  for (unsigned int i=0; i<steps.size(); i++) sort(steps[i].ms.begin(), steps[i].ms.end());
+  int frames = steps.back().ms.size();
+  float fps = total_ms > 0 ? 1000*frames/total_ms : 0;
+
+  cout << images.size() << " images of " << images[0].getSize() << ", " << frames << " frames measured" << endl;
+  cout << "per frame: " << float(blobs)/frames << " blobs, " << float(corners)/frames << " corners, "
+       << float(polygons)/frames << " active polygons" << endl;
+  cout << setw(16) << left << "step [ms]" << right << setw(10) << "mean" << setw(10) << "p50"
+       << setw(10) << "p90" << setw(10) << "p99" << setw(10) << "max" << endl;
+  cout << fixed << setprecision(3);
+  for (unsigned int i=0; i<steps.size(); i++) {
+    const Step &s = steps[i];
+    cout << setw(16) << left << s.name << right << setw(10) << s.mean() << setw(10) << s.percentile(50)
+         << setw(10) << s.percentile(90) << setw(10) << s.percentile(99) << setw(10) << s.percentile(100) << endl;
+  }
+  cout << "fps: " << fps << endl;
+
+  if (pa("-json")) {
+    string filename = pa("-json").as<string>();
+    ofstream out(filename.c_str());
+    if (!out) {
+      cerr << "could not write " << filename << endl;
+      return 1;
+    }
+    out << "{" << endl;
+    out << "  \"input\": \"" << escapeJSON(pattern) << "\"," << endl;
+    out << "  \"images\": " << images.size() << "," << endl;
+    out << "  \"width\": " << images[0].getWidth() << ", \"height\": " << images[0].getHeight() << "," << endl;
+    out << "  \"frames\": " << frames << "," << endl;
+    out << "  \"config\": {\"threads\": " << pa("-threads").as<int>() << ", \"pyramid\": " << config.pyramid_factor
+        << ", \"skip_unchanged\": " << (config.skip_unchanged ? "true" : "false")
+        << ", \"region_cache\": " << (config.region_cache ? "true" : "false")
+#ifdef __SSE2__
+        << ", \"sse2\": true},"
+#else
+        << ", \"sse2\": false},"
+#endif
+        << endl;
+    out << fixed << setprecision(4);
+    out << "  \"fps\": " << fps << "," << endl;
+    out << "  \"blobs_per_frame\": " << float(blobs)/frames << "," << endl;
+    out << "  \"corners_per_frame\": " << float(corners)/frames << "," << endl;
+    out << "  \"polygons_per_frame\": " << float(polygons)/frames << "," << endl;
+    out << "  \"steps_ms\": {" << endl;
+    for (unsigned int i=0; i<steps.size(); i++) {
+      const Step &s = steps[i];
+      out << "    \"" << s.name << "\": {\"mean\": " << s.mean() << ", \"p50\": " << s.percentile(50)
+          << ", \"p90\": " << s.percentile(90) << ", \"p99\": " << s.percentile(99)
+          << ", \"max\": " << s.percentile(100) << "}" << (i+1 < steps.size() ? "," : "") << endl;
+    }
+    out << "  }" << endl << "}" << endl;
+  }
+  return 0;
+}
@@ -2,119 +2,129 @@
 #include "basic_corner_detection_gui.h"
 #include <ICLCore/Line.h>
 #include <ICLQuick/Common.h>
-#include <ICLUtils/StackTimer.h>
-#include <ICLCore/CornerDetectorCSS.h>
 
 using namespace std;
 using namespace icl;
 
-
-const vector< Point32f > &getThinnedBoundary(const vector< Point > &b) {
-  static vector< Point32f > thinned;
-  thinned.clear();
-  if (b.size() < 2) return thinned;
-  Point pre = b[b.size()-2];
-  Point cur = b[b.size()-1];
-  Point post; 
-  for (unsigned i=0; i < b.size(); i++) {
-    // search for the first point not in the 8 neighbourhood of current point
-    if ((abs(b[i].x - cur.x) > 1) || (abs(b[i].y - cur.y) > 1)) {
-      thinned.push_back((Point32f)cur);
-      pre = cur;
-      cur = post;
-      post = b[i];
-    } else post = b[i];
-  }
-  return thinned;
+void BasicCornerDetectionGui::grabFrame(VisionFrame &frame) {
+  const Img8u *image = m_grabber->grab()->asImg<icl8u>();
+  image->deepCopy(&frame.image);
 }
 
-struct ColorDist{
-  float r,g,b;
-  ColorDist(const std::vector<double> &color):
-    r(color.at(0)),g(color.at(1)),b(color.at(2)){}
-  static inline float sqr(float x){ return x*x; }
-  void operator()(const icl8u src[3], icl8u dst[1]) const{
-    *dst = 255.0 - sqrt(sqr(r-src[0])+sqr(g-src[1])+sqr(b-src[2]))/sqrt(3);
-  }
-};
+void BasicCornerDetectionGui::segmentFrame(VisionFrame &frame) {
+  m_vision.setConfig(getConfig());
+  m_vision.segment(frame);
+}
 
-const Img8u &create_weight_image(const Img8u &image, const std::vector<double> &color){
-  static Img8u wi(Size(1,1),1);
-  wi.setSize(image.getSize());
-  image.reduce_channels<icl8u,3,1,ColorDist>(wi,ColorDist(color));
-  return wi;
+VisionConfig BasicCornerDetectionGui::getConfig() {
+  VisionConfig c;
+  c.threshold = m_gui.getValue<int>("thresh");
+  c.mask_size = m_gui.getValue<int>("mask-size");
+  c.min_blob_size = m_gui.getValue<int>("min-blob-size");
+  c.max_blob_size = m_gui.getValue<int>("max-blob-size");
+  const std::string &pyramid = m_gui.getValue<std::string>("pyramid");
+  c.pyramid_factor = pyramid == "1/4" ? 4 : (pyramid == "1/2" ? 2 : 1);
+  c.skip_unchanged = m_gui.getValue<bool>("skip-unchanged");
+  c.change_threshold = m_gui.getValue<int>("change-thresh");
+  c.sigma = m_gui.getValue<float>("sigma");
+  c.rc_coeff = m_gui.getValue<float>("rc_coeff");
+  c.curvature_cutoff = m_gui.getValue<float>("k_cutoff");
+  c.max_angle = m_gui.getValue<float>("max_angle");
+  c.straight_line_thresh = m_gui.getValue<float>("straight_line_thresh");
+  c.contour_spacing = m_gui.getValue<float>("contour_spacing");
+  c.region_cache = m_gui.getValue<bool>("region-cache");
+  c.cache_quantization = m_gui.getValue<int>("cache-quantization");
+  Mutex::Locker l(m_thresh_mutex);
+  c.ref_color = m_refColor;
+  return c;
 }
 
-void BasicCornerDetectionGui::vision_loop() {
-  const Img8u *image = m_grabber->grab()->asImg<icl8u>();
-	// get distance image to reference color
- 	m_thresh_mutex.lock();
-  static ImgBase *ltIm = 0;
-  static Img8u wi;
-  std::vector<icl::Region> rs;
-  
-  wi = create_weight_image(*image,m_refColor);
-  m_thresh_mutex.unlock();
-  {
-  BENCHMARK_THIS_FUNCTION;
-  // use the local threshold on that image
-  static LocalThresholdOp lt(35,-10,0);
-  static int &threshold = m_gui.getValue<int>("thresh");
-  static int &maskSize = m_gui.getValue<int>("mask-size");
-  lt.setGlobalThreshold(threshold);
-  lt.setMaskSize(maskSize);
-  lt.apply(&wi,&ltIm);
-
-	static int &min_blob_size = m_gui.getValue<int>("min-blob-size");
-	static int &max_blob_size = m_gui.getValue<int>("max-blob-size");
-  static RegionDetector d(400,100000,255,255);
-  d.setRestrictions(min_blob_size, max_blob_size, 255, 255);
-  rs = d.detect(ltIm);
-	}
+void BasicCornerDetectionGui::showFrame(VisionFrame &frame) {
 	ICLDrawWidget *w = *(*m_h);
   w->lock();
   w->reset();
 	
-	draw(w, rs);
+	draw(w, frame);
 
   w->unlock();
 
   string &vis =  m_gui.getValue<std::string>("vis");
 
-  if (vis == "color image") *m_h = image;
-  else if (vis == "color distance image") *m_h = &wi;
-  else if (vis == "local threshold image") *m_h = ltIm;
+  if (vis == "color image") *m_h = &frame.image;
+  else if (vis == "color distance image") *m_h = &frame.distance_image;
+  else if (vis == "local threshold image") *m_h = &frame.threshold_image;
   else ERROR_LOG("This combobox value is unknown: " + vis);
   m_h->update();
+
+  if (frame.id % 10 == 0 && m_pipeline.isRunning()) {
+  	LabelHandle latency = m_gui.getValue<LabelHandle>("latency-label");
+  	LatencyHistogram h = m_pipeline.getEndToEndLatency();
+  	int unchanged_frames = m_vision.getUnchangedFrameCount();
+  	float unchanged_tiles = 100*m_vision.getUnchangedTileRatio();
+  	latency = "p50: " + str(h.getPercentile(50)) + " ms, p95: " + str(h.getPercentile(95))
+  		+ " ms, dropped: " + str(m_pipeline.getDroppedCount())
+  		+ ", segmented: " + str(round(100*frame.processed_fraction)) + "%"
+  		+ ", skipped frames: " + str(unchanged_frames) + ", skipped tiles: " + str(round(unchanged_tiles)) + "%"
+  		+ ", reused regions: " + str(round(100*m_vision.getRegionCacheHitRatio())) + "%";
+  }
+}
+
+void BasicCornerDetectionGui::vision_loop() {
+	VisionFrame frame;
+	frame.id = m_frame_counter++;
+	frame.grab_time = Time::now();
+	grabFrame(frame);
+	segmentFrame(frame);
+	showFrame(frame);
 }
 
-vector<Point32f> BasicCornerDetectionGui::detectCornersCSS(const icl::Region &r) {
-	const vector<Point32f> &boundary = getThinnedBoundary(r.getBoundary());
-	CornerDetectorCSS detector(
-//	return r.getBoundaryCorners(
-		m_gui.getValue<float>("max_angle"),
-    m_gui.getValue<float>("rc_coeff"),
-    m_gui.getValue<float>("sigma"),
-    m_gui.getValue<float>("k_cutoff"),
-    m_gui.getValue<float>("straight_line_thresh"));
-		return detector.detectCorners(boundary);
+void BasicCornerDetectionGui::grabStage(void *gui, VisionFrame &frame) {
+	((BasicCornerDetectionGui*)gui)->grabFrame(frame);
+}
+
+void BasicCornerDetectionGui::segmentStage(void *gui, VisionFrame &frame) {
+	((BasicCornerDetectionGui*)gui)->segmentFrame(frame);
+}
+
+void BasicCornerDetectionGui::showStage(void *gui, VisionFrame &frame) {
+	((BasicCornerDetectionGui*)gui)->showFrame(frame);
+}
+
+void BasicCornerDetectionGui::startPipeline(int queue_capacity) {
+	if (m_pipeline.getStageCount() == 0) {
+		m_pipeline.addStage("grab", &BasicCornerDetectionGui::grabStage, this);
+		m_pipeline.addStage("segment", &BasicCornerDetectionGui::segmentStage, this);
+		m_pipeline.addStage("draw", &BasicCornerDetectionGui::showStage, this);
+	}
+	m_pipeline.start();
+}
+
+vector<Point32f> BasicCornerDetectionGui::detectCornersCSS(const Blob &blob) {
+	m_vision.setConfig(getConfig());
+	return m_vision.detectCorners(blob);
+}
+
+const CornerDetectionBatch &BasicCornerDetectionGui::detectCornersCSS(const vector<Blob> &blobs) {
+	return m_vision.detectCorners(blobs);
 }
     
-void BasicCornerDetectionGui::draw(ICLDrawWidget *w, const vector<icl::Region> &rs) {
-  // iterate over detected regions
-  for(unsigned int i=0;i<rs.size();++i) {
+void BasicCornerDetectionGui::draw(ICLDrawWidget *w, const VisionFrame &frame) {
+	const vector<Blob> &blobs = frame.blobs;
+	// do the corner detection for all blobs at once
+	const CornerDetectionBatch &batch = detectCornersCSS(blobs);
+  // iterate over detected blobs
+  for(unsigned int i=0;i<blobs.size();++i) {
   	// draw boundary
     w->color(0,255,0,255); w->fill(0,255,0,255);
-    w->points(rs[i].getBoundary());
-  	const vector<Point32f> &boundary = getThinnedBoundary(rs[i].getBoundary());
+    w->points(blobs[i].boundary);
+  	const vector<Point32f> &boundary = batch.getThinnedBoundary(i);
     w->color(255,0,0,255); w->fill(255,0,0,255);
     w->points(boundary);
-    // do the corner detection
-    vector<Point32f> corners = detectCornersCSS(rs[i]);
+    const vector<Point32f> &corners = batch.getCorners(i);
     //cout << "Contour pixels: " << boundary.size() << endl;
     //cout << "Corners: " << corners.size() << endl;
     // draw center of gravity
-    Point32f cog = rs[i].getCOG();
+    Point32f cog = blobs[i].cog;
     w->color(255,0,0,255); w->fill(255,0,0,255);
     w->ellipse(cog.x-1, cog.y-1,2,2);
 		drawCorners(w, corners, Color4D(255,0,0,255), Color4D(255,0,0,150));    
@@ -168,6 +178,7 @@ GUI &BasicCornerDetectionGui::addControls(icl::GUI &gui) {
 	gui << (GUI("hbox") 
 //     			<< create_camcfg(FROM_PROGARG("-input"))
      			<<  "combo(color image,color distance image,local threshold image)[@label=visualization@out=vis]"
+     			<<  "label(-)[@label=end-to-end latency@handle=latency-label]"
          );
 	m_tab = GUI("tab("+m_tab_names+")[@handle=tab]");
 	
@@ -181,6 +192,13 @@ GUI &BasicCornerDetectionGui::addControls(icl::GUI &gui) {
 		<< (GUI("vbox[@label=local threshold]") 
     << "slider(2,800,100)[@out=mask-size@handle=mask-size-handle@label=mask size]"
     << "slider(-200,200,50)[@out=thresh@handle=thresh-handle@label=threshold]");
+	segmentation_controls
+		<< (GUI("vbox[@label=image pyramid]")
+    << "combo(full resolution,1/2,1/4)[@out=pyramid@label=segmentation resolution]");
+	segmentation_controls
+		<< (GUI("vbox[@label=change detection]")
+    << "togglebutton(off,!on)[@out=skip-unchanged@label=skip unchanged tiles]"
+    << "slider(1,50,6)[@out=change-thresh@label=change threshold]");
   m_tab << segmentation_controls;
   
   // add CSS Corner Detection controls
@@ -190,6 +208,9 @@ GUI &BasicCornerDetectionGui::addControls(icl::GUI &gui) {
   css_controls << "fslider(0,1000,100)[@out=k_cutoff@label=curvature cutoff]";
   css_controls << "fslider(0,180,162)[@out=max_angle@label=maximum corner angle]";
   css_controls << "fslider(0,180,10)[@out=straight_line_thresh@label=straight line threshold]";
+  css_controls << "fslider(0,4,0)[@out=contour_spacing@label=contour spacing (0=off)]";
+  css_controls << "togglebutton(off,on)[@out=region-cache@label=reuse results of unchanged regions]";
+  css_controls << "slider(1,4,1)[@out=cache-quantization@label=region cache quantization [px]]";
   m_tab << css_controls;
 
   return m_tab;
@@ -3,16 +3,33 @@
 #define __BASIC_CORNER_DETECTION_GUI_EWEITNAU_H__
 
 #include <ICLQuick/Common.h>
-#include <ICLFilter/LocalThresholdOp.h>
 #include <ICLCC/CC.h>
 #include <ICLCC/Color.h>
-#include <ICLBlob/RegionDetector.h>
+#include "corner_detection_batch.h"
+#include "frame_pipeline.h"
+#include "tangram_vision_pipeline.h"
 
 /// Class to make writing icl GUIs which use the CornerDetectionCSS class more convinient.
 /**
-You need to start a QApplication and then call the vision_loop() method inside
-the ExecThread. You may inherit from the class and override the draw() method.
-As an example for the latter, see vision application.
+You need to start a QApplication, initialize the GUI and then start the
+vision pipeline. It grabs, segments and draws the frames in three threads,
+see FramePipeline. You may inherit from the class and override the draw()
+method. As an example for the latter, see vision application.
+If you need to run code after each frame, call waitForFrame() in a loop.
+
+Instead of the pipeline, the vision_loop() method can be called in a loop
+to do all steps for one frame in the calling thread.
+
+The segmentation and corner detection are done by a TangramVisionPipeline,
+the GUI only passes the values of its controls to it as a VisionConfig, see
+getConfig(), and draws the results.
+
+If "skip unchanged tiles" is enabled in the GUI, a ChangeDetector compares
+each grabbed image with the last ones. If nothing changed, the segmentation
+results of the last frame are reused and VisionFrame::blobs_frame_id is the
+id of that frame. If only some tiles changed, just the area around them is
+segmented again, unless the segmentation is restricted to the tracked
+polygons anyway.
 
 Most basic use case:
 \code
@@ -21,35 +38,50 @@ Most basic use case:
 
 BasicCornerDetectionGui gui;
 
-void vision_loop() {
-	gui.vision_loop();
-  Thread::msleep(10);	
+void init() {
+	gui.init();
+	gui.startPipeline();
 }
 
 int main(int n, char **args) {
-	GenericGrabber::resetBus();  
-  QApplication app(n, args);
-  gui.init(n, args);
-  ExecThread x(vision_loop);
-	x.run();
-	return app.exec();
+	ICLApplication app(n, args, "-input(2) -size(1)", init);
+	int result = app.exec();
+	gui.stopPipeline();
+	return result;
 }
 \endcode
  */
 class BasicCornerDetectionGui : public icl::MouseHandler {
 	public:
 		BasicCornerDetectionGui(): m_gui(icl::GUI("vsplit")), m_refColor(3,255),
-			m_h(NULL), m_grabber(NULL),	m_tab_names("Segmentation,CSS Corner Detection") {}
-		~BasicCornerDetectionGui() { delete m_h; delete m_grabber; }
+			m_h(NULL), m_grabber(NULL),	m_tab_names("Segmentation,CSS Corner Detection"),
+			m_frame_counter(0) {}
+		/// Derived classes must call stopPipeline() in their destructor.
+		~BasicCornerDetectionGui() { stopPipeline(); delete m_h; delete m_grabber; }
 
 		/// Must be called to initialize the GUI.
 		virtual void init();
 		/// Override this method for custom drawing.
-		virtual void draw(icl::ICLDrawWidget *w, const std::vector<icl::Region> &rs);
-		/// The vision_loop method must be called in the main loop.
+		virtual void draw(icl::ICLDrawWidget *w, const VisionFrame &frame);
+		/// Grabs, segments and draws one frame in the calling thread.
 		void vision_loop();
-		/// Convinience method for applying the CSS corner detector on a detected region.
-		std::vector<icl::Point32f> detectCornersCSS(const icl::Region &r);
+
+		/// Starts grabbing, segmenting and drawing in a pipeline of three threads.
+		/** Must be called after init(). */
+		void startPipeline(int queue_capacity=1);
+		/// Stops the pipeline threads after they finished their current frame.
+		void stopPipeline() { m_pipeline.stop(); }
+		/// Waits until the next frame was drawn, returns its id or -1 if the pipeline is not running.
+		int waitForFrame() { return m_pipeline.waitForFrame(); }
+		FramePipeline &getPipeline() { return m_pipeline; }
+
+		/// Convinience method for applying the CSS corner detector on a detected blob.
+		std::vector<icl::Point32f> detectCornersCSS(const Blob &blob);
+		/// Applies the CSS corner detector on all blobs in parallel.
+		/** The results for blob i are accessed with getCorners(i) and
+		 * getCornerAngles(i) of the returned batch, which is valid until the
+		 * next call. */
+		const CornerDetectionBatch &detectCornersCSS(const std::vector<Blob> &blobs);
 		
 	protected:
 		icl::GUI m_gui;
@@ -58,6 +90,7 @@ class BasicCornerDetectionGui : public icl::MouseHandler {
 		icl::DrawHandle *m_h;
 		icl::GenericGrabber *m_grabber;
 		std::string m_tab_names;
+		TangramVisionPipeline m_vision;
 
 		virtual GUI &addControls(icl::GUI &gui);
 		
@@ -68,9 +101,26 @@ class BasicCornerDetectionGui : public icl::MouseHandler {
 	  
 	  int getSelectedTabIndex();
 
+		/// Grabs the next image into the frame.
+		void grabFrame(VisionFrame &frame);
+		/// Calculates the color distance and threshold images and detects the blobs.
+		void segmentFrame(VisionFrame &frame);
+		/// Calls draw() and shows the selected image of the frame.
+		void showFrame(VisionFrame &frame);
+
+		/// Returns the parameters set in the GUI.
+		/** Override this method to set additional parameters. */
+		virtual VisionConfig getConfig();
+
 	private:
+		static void grabStage(void *gui, VisionFrame &frame);
+		static void segmentStage(void *gui, VisionFrame &frame);
+		static void showStage(void *gui, VisionFrame &frame);
+
 		icl::GUI m_tab;
 		icl::TabHandle m_tab_handle;
+		FramePipeline m_pipeline;
+		int m_frame_counter; ///< frame ids for vision_loop()
 };
 
 #endif /* __BASIC_CORNER_DETECTION_GUI_EWEITNAU_H__ */
@@ -0,0 +1,160 @@
+// Copyright 2009 Erik Weitnauer
+#include "blob_detector.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace icl;
+
+// the 8 neighbours in clockwise order, starting east (y axis pointing down)
+static const int DX[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+static const int DY[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+BlobDetector::BlobDetector(int min_size, int max_size, icl8u value):
+	m_min_size(min_size), m_max_size(max_size), m_value(value),
+	m_width(0), m_height(0), m_components(0) {}
+
+const vector<Blob> &BlobDetector::detect(const Img8u &image) {
+	detect(image.getData(0), image.getWidth(), image.getHeight(), image.getWidth(), m_blobs);
+	return m_blobs;
+}
+
+void BlobDetector::detect(const icl8u *data, int width, int height, int line_step, vector<Blob> &blobs) {
+	m_width = width;
+	m_height = height;
+	m_runs.clear();
+	m_row_start.resize(height+1);
+	m_parent.clear();
+	m_sums.clear();
+
+	for (int y=0; y<height; y++) {
+		m_row_start[y] = m_runs.size();
+		extractRuns(data + y*line_step, width, y);
+		// initialize the new runs as sets of their own
+		for (unsigned int i=m_row_start[y]; i<m_runs.size(); i++) {
+			const Run &r = m_runs[i];
+			int len = r.x1-r.x0;
+			Component c = { len, 0.5*len*(r.x0+r.x1-1), (double)len*y };
+			m_parent.push_back(i);
+			m_sums.push_back(c);
+		}
+		if (y == 0) continue;
+		// join with the overlapping runs of the previous row
+		int j = m_row_start[y-1], prev_end = m_row_start[y];
+		for (unsigned int i=m_row_start[y]; i<m_runs.size(); i++) {
+			while (j < prev_end && m_runs[j].x1 <= m_runs[i].x0) j++;
+			for (int k=j; k<prev_end && m_runs[k].x0 < m_runs[i].x1; k++) unite(i, k);
+		}
+	}
+	m_row_start[height] = m_runs.size();
+
+	// flatten the sets, the parent of a run always has a smaller index
+	for (unsigned int i=0; i<m_runs.size(); i++) m_parent[i] = m_parent[m_parent[i]];
+
+	// trace only the components that pass the size filter
+	int n = 0;
+	m_components = 0;
+	for (unsigned int i=0; i<m_runs.size(); i++) {
+		if (m_parent[i] != (int)i) continue;
+		m_components++;
+		const Component &c = m_sums[i];
+		if (c.size < m_min_size || c.size > m_max_size) continue;
+		if ((int)blobs.size() <= n) blobs.resize(n+1);
+		Blob &blob = blobs[n++];
+		blob.size = c.size;
+		blob.cog = Point32f(c.sum_x/c.size, c.sum_y/c.size);
+		traceBoundary(i, blob.boundary);
+	}
+	blobs.resize(n);
+}
+
+void BlobDetector::extractRuns(const icl8u *row, int width, int y) {
+	int x = 0;
+#ifdef __SSE2__
+	const __m128i value = _mm_set1_epi8((char)m_value);
+#endif
+	while (x < width) {
+		// skip the background
+#ifdef __SSE2__
+		while (x+16 <= width && _mm_movemask_epi8(_mm_cmpeq_epi8(
+			_mm_loadu_si128((const __m128i*)(row+x)), value)) == 0) x += 16;
+#endif
+		while (x < width && row[x] != m_value) x++;
+		if (x == width) break;
+		Run r;
+		r.x0 = x;
+		r.y = y;
+#ifdef __SSE2__
+		while (x+16 <= width && _mm_movemask_epi8(_mm_cmpeq_epi8(
+			_mm_loadu_si128((const __m128i*)(row+x)), value)) == 0xFFFF) x += 16;
+#endif
+		while (x < width && row[x] == m_value) x++;
+		r.x1 = x;
+		m_runs.push_back(r);
+	}
+}
+
+int BlobDetector::find(int i) {
+	while (m_parent[i] != i) {
+		m_parent[i] = m_parent[m_parent[i]];
+		i = m_parent[i];
+	}
+	return i;
+}
+
+void BlobDetector::unite(int a, int b) {
+	a = find(a);
+	b = find(b);
+	if (a == b) return;
+	if (b < a) swap(a, b);
+	m_parent[b] = a;
+	m_sums[a].size += m_sums[b].size;
+	m_sums[a].sum_x += m_sums[b].sum_x;
+	m_sums[a].sum_y += m_sums[b].sum_y;
+}
+
+bool BlobDetector::contains(int x, int y, int root) const {
+	if (x < 0 || y < 0 || x >= m_width || y >= m_height) return false;
+	// binary search for the last run of the row starting at or before x
+	int lo = m_row_start[y], hi = m_row_start[y+1];
+	while (lo < hi) {
+		int mid = (lo+hi)/2;
+		if (m_runs[mid].x0 <= x) lo = mid+1;
+		else hi = mid;
+	}
+	if (lo == m_row_start[y]) return false;
+	const Run &r = m_runs[lo-1];
+	return x < r.x1 && m_parent[lo-1] == root;
+}
+
+// Moore neighbour tracing with Jacob's stopping criterion. The root run is
+// the first run of the component, so its first pixel has no neighbours in
+// the row above and to the left.
+void BlobDetector::traceBoundary(int root, vector<Point> &boundary) const {
+	Point start(m_runs[root].x0, m_runs[root].y);
+	boundary.clear();
+	boundary.push_back(start);
+	Point p = start;
+	int dir = 6; // as if we came from below, so the search starts west
+	int first_dir = -1;
+	// each boundary pixel is visited at most four times
+	int max_steps = 4*m_sums[root].size + 4;
+	for (int step=0; step<max_steps; step++) {
+		// search clockwise, starting behind the background pixel checked last
+		int next = -1;
+		for (int k=0; k<8; k++) {
+			int d = (dir+6+k) & 7;
+			if (contains(p.x+DX[d], p.y+DY[d], root)) { next = d; break; }
+		}
+		if (next == -1) return; // single pixel
+		if (first_dir == -1) first_dir = next;
+		else if (p == start && next == first_dir) {
+			boundary.pop_back();
+			return;
+		}
+		p = Point(p.x+DX[next], p.y+DY[next]);
+		dir = next;
+		boundary.push_back(p);
+	}
+}
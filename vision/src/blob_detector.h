@@ -0,0 +1,88 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __BLOB_DETECTOR_EWEITNAU_H__
+#define __BLOB_DETECTOR_EWEITNAU_H__
+
+#include <ICLCore/Img.h>
+#include <vector>
+#include "vision_frame.h"
+
+/// Detects the connected components of a binary image.
+/**
+ The pixels with the foreground value are collected as horizontal runs, using
+ SSE2 to skip 16 pixels at once if available. Runs of neighbouring rows that
+ overlap are joined with a union-find structure, which also sums up the size
+ and the center of gravity of each component. So the components are
+ 4-connected like the regions of the icl::RegionDetector.
+
+ Only for the components with a size in [min_size, max_size] the boundary is
+ traced, which is the expensive part of the icl::RegionDetector. The boundary
+ is the closed, 8-connected outer contour in clockwise order (y axis pointing
+ down), starting at the topmost, leftmost pixel. The last point is a neighbour
+ of the first one and the first point is not repeated. Holes and background
+ pixels that touch the outside only diagonally are not part of it.
+
+ All buffers, including the boundaries of the returned blobs, are reused from
+ call to call.
+
+ Usage example:
+ \code
+ BlobDetector d(400, 100000);
+ const vector<Blob> &blobs = d.detect(threshold_image);
+ for (unsigned int i=0; i<blobs.size(); i++) draw(blobs[i].boundary);
+ \endcode
+*/
+class BlobDetector {
+	public:
+		BlobDetector(int min_size=400, int max_size=100000, icl::icl8u value=255);
+
+		/// Only components with min_size <= size <= max_size are returned.
+		void setRestrictions(int min_size, int max_size) { m_min_size = min_size; m_max_size = max_size; }
+		/// Pixels with this value are foreground, all others background.
+		void setValue(icl::icl8u value) { m_value = value; }
+
+		/// Detects the blobs in the first channel of the image.
+		/** The returned vector is valid until the next call. */
+		const std::vector<Blob> &detect(const icl::Img8u &image);
+
+		/// Detects the blobs in the image data of size width x height.
+		/** Rows start line_step bytes apart. The blobs are written to 'blobs'. */
+		void detect(const icl::icl8u *data, int width, int height, int line_step, std::vector<Blob> &blobs);
+
+		/// Number of runs of the last detect() call.
+		int getRunCount() const { return m_runs.size(); }
+		/// Number of components of the last detect() call, including the filtered ones.
+		int getComponentCount() const { return m_components; }
+
+	private:
+		struct Run {
+			int x0, x1; ///< pixels x0 to x1-1
+			int y;
+		};
+
+		/// Sums of a component, only valid for root runs.
+		struct Component {
+			int size;
+			double sum_x, sum_y;
+		};
+
+		/// Appends the foreground runs of one row to m_runs.
+		void extractRuns(const icl::icl8u *row, int width, int y);
+		int find(int i);
+		void unite(int a, int b);
+		/// Whether pixel (x,y) belongs to the component whose root run is 'root'.
+		bool contains(int x, int y, int root) const;
+		/// Writes the outer contour of the component with the root run 'root'.
+		void traceBoundary(int root, std::vector<icl::Point> &boundary) const;
+
+		int m_min_size, m_max_size;
+		icl::icl8u m_value;
+		int m_width, m_height;
+		int m_components;
+		std::vector<Run> m_runs;
+		std::vector<int> m_row_start; ///< index of the first run of each row, and of the end
+		std::vector<int> m_parent; ///< the root of each set is its run with the smallest index
+		std::vector<Component> m_sums;
+		std::vector<Blob> m_blobs;
+};
+
+#endif /* __BLOB_DETECTOR_EWEITNAU_H__ */
@@ -0,0 +1,29 @@
+// Copyright 2009 Erik Weitnauer
+#include "boundary_thinning.h"
+#include <cstdlib>
+
+using namespace std;
+using namespace icl;
+
+int thinBoundary(const Point *b, int n, Point32f *thinned) {
+	if (n < 2) return 0;
+	int count = 0;
+	Point cur = b[n-1];
+	Point post = cur;
+	for (int i=0; i<n; i++) {
+		// search for the first point not in the 8 neighbourhood of current point
+		if ((abs(b[i].x - cur.x) > 1) || (abs(b[i].y - cur.y) > 1)) {
+			thinned[count++] = Point32f(cur.x, cur.y);
+			cur = post;
+		}
+		post = b[i];
+	}
+	return count;
+}
+
+void getThinnedBoundary(const vector<Point> &b, vector<Point32f> &thinned) {
+	// the thinned boundary has at most as many points as the boundary
+	thinned.resize(b.size());
+	if (b.empty()) return;
+	thinned.resize(thinBoundary(&b[0], b.size(), &thinned[0]));
+}
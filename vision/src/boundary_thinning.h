@@ -0,0 +1,24 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __BOUNDARY_THINNING_EWEITNAU_H__
+#define __BOUNDARY_THINNING_EWEITNAU_H__
+
+#include <ICLUtils/Point.h>
+#include <ICLUtils/Point32f.h>
+#include <vector>
+
+/// Thins the closed boundary b of n points and writes the result to 'thinned'.
+/** Only every point that is not in the 8-neighbourhood of the last kept
+ * point is kept, so the result is an ordered contour without the pixel
+ * steps, as needed by CornerDetectorCSS::detectCorners(). 'thinned' must
+ * have room for n points. Returns the number of written points.
+ *
+ * The function has no state, so it can be called from several threads
+ * at the same time with different output buffers. */
+int thinBoundary(const icl::Point *b, int n, icl::Point32f *thinned);
+
+/// Writes the thinned version of the boundary b to 'thinned'.
+/** The vector is resized to the number of points, its memory is reused
+ * if it is big enough. See thinBoundary(). */
+void getThinnedBoundary(const std::vector<icl::Point> &b, std::vector<icl::Point32f> &thinned);
+
+#endif /* __BOUNDARY_THINNING_EWEITNAU_H__ */
@@ -0,0 +1,114 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __BOUNDED_QUEUE_EWEITNAU_H__
+#define __BOUNDED_QUEUE_EWEITNAU_H__
+
+#include <deque>
+#include <pthread.h>
+
+/// Thread-safe FIFO queue with a maximum size, which drops the oldest items.
+/** push() never blocks. If the queue is full, the oldest item is removed
+ * and handed back to the caller, who is responsible for freeing it. So a
+ * slow consumer always gets the most recent items. pop() waits until an item
+ * is available or the queue was closed. */
+template <class T>
+class BoundedQueue {
+	public:
+		BoundedQueue(int capacity): m_capacity(capacity < 1 ? 1 : capacity),
+			m_dropped(0), m_closed(false) {
+			pthread_mutex_init(&m_mutex, NULL);
+			pthread_cond_init(&m_cond, NULL);
+		}
+		~BoundedQueue() {
+			pthread_cond_destroy(&m_cond);
+			pthread_mutex_destroy(&m_mutex);
+		}
+
+		/// Appends the item, returns true if the oldest item had to be removed.
+		/** The removed item is written to 'dropped'. */
+		bool push(const T &item, T &dropped) {
+			bool full;
+			pthread_mutex_lock(&m_mutex);
+			full = (int)m_items.size() >= m_capacity;
+			if (full) {
+				dropped = m_items.front();
+				m_items.pop_front();
+				m_dropped++;
+			}
+			m_items.push_back(item);
+			pthread_cond_signal(&m_cond);
+			pthread_mutex_unlock(&m_mutex);
+			return full;
+		}
+
+		/// Waits for the next item, returns false if the queue was closed.
+		bool pop(T &item) {
+			pthread_mutex_lock(&m_mutex);
+			while (m_items.empty() && !m_closed) pthread_cond_wait(&m_cond, &m_mutex);
+			bool ok = !m_closed;
+			if (ok) {
+				item = m_items.front();
+				m_items.pop_front();
+			}
+			pthread_mutex_unlock(&m_mutex);
+			return ok;
+		}
+
+		/// Removes the next item without waiting, returns false if the queue is empty.
+		/** Can be used to free the remaining items after closing the queue. */
+		bool tryPop(T &item) {
+			pthread_mutex_lock(&m_mutex);
+			bool ok = !m_items.empty();
+			if (ok) {
+				item = m_items.front();
+				m_items.pop_front();
+			}
+			pthread_mutex_unlock(&m_mutex);
+			return ok;
+		}
+
+		/// Wakes up all waiting consumers, after this pop() always returns false.
+		void close() {
+			pthread_mutex_lock(&m_mutex);
+			m_closed = true;
+			pthread_cond_broadcast(&m_cond);
+			pthread_mutex_unlock(&m_mutex);
+		}
+
+		/// Reopens a closed queue.
+		void open() {
+			pthread_mutex_lock(&m_mutex);
+			m_closed = false;
+			pthread_mutex_unlock(&m_mutex);
+		}
+
+		int size() {
+			pthread_mutex_lock(&m_mutex);
+			int n = m_items.size();
+			pthread_mutex_unlock(&m_mutex);
+			return n;
+		}
+
+		int getCapacity() const { return m_capacity; }
+
+		/// Number of items dropped since the queue was created.
+		int getDroppedCount() {
+			pthread_mutex_lock(&m_mutex);
+			int n = m_dropped;
+			pthread_mutex_unlock(&m_mutex);
+			return n;
+		}
+
+	private:
+		// not copyable
+		BoundedQueue(const BoundedQueue &);
+		BoundedQueue &operator=(const BoundedQueue &);
+
+		std::deque<T> m_items;
+		int m_capacity;
+		int m_dropped;
+		bool m_closed;
+		pthread_mutex_t m_mutex;
+		pthread_cond_t m_cond;
+};
+
+#endif /* __BOUNDED_QUEUE_EWEITNAU_H__ */
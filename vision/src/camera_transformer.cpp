@@ -3,45 +3,123 @@
 using namespace std;
 using namespace icl;
 
+CameraTransformer::CameraTransformer(const icl::Camera cam, icl::PlaneEquation plane)
+	: m_camera(cam), m_plane(plane) {
+	pthread_mutex_init(&m_cache_mutex, NULL);
+}
+
+CameraTransformer::CameraTransformer(const CameraTransformer &other)
+	: m_camera(other.m_camera), m_plane(other.m_plane) {
+	pthread_mutex_init(&m_cache_mutex, NULL);
+}
+
+CameraTransformer &CameraTransformer::operator=(const CameraTransformer &other) {
+	if (this == &other) return *this;
+	pthread_mutex_lock(&m_cache_mutex);
+	m_camera = other.m_camera;
+	m_plane = other.m_plane;
+	m_world_to_screen.clear();
+	m_screen_to_world.clear();
+	pthread_mutex_unlock(&m_cache_mutex);
+	return *this;
+}
+
+CameraTransformer::~CameraTransformer() {
+	pthread_mutex_destroy(&m_cache_mutex);
+}
+
+void CameraTransformer::setPlaneEquation(icl::PlaneEquation value) {
+	pthread_mutex_lock(&m_cache_mutex);
+	m_plane = value;
+	m_screen_to_world.clear();
+	pthread_mutex_unlock(&m_cache_mutex);
+}
+
+bool CameraTransformer::getHomography(map<float,Homography> &cache, bool world_to_screen,
+		float z, Homography &h) const {
+	pthread_mutex_lock(&m_cache_mutex);
+	map<float,Homography>::const_iterator it = cache.find(z);
+	bool found = it != cache.end();
+	if (found) h = it->second;
+	pthread_mutex_unlock(&m_cache_mutex);
+	if (found) return true;
+
+	// transform four points of the table area exactly and fit the homography
+	Point32f world[4], screen[4];
+	float ox = m_plane.offset[0], oy = m_plane.offset[1];
+	float dx[4] = {-500, 500, 500, -500}, dy[4] = {-500, -500, 500, 500};
+	for (int i=0; i<4; i++) {
+		world[i] = Point32f(ox+dx[i], oy+dy[i]);
+		screen[i] = transformedWorldToScreen(Vec(world[i].x, world[i].y, z, 1));
+		if (!world_to_screen) {
+			PlaneEquation plane(Vec(ox, oy, z), m_plane.normal);
+			Vec v = m_camera.getViewRay(screen[i]).getIntersection(plane);
+			world[i] = Point32f(v[0], v[1]);
+		}
+	}
+	if (!(world_to_screen ? h.fit(world, screen) : h.fit(screen, world))) return false;
+
+	pthread_mutex_lock(&m_cache_mutex);
+	if (cache.size() > 32) cache.clear();
+	cache[z] = h;
+	pthread_mutex_unlock(&m_cache_mutex);
+	return true;
+}
+
 icl::Point32f CameraTransformer::transformedWorldToScreen(const icl::Vec &world_pos) const {
 	return m_camera.project(world_pos);
 }
 
 icl::Vec CameraTransformer::transformedScreenToWorld(const icl::Point32f &screen_pos) const {
-	return m_camera.getViewRay(screen_pos).getIntersection(m_plane);
+	return transformedScreenToWorld(screen_pos, m_plane.offset[2]);
 }
 
 icl::Vec CameraTransformer::transformedScreenToWorld(const icl::Point32f &screen_pos, float z) const {
-	icl::Vec result;
-  icl::PlaneEquation plane(icl::Vec(m_plane.offset[0], m_plane.offset[1], z), m_plane.normal);
-	result = m_camera.getViewRay(screen_pos).getIntersection(plane);
-	return result;
+	// the intersection plane goes through (ox, oy, z) with the normal n
+	const Vec &n = m_plane.normal;
+	if (n[2] != 0) {
+		Point32f p;
+		transformScreenToWorld(&screen_pos, &p, 1, z);
+		return Vec(p.x, p.y, z - (n[0]*(p.x-m_plane.offset[0]) + n[1]*(p.y-m_plane.offset[1])) / n[2], 1);
+	}
+	icl::PlaneEquation plane(icl::Vec(m_plane.offset[0], m_plane.offset[1], z), m_plane.normal);
+	return m_camera.getViewRay(screen_pos).getIntersection(plane);
+}
+
+void CameraTransformer::transformWorldToScreen(const Point32f *src, Point32f *dst, int n, float z) const {
+	Homography h;
+	if (getHomography(m_world_to_screen, true, z, h)) {
+		h.transform(src, dst, n);
+		return;
+	}
+	for (int i=0; i<n; ++i) dst[i] = transformedWorldToScreen(Vec(src[i].x, src[i].y, z, 1));
+}
+
+void CameraTransformer::transformScreenToWorld(const Point32f *src, Point32f *dst, int n, float z) const {
+	Homography h;
+	if (getHomography(m_screen_to_world, false, z, h)) {
+		h.transform(src, dst, n);
+		return;
+	}
+	icl::PlaneEquation plane(icl::Vec(m_plane.offset[0], m_plane.offset[1], z), m_plane.normal);
+	for (int i=0; i<n; ++i) {
+		Vec v = m_camera.getViewRay(src[i]).getIntersection(plane);
+		dst[i] = Point32f(v[0], v[1]);
+	}
 }
 
 void CameraTransformer::transformWorldToScreen2D(PolygonShape &shape, float z) const {
 	// we need to transform all corner points and then update the geometry...
 	vector<Point32f> corners = shape.getCorners();
-	vector<Point32f> transformed_corners;
-	for (unsigned int i=0; i<corners.size(); ++i) {
-		Point32f p = transformedWorldToScreen(Vec(corners[i].x, corners[i].y, z, 1));
-		transformed_corners.push_back(p);
-	}
+	if (!corners.empty()) transformWorldToScreen(&corners[0], &corners[0], corners.size(), z);
 	shape.clearCorners();
-	shape.addCorners(transformed_corners);
+	shape.addCorners(corners);
 }
 
 void CameraTransformer::transformScreenToWorld2D(vector<Point32f> &points) const {
-	for (unsigned int i=0; i<points.size(); ++i) {
-		Vec v = transformedScreenToWorld(points[i]);
-		points[i].x = v[0];
-		points[i].y = v[1];
-	}
+	transformScreenToWorld2D(points, m_plane.offset[2]);
 }
 
 void CameraTransformer::transformScreenToWorld2D(vector<Point32f> &points, float height) const {
-	for (unsigned int i=0; i<points.size(); ++i) {
-		Vec v = transformedScreenToWorld(points[i], height);
-		points[i].x = v[0];
-		points[i].y = v[1];
-	}
+	if (!points.empty()) transformScreenToWorld(&points[0], &points[0], points.size(), height);
 }
@@ -5,17 +5,30 @@
 #include <ICLGeom/Camera.h>
 #include <ICLGeom/PlaneEquation.h>
 #include <ICLUtils/Point32f.h>
+#include <map>
+#include <pthread.h>
 
 #include <polygon_shape.h>
+#include "homography.h"
 
+/// Transformations between screen and world coordinates.
+/** World points are restricted to planes, either to the intersection plane
+ * (screen to world) or to horizontal planes at a given z (world to screen).
+ * Both mappings are homographies, which are calculated once per plane from
+ * four exactly transformed points and cached. The batch methods transform
+ * arrays of points with them, the methods for single points and shapes use
+ * the batch methods, too. */
 class CameraTransformer {
 	public:
 		CameraTransformer(const icl::Camera cam = icl::Camera(),
-			icl::PlaneEquation plane=icl::PlaneEquation(icl::Vec(0,0,0),icl::Vec(0,0,1)))
-			: m_camera(cam), m_plane(plane) {};
+			icl::PlaneEquation plane=icl::PlaneEquation(icl::Vec(0,0,0),icl::Vec(0,0,1)));
+		/// Copies camera and plane, the cache of homographies is not copied.
+		CameraTransformer(const CameraTransformer &other);
+		CameraTransformer &operator=(const CameraTransformer &other);
+		~CameraTransformer();
 		
 		/// Sets the plane equation, that will be used for screen to world transformation.
-		void setPlaneEquation(icl::PlaneEquation value) { m_plane = value; }
+		void setPlaneEquation(icl::PlaneEquation value);
 		
 		/// Get the plane equation used for screen to world transformation.
 		inline const icl::PlaneEquation getPlaneEquation() const { return m_plane; }
@@ -41,10 +54,28 @@ class CameraTransformer {
 		/// Inplace transformation of a point vector from screen to world coordinates.
 		/** z value of the intersection plane's offset vector is set to z */
 		void transformScreenToWorld2D(std::vector<icl::Point32f> &points, float z) const;
+
+		/// Transforms n points on the plane at height z from world to screen coordinates.
+		/** src and dst may be the same array. */
+		void transformWorldToScreen(const icl::Point32f *src, icl::Point32f *dst, int n, float z) const;
+
+		/// Transforms n points from screen to the x, y world coordinates on the intersection plane.
+		/** z value of the intersection plane's offset vector is set to z.
+		 * src and dst may be the same array. */
+		void transformScreenToWorld(const icl::Point32f *src, icl::Point32f *dst, int n, float z) const;
 		
 	private:
+		/// Returns the cached homography for the plane at height z or calculates it.
+		/** 'cache' is one of m_world_to_screen and m_screen_to_world. Returns
+		 * false if the homography can't be calculated, e.g. because the camera
+		 * is not initialized, then the exact transformation has to be used. */
+		bool getHomography(std::map<float,Homography> &cache, bool world_to_screen,
+			float z, Homography &h) const;
+
 		icl::Camera m_camera;
 		icl::PlaneEquation m_plane;
+		mutable std::map<float,Homography> m_world_to_screen, m_screen_to_world;
+		mutable pthread_mutex_t m_cache_mutex;
 };
 
 /*
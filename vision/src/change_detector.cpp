@@ -0,0 +1,97 @@
+// Copyright 2009 Erik Weitnauer
+#include "change_detector.h"
+#include <cstdlib>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace icl;
+
+ChangeDetector::ChangeDetector(int tile_size, int threshold):
+	m_tile_size(tile_size), m_threshold(threshold), m_tiles_x(0), m_tiles_y(0),
+	m_unchanged_frames(0), m_unchanged_tiles(0), m_tiles(0) {}
+
+unsigned int ChangeDetector::sad(const icl8u *a, const icl8u *b, int n) {
+	unsigned int sum = 0;
+	int i = 0;
+#ifdef __SSE2__
+	__m128i acc = _mm_setzero_si128();
+	for (; i+16<=n; i+=16) {
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(a+i)),
+			_mm_loadu_si128((const __m128i*)(b+i))));
+	}
+	// the two halves hold the sums of 8 bytes each
+	sum = _mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+#endif
+	for (; i<n; i++) sum += abs(a[i]-b[i]);
+	return sum;
+}
+
+int ChangeDetector::detect(const Img8u &image) {
+	int w = image.getWidth(), h = image.getHeight(), channels = image.getChannels();
+	m_tiles_x = (w+m_tile_size-1) / m_tile_size;
+	m_tiles_y = (h+m_tile_size-1) / m_tile_size;
+	int tiles = m_tiles_x*m_tiles_y;
+	m_tiles += tiles;
+	if (m_reference.getSize() != image.getSize() || m_reference.getChannels() != channels) {
+		image.deepCopy(&m_reference);
+		m_changed.assign(tiles, true);
+		return tiles;
+	}
+
+	m_sums.assign(tiles, 0);
+	for (int c=0; c<channels; c++) {
+		const icl8u *cur = image.getData(c), *ref = m_reference.getData(c);
+		for (int y=0; y<h; y+=2) {
+			unsigned int *sums = &m_sums[(y/m_tile_size)*m_tiles_x];
+			for (int tx=0; tx<m_tiles_x; tx++) {
+				int x0 = tx*m_tile_size, n = min(m_tile_size, w-x0);
+				sums[tx] += sad(cur+y*w+x0, ref+y*w+x0, n);
+			}
+		}
+	}
+
+	int changed = 0;
+	m_changed.resize(tiles);
+	for (int ty=0; ty<m_tiles_y; ty++) {
+		for (int tx=0; tx<m_tiles_x; tx++) {
+			Rect r = getTileRect(tx, ty);
+			// only every second row was compared
+			int pixels = r.width*((r.height+1-(r.y%2))/2)*channels;
+			bool c = m_sums[ty*m_tiles_x+tx] > (unsigned int)(m_threshold*pixels);
+			m_changed[ty*m_tiles_x+tx] = c;
+			if (!c) continue;
+			changed++;
+			// update the reference of the tile
+			for (int ch=0; ch<channels; ch++) {
+				const icl8u *src = image.getData(ch);
+				icl8u *dst = m_reference.getData(ch);
+				for (int y=r.y; y<r.y+r.height; y++) memcpy(dst+y*w+r.x, src+y*w+r.x, r.width);
+			}
+		}
+	}
+	m_unchanged_tiles += tiles-changed;
+	if (changed == 0) m_unchanged_frames++;
+	return changed;
+}
+
+Rect ChangeDetector::getTileRect(int tx, int ty) const {
+	int x = tx*m_tile_size, y = ty*m_tile_size;
+	return Rect(x, y, min(m_tile_size, m_reference.getWidth()-x), min(m_tile_size, m_reference.getHeight()-y));
+}
+
+Rect ChangeDetector::getChangedBoundingBox() const {
+	int x0 = m_tiles_x, y0 = m_tiles_y, x1 = -1, y1 = -1;
+	for (int ty=0; ty<m_tiles_y; ty++) {
+		for (int tx=0; tx<m_tiles_x; tx++) {
+			if (!isChanged(tx, ty)) continue;
+			x0 = min(x0, tx); x1 = max(x1, tx);
+			y0 = min(y0, ty); y1 = max(y1, ty);
+		}
+	}
+	if (x1 < 0) return Rect();
+	Rect a = getTileRect(x0, y0), b = getTileRect(x1, y1);
+	return Rect(a.x, a.y, b.x+b.width-a.x, b.y+b.height-a.y);
+}
@@ -0,0 +1,75 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __CHANGE_DETECTOR_EWEITNAU_H__
+#define __CHANGE_DETECTOR_EWEITNAU_H__
+
+#include <ICLCore/Img.h>
+#include <vector>
+
+/// Finds the tiles of an image that changed since the last frames.
+/**
+ The image is divided into tiles of tile_size x tile_size pixels. For each
+ tile, the mean absolute difference to the reference image is calculated
+ over all channels, on every second row only to save time. A tile changed if
+ the mean difference is bigger than the threshold. The changed tiles are then
+ copied into the reference, the unchanged ones are kept, so a slow drift of
+ the image is noticed eventually.
+
+ The differences are summed up 16 pixels at a time with the SSE2
+ instruction for the sum of absolute differences if available. For a
+ UXGA color image this takes about as long as one copy of the image.
+
+ Usage example:
+ \code
+ ChangeDetector d(32, 6);
+ if (d.detect(image) == 0) reuseLastResults();
+ else for (...) if (d.isChanged(tx, ty)) process(d.getTileRect(tx, ty));
+ \endcode
+*/
+class ChangeDetector {
+	public:
+		ChangeDetector(int tile_size=32, int threshold=6);
+
+		/// Sets the mean absolute difference per pixel and channel above which a tile changed.
+		void setThreshold(int threshold) { m_threshold = threshold; }
+		int getThreshold() const { return m_threshold; }
+		int getTileSize() const { return m_tile_size; }
+
+		/// Compares the image with the reference and returns the number of changed tiles.
+		/** If there is no reference of the same size and channel count, all
+		 * tiles are changed and the image becomes the reference. */
+		int detect(const icl::Img8u &image);
+		/// Forgets the reference, so all tiles are changed in the next detect() call.
+		void reset() { m_reference = icl::Img8u(); }
+
+		int getTilesX() const { return m_tiles_x; }
+		int getTilesY() const { return m_tiles_y; }
+		/// Whether tile (tx, ty) changed in the last detect() call.
+		bool isChanged(int tx, int ty) const { return m_changed[ty*m_tiles_x+tx]; }
+		/// Image area of tile (tx, ty), the tiles at the right and bottom border may be smaller.
+		icl::Rect getTileRect(int tx, int ty) const;
+		/// Bounding box of all tiles that changed in the last detect() call.
+		/** Is empty if no tile changed. */
+		icl::Rect getChangedBoundingBox() const;
+
+		/// Number of detect() calls in which no tile changed.
+		int getUnchangedFrameCount() const { return m_unchanged_frames; }
+		/// Number of tiles that did not change, summed up over all detect() calls.
+		long long getUnchangedTileCount() const { return m_unchanged_tiles; }
+		/// Number of tiles, summed up over all detect() calls.
+		long long getTileCount() const { return m_tiles; }
+
+	private:
+		/// Sum of absolute differences of n bytes.
+		static unsigned int sad(const icl::icl8u *a, const icl::icl8u *b, int n);
+
+		int m_tile_size;
+		int m_threshold;
+		icl::Img8u m_reference;
+		int m_tiles_x, m_tiles_y;
+		std::vector<bool> m_changed;
+		std::vector<unsigned int> m_sums; ///< per tile
+		int m_unchanged_frames;
+		long long m_unchanged_tiles, m_tiles;
+};
+
+#endif /* __CHANGE_DETECTOR_EWEITNAU_H__ */
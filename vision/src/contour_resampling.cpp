@@ -0,0 +1,47 @@
+// Copyright 2009 Erik Weitnauer
+#include "contour_resampling.h"
+#include <cmath>
+
+using namespace std;
+using namespace icl;
+
+namespace {
+	inline float distance(const Point32f &a, const Point32f &b) {
+		return sqrt((b.x-a.x)*(b.x-a.x) + (b.y-a.y)*(b.y-a.y));
+	}
+}
+
+float getContourLength(const vector<Point32f> &c) {
+	int n = c.size();
+	if (n == 0) return 0;
+	double length = distance(c[n-1], c[0]);
+	for (int i=0; i<n-1; i++) length += distance(c[i], c[i+1]);
+	return length;
+}
+
+void resampleContour(const vector<Point32f> &c, float length, int m,
+		vector<Point32f> &resampled, vector<int> &index, int first) {
+	int n = c.size();
+	resampled.resize(m);
+	index.resize(m);
+	if (n == 0 || m == 0) return;
+	double step = length / m;
+	double s0 = 0; // arc length at the start of the current segment
+	double next = 0; // arc length of sample j
+	int j = 0;
+	for (int k=0, i=first; k<n && j<m; k++) {
+		int i1 = (i+1 < n) ? i+1 : 0;
+		const Point32f &a = c[i], &b = c[i1];
+		float d = distance(a, b);
+		// all samples with an arc length inside this segment
+		for (; j<m && next < s0+d; j++, next=j*step) {
+			float t = (next-s0)/d;
+			resampled[j] = Point32f(a.x + t*(b.x-a.x), a.y + t*(b.y-a.y));
+			index[j] = (t < 0.5f) ? i : i1;
+		}
+		s0 += d;
+		i = i1;
+	}
+	// rounding errors may leave samples at the very end of the contour
+	for (; j<m; j++) { resampled[j] = c[first]; index[j] = first; }
+}
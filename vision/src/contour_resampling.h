@@ -0,0 +1,24 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __CONTOUR_RESAMPLING_EWEITNAU_H__
+#define __CONTOUR_RESAMPLING_EWEITNAU_H__
+
+#include <ICLUtils/Point32f.h>
+#include <vector>
+
+/// Length of the closed contour c, including the segment from the last to the first point.
+float getContourLength(const std::vector<icl::Point32f> &c);
+
+/// Resamples the closed contour c to m points with equal arc-length spacing.
+/** 'length' must be the result of getContourLength(c). The first point of
+ * 'resampled' is c[first], the others are interpolated linearly between the
+ * contour points. index[j] is the index of the point of c that is closest
+ * along the contour to resampled[j], so positions found on the resampled
+ * contour can be mapped back to the original one. Both vectors are resized
+ * to m, their memory is reused if it is big enough.
+ *
+ * The function has no state, so it can be called from several threads
+ * at the same time with different output vectors. */
+void resampleContour(const std::vector<icl::Point32f> &c, float length, int m,
+	std::vector<icl::Point32f> &resampled, std::vector<int> &index, int first=0);
+
+#endif /* __CONTOUR_RESAMPLING_EWEITNAU_H__ */
@@ -0,0 +1,154 @@
+// Copyright 2009 Erik Weitnauer
+#include "corner_detection_batch.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+using namespace std;
+using namespace icl;
+
+CornerDetectionBatch::CornerDetectionBatch(int threads): m_pool(threads), m_size(0),
+	m_current(0), m_cache_enabled(false), m_quantization(1), m_cache_lookups(0), m_cache_hits(0) {
+	m_detectors.resize(m_pool.getThreadCount());
+}
+
+void CornerDetectionBatch::setParameters(float angle_thresh, float rc_coeff, float sigma,
+		float curvature_cutoff, float straight_line_thresh, float contour_spacing) {
+	CornerDetectorCSS &d0 = m_detectors[0];
+	if (d0.angle_thresh != angle_thresh || d0.rc_coeff != rc_coeff || d0.sigma != sigma ||
+			d0.curvature_cutoff != curvature_cutoff || d0.straight_line_thresh != straight_line_thresh ||
+			d0.contour_spacing != contour_spacing) clearCache();
+	for (unsigned int i=0; i<m_detectors.size(); i++) {
+		CornerDetectorCSS &d = m_detectors[i];
+		d.angle_thresh = angle_thresh;
+		d.rc_coeff = rc_coeff;
+		d.sigma = sigma;
+		d.curvature_cutoff = curvature_cutoff;
+		d.straight_line_thresh = straight_line_thresh;
+		d.contour_spacing = contour_spacing;
+	}
+}
+
+void CornerDetectionBatch::setCache(bool enabled, int quantization) {
+	if (enabled != m_cache_enabled || max(1, quantization) != m_quantization) clearCache();
+	m_cache_enabled = enabled;
+	m_quantization = max(1, quantization);
+}
+
+void CornerDetectionBatch::detect(const vector<Region> &rs) {
+	if (m_region_boundaries.size() < rs.size()) m_region_boundaries.resize(rs.size());
+	m_boundaries.resize(rs.size());
+	m_sizes.resize(rs.size());
+	for (unsigned int i=0; i<rs.size(); i++) {
+		m_region_boundaries[i] = rs[i].getBoundary();
+		m_boundaries[i] = &m_region_boundaries[i];
+		m_sizes[i] = rs[i].getSize();
+	}
+	runDetection(rs.size());
+}
+
+void CornerDetectionBatch::detect(const vector<Blob> &blobs) {
+	m_boundaries.resize(blobs.size());
+	m_sizes.resize(blobs.size());
+	for (unsigned int i=0; i<blobs.size(); i++) {
+		m_boundaries[i] = &blobs[i].boundary;
+		m_sizes[i] = blobs[i].size;
+	}
+	runDetection(blobs.size());
+}
+
+void CornerDetectionBatch::runDetection(int n) {
+	// the results of the last call are kept for the cache lookups
+	m_current = 1-m_current;
+	m_size = n;
+	vector<Result> &results = m_results[m_current];
+	if ((int)results.size() < m_size) results.resize(m_size);
+	m_pool.parallelFor(m_size, &CornerDetectionBatch::process, this);
+
+	m_previous.clear();
+	if (!m_cache_enabled) return;
+	for (int i=0; i<m_size; i++) {
+		m_cache_lookups++;
+		if (results[i].previous != -1) m_cache_hits++;
+		m_previous.insert(make_pair(results[i].fingerprint.hash, i));
+	}
+}
+
+void CornerDetectionBatch::process(void *batch, int task, int thread) {
+	CornerDetectionBatch *b = (CornerDetectionBatch*)batch;
+	Result &r = b->m_results[b->m_current][task];
+	const vector<Point> &boundary = *b->m_boundaries[task];
+	r.previous = -1;
+	r.thinning_ms = r.css_ms = 0;
+	if (b->m_cache_enabled) {
+		getFingerprint(boundary, b->m_sizes[task], b->m_quantization, r.fingerprint);
+		r.previous = b->findPrevious(r.fingerprint);
+		if (r.previous != -1) {
+			const Result &p = b->m_results[1-b->m_current][r.previous];
+			r.thinned = p.thinned;
+			r.corners = p.corners;
+			r.angles = p.angles;
+			return;
+		}
+	}
+	CornerDetectorCSS &detector = b->m_detectors[thread];
+	Time start = Time::now();
+	::getThinnedBoundary(boundary, r.thinned);
+	Time thinned = Time::now();
+	r.corners = detector.detectCorners(r.thinned);
+	r.angles = detector.getCornerAngles();
+	r.thinning_ms = (thinned-start).toMicroSecondsDouble()/1000;
+	r.css_ms = (Time::now()-thinned).toMicroSecondsDouble()/1000;
+}
+
+float CornerDetectionBatch::getThinningTime() const {
+	float ms = 0;
+	for (int i=0; i<m_size; i++) ms += m_results[m_current][i].thinning_ms;
+	return ms;
+}
+
+float CornerDetectionBatch::getCSSTime() const {
+	float ms = 0;
+	for (int i=0; i<m_size; i++) ms += m_results[m_current][i].css_ms;
+	return ms;
+}
+
+void CornerDetectionBatch::getFingerprint(const vector<Point> &boundary, int size,
+		int quantization, Fingerprint &f) {
+	f.size = size;
+	f.boundary_length = boundary.size();
+	f.x0 = f.y0 = INT_MAX;
+	f.x1 = f.y1 = INT_MIN;
+	// FNV-1a hash of the quantized points. When quantizing, a point equal to
+	// the last one is skipped, so small changes of the boundary length don't
+	// change the hash.
+	unsigned int hash = 2166136261u;
+	int last_x = INT_MIN, last_y = INT_MIN;
+	f.points.clear();
+	for (unsigned int i=0; i<boundary.size(); i++) {
+		const Point &p = boundary[i];
+		f.x0 = min(f.x0, p.x); f.x1 = max(f.x1, p.x);
+		f.y0 = min(f.y0, p.y); f.y1 = max(f.y1, p.y);
+		int x = p.x/quantization, y = p.y/quantization;
+		if (quantization > 1 && x == last_x && y == last_y) continue;
+		hash = (hash ^ (unsigned int)x) * 16777619u;
+		hash = (hash ^ (unsigned int)y) * 16777619u;
+		f.points.push_back(Point(x, y));
+		last_x = x; last_y = y;
+	}
+	f.hash = hash;
+}
+
+int CornerDetectionBatch::findPrevious(const Fingerprint &f) const {
+	map<unsigned int, int>::const_iterator it = m_previous.find(f.hash);
+	if (it == m_previous.end()) return -1;
+	const Fingerprint &p = m_results[1-m_current][it->second].fingerprint;
+	int tol = m_quantization-1;
+	if (abs(f.x0-p.x0) > tol || abs(f.y0-p.y0) > tol ||
+			abs(f.x1-p.x1) > tol || abs(f.y1-p.y1) > tol) return -1;
+	if (abs(f.size-p.size) > tol*max(f.boundary_length, p.boundary_length)) return -1;
+	if (tol == 0 && f.boundary_length != p.boundary_length) return -1;
+	// the hashes of different boundaries may collide
+	if (f.points != p.points) return -1;
+	return it->second;
+}
@@ -0,0 +1,140 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __CORNER_DETECTION_BATCH_EWEITNAU_H__
+#define __CORNER_DETECTION_BATCH_EWEITNAU_H__
+
+#include <ICLQuick/Common.h>
+#include <ICLBlob/Region.h>
+#include <map>
+#include <vector>
+#include "boundary_thinning.h"
+#include "corner_detector_css.h"
+#include "vision_frame.h"
+#include "thread_pool.h"
+
+/// Runs the CSS corner detection on all regions of a frame in parallel.
+/** The thinning of the boundaries and the corner detection are distributed
+ * over the threads of a ThreadPool. Each thread has its own CornerDetectorCSS,
+ * so the workspaces of the detectors are reused from frame to frame. The
+ * results of region i of the last detect() call are accessed by index i.
+ *
+ * If the cache is enabled, each region gets a fingerprint of its bounding
+ * box, pixel count and quantized boundary points. The regions of the
+ * previous call are looked up by a hash of the points, and the points are
+ * compared when the hashes are equal, so a hash collision does not reuse
+ * the results of another region. A region that matches a
+ * region of the previous detect() call gets a copy of its results instead
+ * of thinning and detecting the corners again. With a quantization of 1,
+ * only regions with the same boundary match, so the results are the same
+ * as without the cache. getPreviousIndex() tells which region matched,
+ * so later steps can reuse their results as well.
+ *
+ * Usage example:
+ * \code
+ * CornerDetectionBatch batch;
+ * batch.setParameters(162, 1.5, 3, 100, 10, 2);
+ * batch.setCache(true);
+ * batch.detect(regions);
+ * for (int i=0; i<batch.size(); i++) draw(batch.getCorners(i));
+ * \endcode
+ */
+class CornerDetectionBatch {
+	public:
+		/// Uses a pool with 'threads' threads, see ThreadPool::ThreadPool().
+		CornerDetectionBatch(int threads=0);
+
+		/// Sets the parameters of the CornerDetectorCSS of all threads.
+		/** With a contour_spacing bigger than 0, long contours are resampled
+		 * before the detection, see CornerDetectorCSS. Changing a parameter
+		 * clears the cache. */
+		void setParameters(float angle_thresh, float rc_coeff, float sigma,
+			float curvature_cutoff, float straight_line_thresh, float contour_spacing=0);
+
+		/// Enables or disables reusing the results of unchanged regions.
+		/** The boundary points are divided by 'quantization' before they are
+		 * compared. Two regions match if these points are equal, the edges of their
+		 * bounding boxes are at most quantization-1 pixels apart and their
+		 * pixel counts differ by at most quantization-1 times the boundary
+		 * length. */
+		void setCache(bool enabled, int quantization=1);
+		bool isCacheEnabled() const { return m_cache_enabled; }
+		/// Forgets the regions of the last detect() call.
+		void clearCache() { m_previous.clear(); }
+
+		/// Detects the corners of all passed regions.
+		/** The boundaries are fetched from the regions in the calling thread,
+		 * as regions calculate them lazily on the first call. */
+		void detect(const std::vector<icl::Region> &rs);
+
+		/// Detects the corners of all passed blobs.
+		/** The boundaries of the blobs are used without copying them. */
+		void detect(const std::vector<Blob> &blobs);
+
+		/// Number of regions passed in the last detect() call.
+		int size() const { return m_size; }
+		/// Corners of region i.
+		const std::vector<icl::Point32f> &getCorners(int i) const { return m_results[m_current][i].corners; }
+		/// Angles of the corners of region i in deg.
+		const std::vector<float> &getCornerAngles(int i) const { return m_results[m_current][i].angles; }
+		/// Thinned boundary of region i, which was passed to the corner detector.
+		const std::vector<icl::Point32f> &getThinnedBoundary(int i) const { return m_results[m_current][i].thinned; }
+		/// Index of the region of the previous detect() call whose results were reused for region i, or -1.
+		int getPreviousIndex(int i) const { return m_results[m_current][i].previous; }
+
+		/// Number of regions looked up in the cache, summed up over all detect() calls.
+		long long getCacheLookups() const { return m_cache_lookups; }
+		/// Number of regions whose results were reused, summed up over all detect() calls.
+		long long getCacheHits() const { return m_cache_hits; }
+		/// Fraction of the looked up regions whose results were reused.
+		float getCacheHitRatio() const { return m_cache_lookups ? float(m_cache_hits)/m_cache_lookups : 0; }
+
+		/// Time spent on thinning the boundaries in the last detect() call in ms.
+		/** Summed up over all regions, so with several threads it can be
+		 * longer than the call itself. Reused regions count with 0 ms. */
+		float getThinningTime() const;
+		/// Time spent in the CornerDetectorCSS in the last detect() call in ms, see getThinningTime().
+		float getCSSTime() const;
+
+	private:
+		struct Fingerprint {
+			unsigned int hash; ///< of the quantized boundary points
+			/// quantized boundary points, a point equal to the last one is skipped if quantizing
+			std::vector<icl::Point> points;
+			int size, boundary_length;
+			int x0, y0, x1, y1; ///< bounding box of the boundary
+		};
+		struct Result {
+			Fingerprint fingerprint;
+			int previous;
+			std::vector<icl::Point32f> thinned;
+			std::vector<icl::Point32f> corners;
+			std::vector<float> angles;
+			float thinning_ms, css_ms;
+		};
+
+		/// Resizes the result vectors and runs the detection on m_boundaries.
+		void runDetection(int n);
+		/// Thinning and corner detection of region 'task' in thread 'thread'.
+		static void process(void *batch, int task, int thread);
+		/// Calculates the fingerprint of a region from its boundary and pixel count.
+		static void getFingerprint(const std::vector<icl::Point> &boundary, int size,
+			int quantization, Fingerprint &f);
+		/// Returns the index of the region of the previous call which matches f, or -1.
+		int findPrevious(const Fingerprint &f) const;
+
+		ThreadPool m_pool;
+		std::vector<CornerDetectorCSS> m_detectors; // one per thread
+		int m_size;
+		std::vector<const std::vector<icl::Point>*> m_boundaries;
+		std::vector<int> m_sizes; // pixel counts of the regions
+		// per region, the vectors are kept to reuse their memory
+		std::vector< std::vector<icl::Point> > m_region_boundaries;
+		// results of the current and the previous detect() call
+		std::vector<Result> m_results[2];
+		int m_current;
+		bool m_cache_enabled;
+		int m_quantization;
+		std::map<unsigned int, int> m_previous; // hash -> index in the previous results
+		long long m_cache_lookups, m_cache_hits;
+};
+
+#endif /* __CORNER_DETECTION_BATCH_EWEITNAU_H__ */
@@ -1,7 +1,11 @@
 // Copyright 2009 Erik Weitnauer
 #include "corner_detector_css.h"
+#include "contour_resampling.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
-string CornerDetectorCSS::ipp32f_to_string (const Ipp32f* v, int length) {
+string CornerDetectorCSS::ipp32f_to_string (const float* v, int length) {
   std::stringstream ss;
   ss << "(" << v[0];
   for (int i=1; i<length; i++) ss << ", " << v[i];
@@ -18,25 +22,33 @@ template <class T>
   return ss.str();
     }
 
-int CornerDetectorCSS::gaussian(Ipp32f **gau, float sigma, float cutoff) {
+int CornerDetectorCSS::gaussian(float **gau, float sigma, float cutoff) {
+  vector<float> g;
+  int width = gaussian(g, sigma, cutoff);
+  *gau = (float*)malloc(sizeof(float)*g.size());
+  memcpy(*gau, &g[0], sizeof(float)*g.size());
+  return width;
+}
+
+int CornerDetectorCSS::gaussian(vector<float> &gau, float sigma, float cutoff) {
   float ssq = sigma*sigma;
   int width;
   for (width=1; exp(-(width*width)/(2*ssq)) > cutoff; width++);
   width = max(1, width-1);
 
   float sum = 0;
-  *gau = (Ipp32f*)malloc(sizeof(Ipp32f)*(width*2+1));
+  gau.resize(width*2+1);
   for (int i=-width; i<=width; i++) {
-    (*gau)[i+width] = exp(-(i*i)/(2*ssq))/(2*M_PI*ssq);
-    sum += (*gau)[i+width];
+    gau[i+width] = exp(-(i*i)/(2*ssq))/(2*M_PI*ssq);
+    sum += gau[i+width];
   }
   for (int i=0; i<width*2+1; i++) {
-    (*gau)[i] /= sum;
+    gau[i] /= sum;
   }
   return width;
 }
 
-void CornerDetectorCSS::findExtrema(vector<int> &extrema, Ipp32f* x, int length) {
+void CornerDetectorCSS::findExtrema(vector<int> &extrema, float* x, int length) {
   extrema.clear();
   float search = 1; // 1...pos. slope becomes neg. slope, 0... neg. slope becomes pos. slope
 
@@ -49,7 +61,7 @@ void CornerDetectorCSS::findExtrema(vector<int> &extrema, Ipp32f* x, int length)
   if (extrema.size() % 2 == 0) extrema.push_back(length-1);
 }
 
-void CornerDetectorCSS::removeRoundCorners(float rc_coeff, Ipp32f* k, vector<int> &extrema) {
+void CornerDetectorCSS::removeRoundCorners(float rc_coeff, float* k, vector<int> &extrema) {
   vector<int> new_extrema;
   float mean;
   int n;
@@ -77,7 +89,7 @@ float modulo(float x, float v) {
   return x;
 }
 
-float CornerDetectorCSS::tangentAngle(Ipp32f* x, Ipp32f* y, int length, int candidate, float straight_line_thresh) {
+float CornerDetectorCSS::tangentAngle(float* x, float* y, int length, int candidate, float straight_line_thresh) {
   int last, first, middle, middle2;
   float x0,y0,x1,x2,x3,y1,y2,y3;
   float tangent_direction;
@@ -123,7 +135,7 @@ float CornerDetectorCSS::tangentAngle(Ipp32f* x, Ipp32f* y, int length, int cand
   return (angle < 0) ? angle+360 : (angle > 360) ? angle-360 : angle;
 }
 
-void CornerDetectorCSS::removeFalseCorners(float angle_thresh, Ipp32f* x, Ipp32f* y, Ipp32f* k, int length, vector<int> &maxima, vector<float> &corner_angles, float straight_line_thresh) {
+void CornerDetectorCSS::removeFalseCorners(float angle_thresh, float* x, float* y, float* k, int length, vector<int> &maxima, vector<float> &corner_angles, float straight_line_thresh) {
   vector<int> new_maxima;
   bool has_changed;
   float angle;
@@ -162,77 +174,159 @@ void CornerDetectorCSS::removeFalseCorners(float angle_thresh, Ipp32f* x, Ipp32f
   } while (has_changed);
 }
 
+namespace {
+  /// first derivation at index i of an array of length n
+  inline float derivative(const float *v, int i, int n) {
+    if (i == 0) return v[1]-v[0];
+    if (i == n-1) return v[n-1]-v[n-2];
+    return (v[i+1]-v[i-1])/2;
+  }
+
+  /// second derivation at index i of an array of length n
+  inline float derivative2(const float *v, int i, int n) {
+    if (i == 0) return derivative(v,1,n)-derivative(v,0,n);
+    if (i == n-1) return derivative(v,n-1,n)-derivative(v,n-2,n);
+    return (derivative(v,i+1,n)-derivative(v,i-1,n))/2;
+  }
+}
+
+float CornerDetectorCSS::curvature(const float *xx, const float *yy, int i, int n) {
+  float xu = derivative(xx,i,n), yu = derivative(yy,i,n);
+  float xuu = derivative2(xx,i,n), yuu = derivative2(yy,i,n);
+  return abs((xu*yuu - xuu*yu) / pow((xu*xu + yu*yu),1.5f));
+}
+
+void CornerDetectorCSS::smoothAndCurvature(int n) {
+  const float *h = &kernel[0];
+  const int kn = 2*kernel_width+1;
+  const float *xp = &x_pad[0], *yp = &y_pad[0];
+  float *sx = &xx[0], *sy = &yy[0], *kk = &k[0];
+  int c = 2; // next curvature index, the first two are done at the end
+#ifdef __SSE2__
+  // x_pad, y_pad, xx, yy and k are padded, so the convolution can run over
+  // whole blocks of four and the curvature of the last interior points can
+  // be calculated in a full block as well.
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  for (int i=0; i<n; i+=4) {
+    __m128 ax = _mm_setzero_ps(), ay = _mm_setzero_ps();
+    for (int m=0; m<kn; m++) {
+      __m128 hm = _mm_set1_ps(h[m]);
+      ax = _mm_add_ps(ax, _mm_mul_ps(hm, _mm_loadu_ps(xp+i+m)));
+      ay = _mm_add_ps(ay, _mm_mul_ps(hm, _mm_loadu_ps(yp+i+m)));
+    }
+    _mm_storeu_ps(sx+i, ax);
+    _mm_storeu_ps(sy+i, ay);
+    // curvature at c..c+3 needs the smoothed points up to c+5
+    bool last = i+4 >= n;
+    for (; c < n-2 && (c+5 < i+4 || last); c+=4) {
+      __m128 xu = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(sx+c+1), _mm_loadu_ps(sx+c-1)), half);
+      __m128 yu = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(sy+c+1), _mm_loadu_ps(sy+c-1)), half);
+      __m128 xu_r = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(sx+c+2), _mm_loadu_ps(sx+c)), half);
+      __m128 xu_l = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(sx+c), _mm_loadu_ps(sx+c-2)), half);
+      __m128 yu_r = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(sy+c+2), _mm_loadu_ps(sy+c)), half);
+      __m128 yu_l = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(sy+c), _mm_loadu_ps(sy+c-2)), half);
+      __m128 xuu = _mm_mul_ps(_mm_sub_ps(xu_r, xu_l), half);
+      __m128 yuu = _mm_mul_ps(_mm_sub_ps(yu_r, yu_l), half);
+      __m128 num = _mm_sub_ps(_mm_mul_ps(xu,yuu), _mm_mul_ps(xuu,yu));
+      __m128 sq = _mm_add_ps(_mm_mul_ps(xu,xu), _mm_mul_ps(yu,yu));
+      __m128 den = _mm_mul_ps(sq, _mm_sqrt_ps(sq));
+      _mm_storeu_ps(kk+c, _mm_and_ps(_mm_div_ps(num, den), abs_mask));
+      for (int j=c; j<c+4 && j<n-2; j++) {
+        // s*sqrt(s) and pow(s,1.5) may differ in the last bit, which only
+        // matters if the value is close to the rounding threshold
+        float v = kk[j]*curvature_cutoff;
+        if (fabs(v-floor(v)-0.5f) <= 1e-6f*v) kk[j] = curvature(sx,sy,j,n);
+        kk[j] = quantize(kk[j]);
+      }
+    }
+  }
+#else
+  for (int i=0; i<n; i++) {
+    float ax = 0, ay = 0;
+    for (int m=0; m<kn; m++) { ax += h[m]*xp[i+m]; ay += h[m]*yp[i+m]; }
+    sx[i] = ax; sy[i] = ay;
+  }
+  for (; c<n-2; c++) kk[c] = quantize(curvature(sx,sy,c,n));
+#endif
+  const int border[4] = {0, 1, n-2, n-1};
+  for (int i=0; i<4; i++) kk[border[i]] = quantize(curvature(sx,sy,border[i],n));
+}
+
 const vector<Point32f> &CornerDetectorCSS::detectCorners(const vector<Point32f> &boundary) {
-  //debug_output = true;
+  int L = boundary.size();
+  int m = L;
+  float length = 0;
+  if (contour_spacing > 0 && L > 0) {
+    // the smoothing must still span at least one point of the resampled contour
+    length = getContourLength(boundary);
+    m = max((int)(length/contour_spacing + 0.5), (int)ceil(L/sigma));
+  }
+  if (m >= L) {
+    detectCorners(boundary, sigma);
+    return corners;
+  }
+
+  // sigma is measured in points, so scale it to cover the same arc length.
+  // Corners close to the start of the contour are found less reliably, and
+  // boundaries of blobs start at their topmost pixel, which often is a
+  // corner, so the resampled contour starts 3/8 along the boundary, which
+  // is between two corners for all tangram shapes in that case.
+  resampleContour(boundary, length, m, resampled, resampled_index, 3*L/8);
+  detectCorners(resampled, sigma*m/L);
+  for (unsigned int i=0; i<corners.size(); i++) {
+    corner_indices[i] = resampled_index[corner_indices[i]];
+    corners[i] = boundary[corner_indices[i]];
+  }
+  return corners;
+}
+
+void CornerDetectorCSS::detectCorners(const vector<Point32f> &boundary, float sig) {
   corners.clear();
+  corner_indices.clear();
   int L=boundary.size();
-  Ipp32f x_in[L], y_in[L];
-  for (int i=0; i<L; i++) { x_in[i] = boundary[i].x; y_in[i] = boundary[i].y; }
 
-  Ipp32f* h;
-  int W = gaussian(&h, sigma, 0.0001); // W ... size of gauss kernel
+  if (kernel_sigma != sig) {
+    kernel_width = gaussian(kernel, sig, 0.0001);
+    kernel_sigma = sig;
+  }
+  const int W = kernel_width; // W ... size of gauss kernel
   const int l2w = L+2*W;
-  const int l4w = L+4*W;
-  if (L <= W) return corners;
-
-  // closed curve -> copy end points to begin and begin points to end
-  Ipp32f x[l2w], y[l2w];
-  memcpy(x, &x_in[L-W], W*sizeof(Ipp32f));
-  memcpy(&x[W], x_in, L*sizeof(Ipp32f));
-  memcpy(&x[L+W], x_in, W*sizeof(Ipp32f));
-  memcpy(y, &y_in[L-W], W*sizeof(Ipp32f));
-  memcpy(&y[W], y_in, L*sizeof(Ipp32f));
-  memcpy(&y[L+W], y_in, W*sizeof(Ipp32f));
-
-  // do the convolution
-  Ipp32f xx_big[l4w], yy_big[l4w];
-  ippsConv_32f(x, l2w, h, 2*W+1, xx_big);
-  ippsConv_32f(y, l2w, h, 2*W+1, yy_big);
-  Ipp32f *xx = &xx_big[W], *yy = &yy_big[W];
-
-  // calculate the first derivation
-  Ipp32f xu[l2w], yu[l2w];
-  xu[0] = xx[1]-xx[0];
-  for (int i=1; i<l2w-1; i++) xu[i] = (xx[i+1]-xx[i-1])/2;
-  xu[l2w-1] = xx[l2w-1]-xx[l2w-2];
-  yu[0] = yy[1]-yy[0];
-  for (int i=1; i<l2w-1; i++) yu[i] = (yy[i+1]-yy[i-1])/2;
-  yu[l2w-1] = yy[l2w-1]-yy[l2w-2];
-
-  // calculate the second derivation
-  Ipp32f xuu[l2w], yuu[l2w];
-  xuu[0] = xu[1]-xu[0];
-  for (int i=1; i<l2w-1; i++) xuu[i] = (xu[i+1]-xu[i-1])/2;
-  xuu[l2w-1] = xu[l2w-1]-xu[l2w-2];
-  yuu[0] = yu[1]-yu[0];
-  for (int i=1; i<l2w-1; i++) yuu[i] = (yu[i+1]-yu[i-1])/2;
-  yuu[l2w-1] = yu[l2w-1]-yu[l2w-2];
-
-  // calculate the curvature values
-  Ipp32f k[l2w];
+  if (L <= W) return;
+
+  // closed curve -> copy end points to begin and begin points to end, add W
+  // zeros on both sides for the convolution and round up to blocks of four
+  const int n4 = (l2w+3)/4*4;
+  x_pad.assign(n4+2*W+4, 0);
+  y_pad.assign(n4+2*W+4, 0);
   for (int i=0; i<l2w; i++) {
-    k[i] = abs((xu[i]*yuu[i] - xuu[i]*yu[i]) / pow((xu[i]*xu[i] + yu[i]*yu[i]),1.5f));
-    k[i] = float(round(k[i]*curvature_cutoff))/curvature_cutoff; // very important to suppess noise
+    const Point32f &p = boundary[(i-W+L) % L];
+    x_pad[W+i] = p.x; y_pad[W+i] = p.y;
   }
+  xx.assign(n4+8, 0);
+  yy.assign(n4+8, 0);
+  k.assign(n4+8, 0);
+
+  // smooth the contour and calculate the curvature values
+  smoothAndCurvature(l2w);
 
   // get the maxima of the curvature
-  findExtrema(extrema, k, l2w);
+  findExtrema(extrema, &k[0], l2w);
 
   // remove round corners
-  removeRoundCorners(rc_coeff, k, extrema);
+  removeRoundCorners(rc_coeff, &k[0], extrema);
 
   // remove false corners due to boundary noise and trivial details
-  removeFalseCorners(angle_thresh, xx, yy, k, l2w, extrema, corner_angles, straight_line_thresh);
+  removeFalseCorners(angle_thresh, &xx[0], &yy[0], &k[0], l2w, extrema, corner_angles, straight_line_thresh);
 
   // extract the coordinates of the detected corners
-  corners.clear();
   vector<float> angles_tmp;
   for (unsigned i=0; i<extrema.size(); i++) {
     if (extrema[i] >= W and extrema[i] < L+W) {
-      corners.push_back(Point32f(x_in[extrema[i]-W], y_in[extrema[i]-W]));
+      corners.push_back(boundary[extrema[i]-W]);
+      corner_indices.push_back(extrema[i]-W);
       angles_tmp.push_back(corner_angles[i]);
     }
   }
   corner_angles = angles_tmp;
-  return corners;
 }
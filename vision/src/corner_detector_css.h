@@ -3,7 +3,7 @@
 #define ICL_TANGRAM_CORNER_DETECTOR_CSS_H
 
 #include <ICLQuick/Common.h>
-#include <ipp.h>
+#include <vector>
 
   /// Curvature Corner Detector
   /**
@@ -33,11 +33,30 @@
    *            left neigbour, corner candidate and  and the point on the contour half
    *            way between them is smaller than straight_line_thresh.
    *            0 leads to circle approximation only, 180 to straight line approximation only.
+   * contour_spacing - if bigger than 0, long contours are resampled to points with
+   *            this arc length distance before the detection, which makes the
+   *            detection faster for big regions. Sigma is scaled with the number
+   *            of points, so the smoothing covers the same part of the contour,
+   *            and the corners are mapped back to points of the passed contour.
+   *            The spacing is limited so that the scaled sigma is at least 1.
+   *            The default is 0, which means the contour is used as it is.
+   *
+   * The detector keeps all intermediate arrays as members and reuses them in
+   * subsequent calls, so detectCorners() does not allocate memory once the
+   * arrays have grown to the contour length. The gaussian kernel is cached
+   * until sigma changes. Smoothing, derivatives and curvature are computed in
+   * one pass over the contour, four points at a time using SSE if available.
+   * The corners are the same as those of the original scalar code. The
+   * results are bit-identical as long as the compiler does not contract
+   * multiply-adds into FMA instructions. With -march=native on FMA capable
+   * CPUs, the smoothed contour differs in the last bits and the corner angles
+   * differ by up to about 6e-4 degrees.
    *
    * usage example:
    *   \code 
    *   const std::vector<icl::Region> &rs = d.detect(&image);
-   *   const vector<Point32f> &boundary = getThinnedBoundary(rs[0].getBoundary());
+   *   vector<Point32f> boundary;
+   *   getThinnedBoundary(rs[0].getBoundary(), boundary);
    *   CornerDetectorCSS css;
    *   const vector<Point32f> &corners = css.detectCorners(boundary);
    *   \endcode
@@ -45,16 +64,21 @@
   class CornerDetectorCSS {
     public:
       CornerDetectorCSS(float angle_thresh=162., float rc_coeff=1.5, float sigma=3., float curvature_cutoff=100., float straight_line_thresh=0.1)
-      : angle_thresh(angle_thresh), rc_coeff(rc_coeff), sigma(sigma), curvature_cutoff(curvature_cutoff), straight_line_thresh(straight_line_thresh) {};
+      : angle_thresh(angle_thresh), rc_coeff(rc_coeff), sigma(sigma), curvature_cutoff(curvature_cutoff), straight_line_thresh(straight_line_thresh),
+        contour_spacing(0), kernel_sigma(-1), kernel_width(0) {};
 
       /// calculates a normalized 1d gaussian vector
        /**
-        * @param gau adress of pointer to Ipp32f array, which will hold the calculated gauss kernel
+        * @param gau adress of pointer to float array, which will hold the calculated gauss kernel.
+        *        The array is allocated with malloc() and must be freed by the caller.
         * @param sigma sigma^2 is the variance of the gaussian, default is 1
         * @param cutoff if value of gaussian drops below this value, it is set to zero, default is 0.001
         * @return width of the gaussian tails, so the size of the returned vector is 2*width+1
         */
-      static int gaussian(Ipp32f **gau, float sigma, float cutoff);
+      static int gaussian(float **gau, float sigma, float cutoff);
+
+      /// calculates a normalized 1d gaussian vector, see above
+      static int gaussian(vector<float> &gau, float sigma, float cutoff);
 
       /// detects the corners in the passed contour
        /**
@@ -71,8 +95,11 @@
       /// Returns approximated angles of corners in deg. Call detectCorners method first.
       const vector<float> &getCornerAngles() { return corner_angles; }
 
-      /// converts Ipp32f array to string
-      static string ipp32f_to_string (const Ipp32f* v, int length);
+      /// Returns the indices of the corners in the contour passed to detectCorners.
+      const vector<int> &getCornerIndices() { return corner_indices; }
+
+      /// converts float array to string
+      static string ipp32f_to_string (const float* v, int length);
 
       /// converts a std::vector to string
       template <class T>
@@ -80,15 +107,16 @@
 
       /// parameters
       float angle_thresh, rc_coeff, sigma, curvature_cutoff, straight_line_thresh;
+      float contour_spacing;
 
-    private:
+    protected:
       /// finds the indicies of extrema
       /**
        * @param extrema reference to a vector in which the extrema are stored
        * @param x function values
        * @param length number of points in array x
        */
-      static void findExtrema(vector<int> &extrema, Ipp32f* x, int length);
+      static void findExtrema(vector<int> &extrema, float* x, int length);
 
       /// removes round corners by comparing all corner candidates with adaptive local threshold
       /**
@@ -98,7 +126,7 @@
        * @param k curvature function
        * @param extrema indicies of extrem points in curvature function k
        */
-      static void removeRoundCorners( float rc_coeff, Ipp32f* k, vector<int> &extrema);
+      static void removeRoundCorners( float rc_coeff, float* k, vector<int> &extrema);
 
       /// remove false corners by checking the corner angle
       /**
@@ -110,7 +138,7 @@
        * @param length number of points in smoothed contour (and curvature function)
        * @param maxima indicies of maximum points in curvature function k
        */
-      static void removeFalseCorners(float angle_thresh, Ipp32f* xx, Ipp32f* yy, Ipp32f* k, int length, vector<int> &maxima, vector<float> &corner_angles, float straight_line_thresh);
+      static void removeFalseCorners(float angle_thresh, float* xx, float* yy, float* k, int length, vector<int> &maxima, vector<float> &corner_angles, float straight_line_thresh);
 
       /// estimates the angle of a corner
        /**
@@ -120,15 +148,45 @@
         * @param length number of points in contour segment
         * @param center position of corner in contour segment
         */
-      static float tangentAngle(Ipp32f* x, Ipp32f* y, int length, int center, float straight_line_thresh);
+      static float tangentAngle(float* x, float* y, int length, int center, float straight_line_thresh);
 
       /// signum function
       template<class T> static float sign(T x);
 
+    private:
+      /// Detects the corners with gaussian sigma 'sig', writes corners, corner_angles and corner_indices.
+      void detectCorners(const vector<Point32f> &boundary, float sig);
+
+      /// Smoothes the padded contour in x_pad, y_pad and calculates the curvature.
+      /**
+       * Writes the smoothed contour to xx, yy and the quantized curvature to k.
+       * @param n number of output points, x_pad and y_pad hold n+2*W points
+       */
+      void smoothAndCurvature(int n);
+
+      /// Curvature at index i, computed from the smoothed contour with the original formula.
+      static float curvature(const float *xx, const float *yy, int i, int n);
+
+      /// Rounds k to multiples of 1/curvature_cutoff
+      float quantize(float k) const { return float(round(k*curvature_cutoff))/curvature_cutoff; }
+
+      // cached gaussian kernel
+      vector<float> kernel;
+      float kernel_sigma;
+      int kernel_width;
+
+      // workspace
+      vector<float> x_pad, y_pad, xx, yy, k;
+
       // result lists
       vector<Point32f> corners;
       vector<float> corner_angles;
       vector<int> extrema;
+      vector<int> corner_indices;
+
+      // resampled contour and the indices of its points in the passed contour
+      vector<Point32f> resampled;
+      vector<int> resampled_index;
   };
 
 #endif
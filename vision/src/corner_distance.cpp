@@ -0,0 +1,102 @@
+// Copyright 2009 Erik Weitnauer
+#include "corner_distance.h"
+#include <cmath>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+using namespace std;
+
+CornerDistance::CornerDistance(const PolygonShape &shape) {
+	const vector<icl::Point32f> &corners = shape.getCorners();
+	icl::Point32f c = shape.getCenter();
+	for (unsigned int i=0; i<corners.size(); i++) {
+		m_cx.push_back(corners[i].x-c.x);
+		m_cy.push_back(corners[i].y-c.y);
+	}
+}
+
+float CornerDistance::operator()(const Transformation &a, const Transformation &b) const {
+	const Mat3 &A = a.getMatrix();
+	const Mat3 &B = b.getMatrix();
+	float a_tx = a.getTx(), a_ty = a.getTy(), b_tx = b.getTx(), b_ty = b.getTy();
+	float result;
+	compute(1, &A[0], &A[1], &a_tx, &a_ty, &B[0], &B[1], &b_tx, &b_ty, 0, &result);
+	return result;
+}
+
+void CornerDistance::compute(const PoseArray &a, const PoseArray &b, vector<float> &out) const {
+	int n = a.size();
+	out.resize(n);
+	if (n == 0) return;
+	compute(n, &a.cos_rot[0], &a.sin_rot[0], &a.tx[0], &a.ty[0],
+		&b.cos_rot[0], &b.sin_rot[0], &b.tx[0], &b.ty[0], 1, &out[0]);
+}
+
+void CornerDistance::compute(const PoseArray &a, const Transformation &reference, vector<float> &out) const {
+	int n = a.size();
+	out.resize(n);
+	if (n == 0) return;
+	const Mat3 &R = reference.getMatrix();
+	float r_tx = reference.getTx(), r_ty = reference.getTy();
+	compute(n, &a.cos_rot[0], &a.sin_rot[0], &a.tx[0], &a.ty[0],
+		&R[0], &R[1], &r_tx, &r_ty, 0, &out[0]);
+}
+
+float CornerDistance::sum(const PoseArray &a, const Transformation &reference) const {
+	vector<float> dists;
+	compute(a, reference, dists);
+	float result = 0;
+	for (unsigned int i=0; i<dists.size(); i++) result += dists[i];
+	return result;
+}
+
+void CornerDistance::compute(int n, const float *a_cos, const float *a_sin, const float *a_tx, const float *a_ty,
+		const float *b_cos, const float *b_sin, const float *b_tx, const float *b_ty, int b_stride,
+		float *out) const {
+	int K = m_cx.size();
+	if (K == 0) {
+		for (int i=0; i<n; i++) out[i] = 0;
+		return;
+	}
+	int i = 0;
+#ifdef __SSE__
+	__m128 k = _mm_set1_ps((float)K);
+	for (; i+4<=n; i+=4) {
+		__m128 bc, bs, btx, bty;
+		if (b_stride) {
+			bc = _mm_loadu_ps(b_cos+i); bs = _mm_loadu_ps(b_sin+i);
+			btx = _mm_loadu_ps(b_tx+i); bty = _mm_loadu_ps(b_ty+i);
+		} else {
+			bc = _mm_set1_ps(*b_cos); bs = _mm_set1_ps(*b_sin);
+			btx = _mm_set1_ps(*b_tx); bty = _mm_set1_ps(*b_ty);
+		}
+		__m128 dc = _mm_sub_ps(_mm_loadu_ps(a_cos+i), bc);
+		__m128 ds = _mm_sub_ps(_mm_loadu_ps(a_sin+i), bs);
+		__m128 dtx = _mm_sub_ps(_mm_loadu_ps(a_tx+i), btx);
+		__m128 dty = _mm_sub_ps(_mm_loadu_ps(a_ty+i), bty);
+		__m128 acc = _mm_setzero_ps();
+		for (int j=0; j<K; j++) {
+			__m128 cx = _mm_set1_ps(m_cx[j]);
+			__m128 cy = _mm_set1_ps(m_cy[j]);
+			// rotation matrix is [cos sin; -sin cos]
+			__m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dc,cx), _mm_mul_ps(ds,cy)), dtx);
+			__m128 y = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(dc,cy), _mm_mul_ps(ds,cx)), dty);
+			acc = _mm_add_ps(acc, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x,x), _mm_mul_ps(y,y))));
+		}
+		_mm_storeu_ps(out+i, _mm_div_ps(acc, k));
+	}
+#endif
+	for (; i<n; i++) {
+		int ib = i*b_stride;
+		float dc = a_cos[i]-b_cos[ib], ds = a_sin[i]-b_sin[ib];
+		float dtx = a_tx[i]-b_tx[ib], dty = a_ty[i]-b_ty[ib];
+		float acc = 0;
+		for (int j=0; j<K; j++) {
+			float x = dc*m_cx[j] + ds*m_cy[j] + dtx;
+			float y = dc*m_cy[j] - ds*m_cx[j] + dty;
+			acc += sqrt(x*x + y*y);
+		}
+		out[i] = acc / K;
+	}
+}
@@ -0,0 +1,64 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __CORNER_DISTANCE_EWEITNAU_H__
+#define __CORNER_DISTANCE_EWEITNAU_H__
+
+#include <vector>
+#include "polygon_shape.h"
+#include "transformation.h"
+
+/// Poses stored as structure of arrays.
+/** For each pose the cosine and sine of the rotation are stored instead of
+ * the angle, so they are computed only once when adding the pose. */
+struct PoseArray {
+	std::vector<float> cos_rot, sin_rot, tx, ty;
+
+	int size() const { return tx.size(); }
+	void clear() { cos_rot.clear(); sin_rot.clear(); tx.clear(); ty.clear(); }
+	void reserve(int n) { cos_rot.reserve(n); sin_rot.reserve(n); tx.reserve(n); ty.reserve(n); }
+	void push_back(const Transformation &t) {
+		const Mat3 &T = t.getMatrix();
+		cos_rot.push_back(T[0]); sin_rot.push_back(T[1]);
+		tx.push_back(t.getTx()); ty.push_back(t.getTy());
+	}
+};
+
+/// Mean corner distance between transformed copies of one shape.
+/** Computes the same value as (a*shape).getMeanCornerDistance(b*shape)
+ * without copying and transforming the shape. As the transformations
+ * rotate around the centroid of the shape, only the corners relative to the
+ * centroid are needed:
+ *   d = 1/K sum_k |(R_a-R_b)*c_k + (t_a-t_b)|
+ * The batch methods evaluate four pose pairs at once using SSE if available.
+ * Results may differ from the PolygonShape version in the last bits. */
+class CornerDistance {
+	public:
+		CornerDistance(const PolygonShape &shape);
+
+		int getCornerCount() const { return m_cx.size(); }
+
+		/// Mean corner distance between the shape transformed by a and by b.
+		float operator()(const Transformation &a, const Transformation &b) const;
+
+		/// Writes the mean corner distances between a[i] and b[i] for all i to out.
+		/** Both arrays must have the same size. */
+		void compute(const PoseArray &a, const PoseArray &b, std::vector<float> &out) const;
+
+		/// Writes the mean corner distances between a[i] and the reference pose for all i to out.
+		void compute(const PoseArray &a, const Transformation &reference, std::vector<float> &out) const;
+
+		/// Returns the sum of the mean corner distances between a[i] and the reference pose.
+		float sum(const PoseArray &a, const Transformation &reference) const;
+
+		/// Raw kernel, all pointers point to n values. The 'b' poses are read
+		/// with a stride of 0 if b_stride is 0, which is used for a single
+		/// reference pose.
+		void compute(int n, const float *a_cos, const float *a_sin, const float *a_tx, const float *a_ty,
+			const float *b_cos, const float *b_sin, const float *b_tx, const float *b_ty, int b_stride,
+			float *out) const;
+
+	private:
+		/// corners relative to the centroid
+		std::vector<float> m_cx, m_cy;
+};
+
+#endif /* __CORNER_DISTANCE_EWEITNAU_H__ */
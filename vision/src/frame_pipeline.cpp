@@ -0,0 +1,194 @@
+// Copyright 2009 Erik Weitnauer
+#include "frame_pipeline.h"
+#include <sstream>
+
+using namespace std;
+using namespace icl;
+
+FramePipeline::FramePipeline(int queue_capacity): m_queue_capacity(queue_capacity),
+		m_running(false), m_next_id(0), m_last_id(-1), m_frame_count(0), m_dropped_count(0) {
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_cond_init(&m_frame_cond, NULL);
+}
+
+FramePipeline::~FramePipeline() {
+	stop();
+	for (unsigned int i=0; i<m_stages.size(); i++) {
+		delete m_stages[i]->output;
+		delete m_stages[i];
+	}
+	pthread_cond_destroy(&m_frame_cond);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void FramePipeline::addStage(const string &name, StageFunction f, void *data) {
+	Stage *stage = new Stage();
+	stage->name = name;
+	stage->function = f;
+	stage->data = data;
+	stage->index = m_stages.size();
+	stage->pipeline = this;
+	stage->input = NULL;
+	stage->output = NULL;
+	if (!m_stages.empty()) {
+		m_stages.back()->output = new FrameQueue(m_queue_capacity);
+		stage->input = m_stages.back()->output;
+	}
+	m_stages.push_back(stage);
+}
+
+void FramePipeline::start() {
+	pthread_mutex_lock(&m_mutex);
+	if (m_running || m_stages.empty()) {
+		pthread_mutex_unlock(&m_mutex);
+		return;
+	}
+	m_running = true;
+	pthread_mutex_unlock(&m_mutex);
+	for (unsigned int i=0; i<m_stages.size(); i++) {
+		if (m_stages[i]->output) m_stages[i]->output->open();
+		pthread_create(&m_stages[i]->thread, NULL, &FramePipeline::run, m_stages[i]);
+	}
+}
+
+void FramePipeline::stop() {
+	pthread_mutex_lock(&m_mutex);
+	if (!m_running) {
+		pthread_mutex_unlock(&m_mutex);
+		return;
+	}
+	m_running = false;
+	pthread_cond_broadcast(&m_frame_cond);
+	pthread_mutex_unlock(&m_mutex);
+	// The source stops after the current frame, then each stage is stopped
+	// after it finished its current frame.
+	for (unsigned int i=0; i<m_stages.size(); i++) {
+		if (m_stages[i]->input) m_stages[i]->input->close();
+		pthread_join(m_stages[i]->thread, NULL);
+	}
+	for (unsigned int i=0; i<m_stages.size(); i++) {
+		VisionFrame *frame;
+		if (m_stages[i]->output) while (m_stages[i]->output->tryPop(frame)) delete frame;
+	}
+}
+
+bool FramePipeline::isRunning() {
+	pthread_mutex_lock(&m_mutex);
+	bool running = m_running;
+	pthread_mutex_unlock(&m_mutex);
+	return running;
+}
+
+int FramePipeline::waitForFrame() {
+	pthread_mutex_lock(&m_mutex);
+	int count = m_frame_count;
+	while (m_running && m_frame_count == count) pthread_cond_wait(&m_frame_cond, &m_mutex);
+	int id = m_frame_count != count ? m_last_id : -1;
+	pthread_mutex_unlock(&m_mutex);
+	return id;
+}
+
+void *FramePipeline::run(void *stage) {
+	Stage *s = (Stage*)stage;
+	if (s->input) s->pipeline->runStage(*s);
+	else s->pipeline->runSource(*s);
+	return NULL;
+}
+
+void FramePipeline::runSource(Stage &stage) {
+	while (isRunning()) {
+		VisionFrame *frame = new VisionFrame();
+		pthread_mutex_lock(&m_mutex);
+		frame->id = m_next_id++;
+		pthread_mutex_unlock(&m_mutex);
+		frame->grab_time = Time::now();
+		process(stage, frame);
+		forward(stage, frame);
+	}
+}
+
+void FramePipeline::runStage(Stage &stage) {
+	VisionFrame *frame;
+	while (stage.input->pop(frame)) {
+		process(stage, frame);
+		forward(stage, frame);
+	}
+}
+
+void FramePipeline::process(Stage &stage, VisionFrame *frame) {
+	Time start = Time::now();
+	stage.function(stage.data, *frame);
+	Time end = Time::now();
+	frame->stage_times.push_back(end);
+	pthread_mutex_lock(&m_mutex);
+	stage.latency.add((end-start).toMicroSecondsDouble()/1000);
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void FramePipeline::forward(Stage &stage, VisionFrame *frame) {
+	if (stage.output) {
+		VisionFrame *dropped;
+		if (stage.output->push(frame, dropped)) {
+			delete dropped;
+			pthread_mutex_lock(&m_mutex);
+			m_dropped_count++;
+			pthread_mutex_unlock(&m_mutex);
+		}
+		return;
+	}
+	pthread_mutex_lock(&m_mutex);
+	m_end_to_end.add((frame->stage_times.back()-frame->grab_time).toMicroSecondsDouble()/1000);
+	m_last_id = frame->id;
+	m_frame_count++;
+	pthread_cond_broadcast(&m_frame_cond);
+	pthread_mutex_unlock(&m_mutex);
+	delete frame;
+}
+
+LatencyHistogram FramePipeline::getStageLatency(int stage) {
+	pthread_mutex_lock(&m_mutex);
+	LatencyHistogram h = m_stages[stage]->latency;
+	pthread_mutex_unlock(&m_mutex);
+	return h;
+}
+
+LatencyHistogram FramePipeline::getEndToEndLatency() {
+	pthread_mutex_lock(&m_mutex);
+	LatencyHistogram h = m_end_to_end;
+	pthread_mutex_unlock(&m_mutex);
+	return h;
+}
+
+int FramePipeline::getFrameCount() {
+	pthread_mutex_lock(&m_mutex);
+	int n = m_frame_count;
+	pthread_mutex_unlock(&m_mutex);
+	return n;
+}
+
+int FramePipeline::getDroppedCount() {
+	pthread_mutex_lock(&m_mutex);
+	int n = m_dropped_count;
+	pthread_mutex_unlock(&m_mutex);
+	return n;
+}
+
+void FramePipeline::resetStatistics() {
+	pthread_mutex_lock(&m_mutex);
+	for (unsigned int i=0; i<m_stages.size(); i++) m_stages[i]->latency.clear();
+	m_end_to_end.clear();
+	m_frame_count = 0;
+	m_dropped_count = 0;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+string FramePipeline::getStatistics() {
+	stringstream s;
+	pthread_mutex_lock(&m_mutex);
+	for (unsigned int i=0; i<m_stages.size(); i++)
+		s << m_stages[i]->name << ": " << m_stages[i]->latency.toString() << endl;
+	s << "end-to-end: " << m_end_to_end.toString() << endl;
+	s << "frames: " << m_frame_count << ", dropped: " << m_dropped_count << endl;
+	pthread_mutex_unlock(&m_mutex);
+	return s.str();
+}
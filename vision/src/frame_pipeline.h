@@ -0,0 +1,115 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __FRAME_PIPELINE_EWEITNAU_H__
+#define __FRAME_PIPELINE_EWEITNAU_H__
+
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include "vision_frame.h"
+#include "bounded_queue.h"
+#include "latency_histogram.h"
+
+/// Processes camera frames in a pipeline with one thread per stage.
+/** The first stage is the source of the frames. It is called in a loop with
+ * a new, empty frame and is expected to block until the next camera image is
+ * available, e.g. by grabbing it. So the pipeline runs at the rate of the
+ * camera or of its slowest stage, whichever is lower.
+ *
+ * Consecutive stages are connected by BoundedQueues. If a stage is slower
+ * than the previous one, the oldest frames in its input queue are dropped, so
+ * each stage always works on the most recent frame available.
+ *
+ * For each stage, a histogram of the processing time is kept. The end-to-end
+ * latency is the time from the start of grabbing a frame until the last stage
+ * finished processing it.
+ *
+ * Usage example:
+ * \code
+ * FramePipeline pipeline;
+ * pipeline.addStage("grab", &grab, &data);
+ * pipeline.addStage("segment", &segment, &data);
+ * pipeline.addStage("draw", &draw, &data);
+ * pipeline.start();
+ * while (true) {
+ *   pipeline.waitForFrame();
+ *   // use the results of the last frame
+ * }
+ * \endcode
+ */
+class FramePipeline {
+	public:
+		/// Called with the passed data and the frame that should be processed.
+		typedef void (*StageFunction)(void *data, VisionFrame &frame);
+
+		/// The queues between the stages hold at most 'queue_capacity' frames.
+		FramePipeline(int queue_capacity=1);
+		/// Stops the pipeline.
+		~FramePipeline();
+
+		/// Appends a stage, must not be called while the pipeline is running.
+		void addStage(const std::string &name, StageFunction f, void *data);
+		int getStageCount() const { return m_stages.size(); }
+		const std::string &getStageName(int stage) const { return m_stages[stage]->name; }
+
+		/// Starts one thread per stage.
+		void start();
+		/// Waits until all stages finished their current frame and stops the threads.
+		/** Frames still waiting in the queues are dropped. */
+		void stop();
+		bool isRunning();
+
+		/// Waits until the next frame has passed the last stage and returns its id.
+		/** Returns -1 if the pipeline is not running or was stopped while waiting. */
+		int waitForFrame();
+
+		/// Processing time histogram of a stage.
+		LatencyHistogram getStageLatency(int stage);
+		/// Histogram of the time from grabbing until the last stage is done.
+		LatencyHistogram getEndToEndLatency();
+		/// Number of frames that passed all stages.
+		int getFrameCount();
+		/// Number of frames that were dropped because a stage was too slow.
+		int getDroppedCount();
+		/// Clears all histograms and counters.
+		void resetStatistics();
+
+		/// Returns one line per stage and one for the end-to-end latency.
+		std::string getStatistics();
+
+	private:
+		typedef BoundedQueue<VisionFrame*> FrameQueue;
+
+		struct Stage {
+			std::string name;
+			StageFunction function;
+			void *data;
+			int index;
+			FramePipeline *pipeline;
+			pthread_t thread;
+			LatencyHistogram latency;
+			FrameQueue *input; ///< NULL for the source stage
+			FrameQueue *output; ///< NULL for the last stage
+		};
+
+		// not copyable
+		FramePipeline(const FramePipeline &);
+		FramePipeline &operator=(const FramePipeline &);
+
+		static void *run(void *stage);
+		void runSource(Stage &stage);
+		void runStage(Stage &stage);
+		/// Calls the stage function and records the timing.
+		void process(Stage &stage, VisionFrame *frame);
+		/// Passes the frame to the next stage or finishes it after the last stage.
+		void forward(Stage &stage, VisionFrame *frame);
+
+		std::vector<Stage*> m_stages;
+		int m_queue_capacity;
+		pthread_mutex_t m_mutex;
+		pthread_cond_t m_frame_cond;
+		bool m_running;
+		int m_next_id, m_last_id, m_frame_count, m_dropped_count;
+		LatencyHistogram m_end_to_end;
+};
+
+#endif /* __FRAME_PIPELINE_EWEITNAU_H__ */
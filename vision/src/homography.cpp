@@ -0,0 +1,107 @@
+// Copyright 2009 Erik Weitnauer
+#include "homography.h"
+#include <cmath>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+using namespace icl;
+
+Homography::Homography() {
+	for (int i=0; i<9; i++) H[i] = (i % 4 == 0) ? 1 : 0;
+}
+
+// Similarity transformation that moves the centroid of the points to the
+// origin and scales their mean distance to it to sqrt(2), as proposed by
+// Hartley for a well conditioned linear system.
+static void getNormalization(const Point32f p[4], double &s, double &cx, double &cy) {
+	cx = cy = 0;
+	for (int i=0; i<4; i++) { cx += p[i].x; cy += p[i].y; }
+	cx /= 4; cy /= 4;
+	double d = 0;
+	for (int i=0; i<4; i++) d += sqrt((p[i].x-cx)*(p[i].x-cx) + (p[i].y-cy)*(p[i].y-cy));
+	s = d > 0 ? sqrt(2.)*4/d : 1;
+}
+
+// Returns false if three of the points are (nearly) collinear. The areas of
+// the triangles are compared after the normalization, so the test does not
+// depend on the scale of the points.
+static bool inGeneralPosition(const Point32f p[4], double s) {
+	for (int i=0; i<4; i++) {
+		// the triangle of the three points other than i
+		const Point32f &a = p[(i+1)%4], &b = p[(i+2)%4], &c = p[(i+3)%4];
+		double area = ((double(b.x)-a.x)*(c.y-a.y) - (double(b.y)-a.y)*(c.x-a.x)) * s*s / 2;
+		if (fabs(area) < 1e-6) return false;
+	}
+	return true;
+}
+
+bool Homography::fit(const Point32f src[4], const Point32f dst[4]) {
+	double ss, scx, scy, ds, dcx, dcy;
+	getNormalization(src, ss, scx, scy);
+	getNormalization(dst, ds, dcx, dcy);
+	if (!inGeneralPosition(src, ss) || !inGeneralPosition(dst, ds)) return false;
+	// each pair gives two rows of the system A*h = b with h[8] = 1:
+	//   h0*x + h1*y + h2 - h6*x*u - h7*y*u = u
+	//   h3*x + h4*y + h5 - h6*x*v - h7*y*v = v
+	double A[8][9];
+	for (int i=0; i<4; i++) {
+		double x = ss*(src[i].x-scx), y = ss*(src[i].y-scy);
+		double u = ds*(dst[i].x-dcx), v = ds*(dst[i].y-dcy);
+		double r0[9] = {x, y, 1, 0, 0, 0, -x*u, -y*u, u};
+		double r1[9] = {0, 0, 0, x, y, 1, -x*v, -y*v, v};
+		for (int j=0; j<9; j++) { A[2*i][j] = r0[j]; A[2*i+1][j] = r1[j]; }
+	}
+	// gaussian elimination with partial pivoting
+	for (int c=0; c<8; c++) {
+		int pivot = c;
+		for (int r=c+1; r<8; r++) if (fabs(A[r][c]) > fabs(A[pivot][c])) pivot = r;
+		if (fabs(A[pivot][c]) < 1e-10) return false;
+		for (int j=0; j<9; j++) { double t = A[c][j]; A[c][j] = A[pivot][j]; A[pivot][j] = t; }
+		for (int r=0; r<8; r++) {
+			if (r == c) continue;
+			double f = A[r][c] / A[c][c];
+			for (int j=c; j<9; j++) A[r][j] -= f*A[c][j];
+		}
+	}
+	double h[9];
+	for (int i=0; i<8; i++) h[i] = A[i][8] / A[i][i];
+	h[8] = 1;
+	// undo the normalizations: H = T_dst^-1 * h * T_src
+	double T[9];
+	for (int r=0; r<3; r++) {
+		T[3*r+0] = ss*h[3*r+0];
+		T[3*r+1] = ss*h[3*r+1];
+		T[3*r+2] = h[3*r+2] - ss*(scx*h[3*r+0] + scy*h[3*r+1]);
+	}
+	double result[9];
+	for (int j=0; j<3; j++) {
+		result[j] = T[j]/ds + dcx*T[6+j];
+		result[3+j] = T[3+j]/ds + dcy*T[6+j];
+		result[6+j] = T[6+j];
+	}
+	for (int i=0; i<9; i++) H[i] = result[i] / result[8];
+	return true;
+}
+
+void Homography::transform(const Point32f *src, Point32f *dst, int n) const {
+	int i = 0;
+#ifdef __SSE__
+	__m128 h0 = _mm_set1_ps(H[0]), h1 = _mm_set1_ps(H[1]), h2 = _mm_set1_ps(H[2]);
+	__m128 h3 = _mm_set1_ps(H[3]), h4 = _mm_set1_ps(H[4]), h5 = _mm_set1_ps(H[5]);
+	__m128 h6 = _mm_set1_ps(H[6]), h7 = _mm_set1_ps(H[7]), h8 = _mm_set1_ps(H[8]);
+	for (; i+4<=n; i+=4) {
+		// the points are stored as x0 y0 x1 y1 x2 y2 x3 y3
+		__m128 a = _mm_loadu_ps(&src[i].x);
+		__m128 b = _mm_loadu_ps(&src[i+2].x);
+		__m128 x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+		__m128 y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+		__m128 w = _mm_add_ps(_mm_add_ps(_mm_mul_ps(h6,x), _mm_mul_ps(h7,y)), h8);
+		__m128 u = _mm_div_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(h0,x), _mm_mul_ps(h1,y)), h2), w);
+		__m128 v = _mm_div_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(h3,x), _mm_mul_ps(h4,y)), h5), w);
+		_mm_storeu_ps(&dst[i].x, _mm_unpacklo_ps(u, v));
+		_mm_storeu_ps(&dst[i+2].x, _mm_unpackhi_ps(u, v));
+	}
+#endif
+	for (; i<n; i++) dst[i] = (*this)(src[i]);
+}
@@ -0,0 +1,37 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __HOMOGRAPHY_EWEITNAU_H__
+#define __HOMOGRAPHY_EWEITNAU_H__
+
+#include <ICLUtils/Point32f.h>
+
+/// Projective transformation of 2d points.
+/** A point p is transformed to (H*(p.x, p.y, 1)) / w, where w is the third
+ * component of the product. The matrix is stored row major with H[8] = 1.
+ *
+ * The projection of a plane in the world onto the camera image and the
+ * intersection of view rays with a plane are such transformations, see
+ * CameraTransformer. */
+class Homography {
+	public:
+		/// Creates the identity.
+		Homography();
+
+		/// Calculates the homography which maps the four src points onto the four dst points.
+		/** Returns false and leaves the homography unchanged, if three of the
+		 * src or three of the dst points are collinear or the system is
+		 * singular for another reason. */
+		bool fit(const icl::Point32f src[4], const icl::Point32f dst[4]);
+
+		icl::Point32f operator()(const icl::Point32f &p) const {
+			float w = H[6]*p.x + H[7]*p.y + H[8];
+			return icl::Point32f((H[0]*p.x + H[1]*p.y + H[2]) / w, (H[3]*p.x + H[4]*p.y + H[5]) / w);
+		}
+
+		/// Transforms n points from src to dst, both arrays may be the same.
+		/** Four points are transformed at once using SSE if available. */
+		void transform(const icl::Point32f *src, icl::Point32f *dst, int n) const;
+
+		float H[9];
+};
+
+#endif /* __HOMOGRAPHY_EWEITNAU_H__ */
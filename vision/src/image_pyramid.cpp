@@ -0,0 +1,74 @@
+// Copyright 2009 Erik Weitnauer
+#include "image_pyramid.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace icl;
+
+void halveImage(const Img8u &src, Img8u &dst) {
+	int w = src.getWidth()/2, h = src.getHeight()/2, sw = src.getWidth();
+	dst.setChannels(1);
+	dst.setSize(Size(w, h));
+	for (int y=0; y<h; y++) {
+		const icl8u *r0 = src.getData(0) + 2*y*sw, *r1 = r0 + sw;
+		icl8u *d = dst.getData(0) + y*w;
+		int x = 0;
+#ifdef __SSE2__
+		const __m128i low = _mm_set1_epi16(0xFF);
+		for (; x+16<=w; x+=16) {
+			__m128i a = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(r0+2*x)),
+				_mm_loadu_si128((const __m128i*)(r1+2*x)));
+			__m128i b = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(r0+2*x+16)),
+				_mm_loadu_si128((const __m128i*)(r1+2*x+16)));
+			// average the even and odd columns in 16 bit
+			a = _mm_avg_epu16(_mm_and_si128(a, low), _mm_srli_epi16(a, 8));
+			b = _mm_avg_epu16(_mm_and_si128(b, low), _mm_srli_epi16(b, 8));
+			_mm_storeu_si128((__m128i*)(d+x), _mm_packus_epi16(a, b));
+		}
+#endif
+		for (; x<w; x++) {
+			int a = (r0[2*x] + r1[2*x] + 1) >> 1, b = (r0[2*x+1] + r1[2*x+1] + 1) >> 1;
+			d[x] = (a + b + 1) >> 1;
+		}
+	}
+}
+
+void reduceImage(const Img8u &src, Img8u &dst, int factor, Img8u &tmp) {
+	if (factor <= 1) {
+		src.deepCopy(&dst);
+		return;
+	}
+	// halve alternately into dst and tmp, so the last level ends up in dst
+	int levels = 0;
+	for (int f=factor; f>1; f/=2) levels++;
+	const Img8u *cur = &src;
+	for (int i=levels; i>0; i--) {
+		Img8u *next = (i % 2 == 1) ? &dst : &tmp;
+		halveImage(*cur, *next);
+		cur = next;
+	}
+}
+
+void classifyContourBand(const Img8u &src, Img8u &dst) {
+	int w = src.getWidth(), h = src.getHeight();
+	dst.setChannels(1);
+	dst.setSize(src.getSize());
+	const icl8u *s = src.getData(0);
+	icl8u *d = dst.getData(0);
+	for (int y=0; y<h; y++) {
+		int y0 = max(0, y-1), y1 = min(h-1, y+1);
+		for (int x=0; x<w; x++) {
+			int x0 = max(0, x-1), x1 = min(w-1, x+1);
+			bool all_set = true, none_set = true;
+			for (int yy=y0; yy<=y1; yy++) {
+				for (int xx=x0; xx<=x1; xx++) {
+					if (s[yy*w+xx]) none_set = false;
+					else all_set = false;
+				}
+			}
+			d[y*w+x] = all_set ? 255 : (none_set ? 0 : 128);
+		}
+	}
+}
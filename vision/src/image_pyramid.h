@@ -0,0 +1,24 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __IMAGE_PYRAMID_EWEITNAU_H__
+#define __IMAGE_PYRAMID_EWEITNAU_H__
+
+#include <ICLCore/Img.h>
+
+/// Writes the first channel of src with half the width and height to dst.
+/** Each pixel of dst is the mean of a 2x2 block of src, the last row and
+ * column are dropped for odd sizes. With SSE2, 16 pixels of dst are
+ * calculated at once by averaging the two rows and then the neighbouring
+ * columns with rounding, which may give one more than the exact mean. */
+void halveImage(const icl::Img8u &src, icl::Img8u &dst);
+
+/// Reduces the first channel of src by 'factor', which must be a power of 2.
+/** Calls halveImage() repeatedly, 'tmp' is used for the levels in between. */
+void reduceImage(const icl::Img8u &src, icl::Img8u &dst, int factor, icl::Img8u &tmp);
+
+/// Classifies each pixel of a binary image by its 3x3 neighbourhood.
+/** dst is 255 if all neighbours are 255, 0 if all are 0 and 128 otherwise,
+ * which marks a band of width 2 around each contour. The neighbourhood is
+ * clipped at the image border. */
+void classifyContourBand(const icl::Img8u &src, icl::Img8u &dst);
+
+#endif /* __IMAGE_PYRAMID_EWEITNAU_H__ */
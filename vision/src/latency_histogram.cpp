@@ -0,0 +1,43 @@
+// Copyright 2009 Erik Weitnauer
+#include "latency_histogram.h"
+#include <sstream>
+
+using namespace std;
+
+LatencyHistogram::LatencyHistogram(float bin_width_ms, int bins):
+	m_bin_width(bin_width_ms), m_bins(bins+1, 0), m_count(0), m_sum(0), m_max(0) {}
+
+void LatencyHistogram::add(float ms) {
+	int bin = ms < 0 ? 0 : (int)(ms/m_bin_width);
+	if (bin >= (int)m_bins.size()) bin = m_bins.size()-1;
+	m_bins[bin]++;
+	m_count++;
+	m_sum += ms;
+	if (ms > m_max) m_max = ms;
+}
+
+void LatencyHistogram::clear() {
+	m_bins.assign(m_bins.size(), 0);
+	m_count = 0;
+	m_sum = m_max = 0;
+}
+
+float LatencyHistogram::getPercentile(float p) const {
+	if (m_count == 0) return 0;
+	int rank = (int)(p/100*m_count+0.5);
+	if (rank < 1) rank = 1;
+	int sum = 0;
+	for (unsigned int i=0; i<m_bins.size()-1; i++) {
+		sum += m_bins[i];
+		if (sum >= rank) return (i+1)*m_bin_width;
+	}
+	return m_max;
+}
+
+string LatencyHistogram::toString() const {
+	stringstream s;
+	s.precision(3);
+	s << "n=" << m_count << " mean=" << getMean() << " p50=" << getPercentile(50)
+		<< " p95=" << getPercentile(95) << " p99=" << getPercentile(99) << " max=" << m_max << " ms";
+	return s.str();
+}
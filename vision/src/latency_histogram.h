@@ -0,0 +1,35 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __LATENCY_HISTOGRAM_EWEITNAU_H__
+#define __LATENCY_HISTOGRAM_EWEITNAU_H__
+
+#include <vector>
+#include <string>
+
+/// Histogram of latencies in milliseconds with bins of fixed width.
+/** Latencies above the last bin are counted in an overflow bin. Percentiles
+ * are returned as the upper border of the bin that contains them, so they
+ * are accurate up to the bin width. The class is not thread-safe. */
+class LatencyHistogram {
+	public:
+		LatencyHistogram(float bin_width_ms=1, int bins=500);
+
+		void add(float ms);
+		void clear();
+
+		int getCount() const { return m_count; }
+		float getMean() const { return m_count ? m_sum/m_count : 0; }
+		float getMax() const { return m_max; }
+		/// Returns the latency below which p percent of the values are, p in [0,100].
+		float getPercentile(float p) const;
+
+		/// Returns e.g. "n=120 mean=33.1 p50=32 p95=41 p99=58 max=61.3 ms".
+		std::string toString() const;
+
+	private:
+		float m_bin_width;
+		std::vector<int> m_bins; // last bin is the overflow bin
+		int m_count;
+		float m_sum, m_max;
+};
+
+#endif /* __LATENCY_HISTOGRAM_EWEITNAU_H__ */
@@ -0,0 +1,106 @@
+// Copyright 2009 Erik Weitnauer
+#include "local_threshold.h"
+#include <cstdlib>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace icl;
+
+#ifdef __SSE2__
+/// Products of the lower 32 bits of four ints, SSE2 has no _mm_mullo_epi32.
+static inline __m128i mullo32(__m128i a, __m128i b) {
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+		_mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+}
+#endif
+
+LocalThreshold::LocalThreshold(int mask_size, int global_threshold, int threads):
+	m_mask_size(mask_size), m_global_threshold(global_threshold), m_pool(threads),
+	m_width(0), m_height(0), m_src(NULL), m_dst(NULL) {}
+
+void LocalThreshold::apply(const Img8u &src, Img8u &dst) {
+	calculateIntegral(src);
+	dst.setChannels(1);
+	dst.setSize(src.getSize());
+	m_src = &src;
+	m_dst = &dst;
+	int tiles = (m_height+TILE_HEIGHT-1) / TILE_HEIGHT;
+	m_pool.parallelFor(tiles, &LocalThreshold::process, this);
+}
+
+void LocalThreshold::calculateIntegral(const Img8u &src) {
+	m_width = src.getWidth();
+	m_height = src.getHeight();
+	unsigned int size = (m_width+1)*(m_height+1);
+	// the first row and column stay 0
+	if (m_integral.size() != size) m_integral.assign(size, 0);
+	const icl8u *data = src.getData(0);
+	for (int y=0; y<m_height; y++) {
+		const icl8u *row = data + y*m_width;
+		const unsigned int *above = &m_integral[y*(m_width+1)];
+		unsigned int *cur = &m_integral[(y+1)*(m_width+1)];
+		unsigned int sum = 0;
+		for (int x=0; x<m_width; x++) {
+			sum += row[x];
+			cur[x+1] = above[x+1] + sum;
+		}
+	}
+}
+
+void LocalThreshold::process(void *op, int task, int thread) {
+	LocalThreshold *t = (LocalThreshold*)op;
+	int w = t->m_width;
+	const icl8u *src = t->m_src->getData(0);
+	icl8u *dst = t->m_dst->getData(0);
+	int end = min(t->m_height, (task+1)*TILE_HEIGHT);
+	for (int y=task*TILE_HEIGHT; y<end; y++) t->thresholdRow(y, src + y*w, dst + y*w);
+}
+
+void LocalThreshold::thresholdRow(int y, const icl8u *src, icl8u *dst) const {
+	int w = m_width, r = m_mask_size, g = m_global_threshold;
+	int ny = min(m_height, y+r+1) - max(0, y-r);
+	const unsigned int *top = &m_integral[max(0, y-r)*(w+1)];
+	const unsigned int *bottom = &m_integral[min(m_height, y+r+1)*(w+1)];
+	// in the interior, the whole width of the mask is inside the image
+	int first = min(r, w), last = max(first, w-r);
+	for (int x=0; x<w; x++) {
+		if (x == first) x = last;
+		if (x >= w) break;
+		int x0 = max(0, x-r), x1 = min(w, x+r+1);
+		unsigned int sum = (bottom[x1]-top[x1]) - (bottom[x0]-top[x0]);
+		long long n = (x1-x0)*ny;
+		dst[x] = (long long)(src[x]-g)*n > (long long)sum ? 255 : 0;
+	}
+
+	long long n = (long long)(2*r+1)*ny;
+	int x = first;
+#ifdef __SSE2__
+	// the products must fit into 32 bit
+	if ((255+abs(g))*n < 0x7FFFFFFF) {
+		__m128i vn = _mm_set1_epi32(n), vg = _mm_set1_epi32(g), zero = _mm_setzero_si128();
+		for (; x+4<=last; x+=4) {
+			__m128i hi = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(bottom+x+r+1)),
+				_mm_loadu_si128((const __m128i*)(top+x+r+1)));
+			__m128i lo = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(bottom+x-r)),
+				_mm_loadu_si128((const __m128i*)(top+x-r)));
+			__m128i sum = _mm_sub_epi32(hi, lo);
+			int pixels;
+			memcpy(&pixels, src+x, 4);
+			__m128i v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(pixels), zero), zero);
+			__m128i mask = _mm_cmpgt_epi32(mullo32(_mm_sub_epi32(v, vg), vn), sum);
+			mask = _mm_packs_epi32(mask, mask);
+			pixels = _mm_cvtsi128_si32(_mm_packs_epi16(mask, mask));
+			memcpy(dst+x, &pixels, 4);
+		}
+	}
+#endif
+	for (; x<last; x++) {
+		unsigned int sum = (bottom[x+r+1]-top[x+r+1]) - (bottom[x-r]-top[x-r]);
+		dst[x] = (long long)(src[x]-g)*n > (long long)sum ? 255 : 0;
+	}
+}
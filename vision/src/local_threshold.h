@@ -0,0 +1,64 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __LOCAL_THRESHOLD_EWEITNAU_H__
+#define __LOCAL_THRESHOLD_EWEITNAU_H__
+
+#include <ICLCore/Img.h>
+#include <vector>
+#include "thread_pool.h"
+
+/// Adaptive threshold with the mean of a square neighbourhood, like the icl::LocalThresholdOp.
+/**
+ A pixel becomes 255 if its value is bigger than the mean of the
+ (2*mask_size+1) x (2*mask_size+1) pixels around it plus the global threshold,
+ otherwise 0. At the image border, the mean of the part of the square inside
+ the image is used.
+
+ The sums of the squares are taken from an integral image, so the run time
+ does not depend on the mask size. The integral image is only reallocated if
+ the image size changes. The thresholding runs on horizontal tiles of the
+ image in the threads of a ThreadPool, with four pixels at a time using SSE2
+ if available. The comparison is done in integer arithmetic, so the results
+ don't depend on SSE2 or the number of threads.
+
+ Usage example:
+ \code
+ LocalThreshold t(35, -10);
+ t.apply(distance_image, threshold_image);
+ \endcode
+*/
+class LocalThreshold {
+	public:
+		/// Uses a pool with 'threads' threads, see ThreadPool::ThreadPool().
+		LocalThreshold(int mask_size=35, int global_threshold=0, int threads=0);
+
+		void setMaskSize(int mask_size) { m_mask_size = mask_size; }
+		int getMaskSize() const { return m_mask_size; }
+		void setGlobalThreshold(int global_threshold) { m_global_threshold = global_threshold; }
+		int getGlobalThreshold() const { return m_global_threshold; }
+
+		/// Thresholds the first channel of src and writes it to dst.
+		/** dst is resized to the size of src and gets one channel. */
+		void apply(const icl::Img8u &src, icl::Img8u &dst);
+
+	private:
+		/// Rows per tile.
+		enum { TILE_HEIGHT = 32 };
+
+		/// Calculates the integral image of the first channel of src.
+		void calculateIntegral(const icl::Img8u &src);
+		/// Thresholds the rows of tile 'task'.
+		static void process(void *op, int task, int thread);
+		void thresholdRow(int y, const icl::icl8u *src, icl::icl8u *dst) const;
+
+		int m_mask_size;
+		int m_global_threshold;
+		ThreadPool m_pool;
+		int m_width, m_height;
+		/// (width+1) x (height+1) sums of all pixels above and left of each
+		/// pixel. The sums may overflow, the differences are still correct.
+		std::vector<unsigned int> m_integral;
+		const icl::Img8u *m_src;
+		icl::Img8u *m_dst;
+};
+
+#endif /* __LOCAL_THRESHOLD_EWEITNAU_H__ */
@@ -101,6 +101,31 @@ bool PolygonMapper::mapPolygonObject(
 }
 
 
+MappingModel::MappingModel(const PolygonShape &model, float dynThresh):
+		m_shape(&model), m_n(model.getCorners().size()), m_center(model.getCenter()),
+		m_angle0(0), m_radius0_sqr(0), m_diagonal(LinAlg::diagonalLength(model.getBoundingBox())),
+		m_dyn_thresh(dynThresh), m_threshold(0) {
+	if (!isSupported(model)) return;
+	const vector<Point32f> &cm = model.getCorners();
+	for (int i=0; i<m_n; i++) {
+		m_x[i] = cm[i].x-m_center.x;
+		m_y[i] = cm[i].y-m_center.y;
+	}
+	m_angle0 = atan2(cm[0].y-m_center.y, cm[0].x-m_center.x);
+	m_radius0_sqr = LinAlg::distance2(cm[0], m_center);
+	float scaling = 1.;
+	m_threshold = pow(scaling*m_diagonal*m_dyn_thresh,2) * model.getCorners().size();
+}
+
+MappingTarget::MappingTarget(const PolygonShape &target):
+		n(target.getCorners().size()), center(target.getCenter()) {
+	if (n > MappingModel::MAX_CORNERS) n = MappingModel::MAX_CORNERS;
+	for (int i=0; i<n; i++) {
+		corners[i] = target.getCorners()[i];
+		angle[i] = atan2(corners[i].y-center.y, corners[i].x-center.x);
+	}
+}
+
 /// Calls mapPolygon() for each of the model polygons and collects results.
 vector<PolygonObject> PolygonMapper::mapPolygonShapes(
 		const PolygonShape &target,
@@ -109,15 +134,143 @@ vector<PolygonObject> PolygonMapper::mapPolygonShapes(
 	  bool sortResult,
 	  bool useScaling) {
 	vector<PolygonObject> maps;
+	bool target_supported = target.getCorners().size() <= MappingModel::MAX_CORNERS;
+	MappingTarget t(target);
+	for (unsigned int i=0; i<models.size(); i++) {
+		if (target_supported && MappingModel::isSupported(models[i]))
+			mapModel(t, MappingModel(models[i], dynThresh), useScaling, maps);
+		else mapPolygonShapeGeneral(target, models[i], dynThresh, useScaling, maps);
+	}
 	
+	if (sortResult) sort(maps.begin(), maps.end());
+	return maps;
+}
+
+vector<PolygonObject> PolygonMapper::mapPolygonShapes(
+		const PolygonShape &target,
+	  const std::vector<MappingModel> &models,
+	  bool sortResult,
+	  bool useScaling,
+	  int icpIterations) {
+	vector<PolygonObject> maps;
+	bool target_supported = target.getCorners().size() <= MappingModel::MAX_CORNERS;
+	MappingTarget t(target);
 	for (unsigned int i=0; i<models.size(); i++) {
-		vector<PolygonObject> curr_maps = mapPolygonShape(target, models[i], dynThresh, false, useScaling);
-		maps.insert(maps.end(), curr_maps.begin(), curr_maps.end());
+		if (target_supported && MappingModel::isSupported(models[i].getShape()))
+			mapModel(t, models[i], useScaling, maps, icpIterations);
+		else mapPolygonShapeGeneral(target, models[i].getShape(), models[i].getDynThresh(), useScaling, maps, icpIterations);
 	}
 	
 	if (sortResult) sort(maps.begin(), maps.end());
 	return maps;
 }
+
+vector<PolygonObject> PolygonMapper::mapPolygonShape(
+		const PolygonShape &target,
+		const PolygonShape &model,
+		float dynThresh,
+		bool sortResult,
+		bool useScaling) {
+	vector<PolygonObject> maps;
+	if (target.getCorners().size() <= MappingModel::MAX_CORNERS && MappingModel::isSupported(model))
+		mapModel(MappingTarget(target), MappingModel(model, dynThresh), useScaling, maps);
+	else mapPolygonShapeGeneral(target, model, dynThresh, useScaling, maps);
+	
+	if (sortResult) sort(maps.begin(), maps.end());
+	return maps;	
+}
+
+// Same algorithm as in mapPolygonShapeGeneral(), see there. The transformed
+// model corners are calculated in the same order of operations as in
+// LinAlg::transformedAround(), so the results are identical.
+int PolygonMapper::mapModel(const MappingTarget &t, const MappingModel &m,
+		bool useScaling, float maxRotation, Mapping *maps, int icpIterations) {
+	int count = 0;
+	// step (1)
+	float tx = t.center.x - m.m_center.x;
+	float ty = t.center.y - m.m_center.y;
+	float mx[MappingModel::MAX_CORNERS], my[MappingModel::MAX_CORNERS];
+	vector<Point32f> ct;
+	if (icpIterations >= 0) ct.assign(t.corners, t.corners+t.n);
+	// step (3)
+	for (int j = 0; j < t.n; j++) {
+		float theta = m.m_angle0-t.angle[j];
+		if (maxRotation >= 0) {
+			float rotation = theta;
+			if (rotation > M_PI) rotation -= 2*M_PI;
+			else if (rotation < -M_PI) rotation += 2*M_PI;
+			if (fabs(rotation) > maxRotation) continue;
+		}
+		// step (3a)
+		float scaling = useScaling ? sqrt( LinAlg::distance2(t.corners[j],t.center) /
+		                                   m.m_radius0_sqr )
+		                           : 1.;
+		// step (3b)
+		float c = scaling*cos(theta), s = scaling*sin(theta);
+		for (int i = 0; i < m.m_n; i++) {
+			mx[i] = c*m.m_x[i] + s*m.m_y[i] + tx + m.m_center.x;
+			my[i] = -s*m.m_x[i] + c*m.m_y[i] + ty + m.m_center.y;
+		}
+		// step (3c)
+		float error_t = 0;
+		for (int i = 0; i < t.n; i++) {
+			float dist2 = -1;
+			for (int k = 0; k < m.m_n; k++) {
+				float curr = (t.corners[i].x-mx[k])*(t.corners[i].x-mx[k]) + (t.corners[i].y-my[k])*(t.corners[i].y-my[k]);
+				if ((dist2 == -1) || (curr < dist2)) dist2 = curr;
+			}
+			error_t += dist2;
+		}
+		// step (3d)
+		float error_m = 0;
+		for (int i = 0; i < m.m_n; i++) {
+			float dist2 = -1;
+			for (int k = 0; k < t.n; k++) {
+				float curr = (mx[i]-t.corners[k].x)*(mx[i]-t.corners[k].x) + (my[i]-t.corners[k].y)*(my[i]-t.corners[k].y);
+				if ((dist2 == -1) || (curr < dist2)) dist2 = curr;
+			}
+			error_m += dist2;
+		}
+		// step (3e)
+		float threshold = useScaling ? pow(scaling*m.m_diagonal*m.m_dyn_thresh,2) * m.getShape().getCorners().size()
+		                             : m.m_threshold;
+		float error = max(error_t, error_m);
+		float rotation = theta, mtx = tx, mty = ty;
+		if (icpIterations >= 0) {
+			// accept the mapping by the error of the refined transformation
+			Transformation refined(theta, tx, ty);
+			error = refineCorners(ct, m.getShape().getCorners(), m.m_center, scaling, refined, icpIterations);
+			rotation = refined.getRotation(); mtx = refined.getTx(); mty = refined.getTy();
+			c = scaling*cos(rotation); s = scaling*sin(rotation);
+			for (int i = 0; i < m.m_n; i++) {
+				mx[i] = c*m.m_x[i] + s*m.m_y[i] + mtx + m.m_center.x;
+				my[i] = -s*m.m_x[i] + c*m.m_y[i] + mty + m.m_center.y;
+			}
+		}
+		if (error > threshold) continue;
+		Mapping &mapping = maps[count++];
+		mapping.rotation = rotation;
+		mapping.tx = mtx; mapping.ty = mty;
+		mapping.scaling = scaling;
+		mapping.error = error;
+		mapping.corner_movement = 0;
+		for (int i = 0; i < m.m_n; i++) {
+			float dx = mx[i]-m.m_center.x-m.m_x[i], dy = my[i]-m.m_center.y-m.m_y[i];
+			mapping.corner_movement += sqrt(dx*dx + dy*dy);
+		}
+		mapping.corner_movement /= m.m_n;
+	}
+	return count;
+}
+
+void PolygonMapper::mapModel(const MappingTarget &t, const MappingModel &m,
+		bool useScaling, vector<PolygonObject> &maps, int icpIterations) {
+	Mapping found[MappingModel::MAX_CORNERS];
+	int n = mapModel(t, m, useScaling, -1, found, icpIterations);
+	for (int i = 0; i < n; i++)
+		maps.push_back(PolygonObject(Transformation(found[i].rotation, found[i].tx, found[i].ty),
+			found[i].scaling, m.getShape(), found[i].error));
+}
 		  		  
 /*
 This function will map an (model) polygon to an (observed, target) polygon.
@@ -139,14 +292,13 @@ Algorithm:
 	(3e) add the mapping to the result vector, if E_t[i] and E_m[i] are
 		   both smaller than a threshold
 */
-vector<PolygonObject> PolygonMapper::mapPolygonShape(
+void PolygonMapper::mapPolygonShapeGeneral(
 		const PolygonShape &target,
 		const PolygonShape &model,
 		float dynThresh,
-		bool sortResult,
-		bool useScaling) {
-	vector<PolygonObject> maps;
-
+		bool useScaling,
+		vector<PolygonObject> &maps,
+		int icpIterations) {
   Point32f centerm = model.getCenter();
   Point32f centerr = target.getCenter();
   
@@ -162,7 +314,7 @@ vector<PolygonObject> PolygonMapper::mapPolygonShape(
 	// step (3)
 	vector<Point32f> ct = target.getCorners();
   vector<Point32f> cm = model.getCorners();
-	float error_m[cm.size()];
+	float error_m[ct.size()];
 	float error_t[ct.size()];
 	for (unsigned int j = 0; j < ct.size(); j++) {
 	  //cout << "==Fitting " << cm0 << " to " << ct[j] << ":" << endl;
@@ -192,11 +344,120 @@ vector<PolygonObject> PolygonMapper::mapPolygonShape(
 											model.getCorners().size();
 		//cout << "Error threshold is " << threshold << endl;
 		float error = max(error_t[j], error_m[j]);
+		Transformation t(theta, tx, ty);
+		if (icpIterations >= 0) error = refineTransformation(target, model, scaling, t, icpIterations);
 	  if (error <= threshold) 
-	  	maps.push_back(PolygonObject(Transformation(theta, tx, ty), scaling, model, error));
+	  	maps.push_back(PolygonObject(t, scaling, model, error));
 	}
-	
-	if (sortResult) sort(maps.begin(), maps.end());
-	return maps;	
 }
 		
+
+// Transforms the model corners like PolygonObject::updateTransformedShape():
+// rotation around the center, translation and then scaling around the new center.
+static void transformCorners(const vector<Point32f> &cm, const Point32f &center,
+		float scaling, const Transformation &t, vector<Point32f> &result) {
+	float c = cos(t.getRotation()), s = sin(t.getRotation());
+	result.resize(cm.size());
+	for (unsigned int i=0; i<cm.size(); i++) {
+		float ax = scaling*(cm[i].x-center.x), ay = scaling*(cm[i].y-center.y);
+		result[i].x = center.x + t.getTx() + c*ax + s*ay;
+		result[i].y = center.y + t.getTy() - s*ax + c*ay;
+	}
+}
+
+// Same error as in step (3e) of mapPolygonShape().
+static float getMappingError(const vector<Point32f> &ct, const vector<Point32f> &cm_t) {
+	float error_t = 0, error_m = 0;
+	for (unsigned int i=0; i<ct.size(); i++) error_t += LinAlg::closestDistanceSqr(ct[i], cm_t);
+	for (unsigned int i=0; i<cm_t.size(); i++) error_m += LinAlg::closestDistanceSqr(cm_t[i], ct);
+	return max(error_t, error_m);
+}
+
+// Pairs each transformed model corner with the closest target corner. Returns
+// true if any of the pairs changed.
+static bool pairCorners(const vector<Point32f> &cm_t, const vector<Point32f> &ct,
+		vector<int> &pairs) {
+	bool changed = false;
+	pairs.resize(cm_t.size(), -1);
+	for (unsigned int i=0; i<cm_t.size(); i++) {
+		int closest = -1;
+		float dist2 = -1;
+		for (unsigned int j=0; j<ct.size(); j++) {
+			float curr = LinAlg::distance2(cm_t[i], ct[j]);
+			if ((dist2 == -1) || (curr < dist2)) { dist2 = curr; closest = j; }
+		}
+		if (pairs[i] != closest) { pairs[i] = closest; changed = true; }
+	}
+	return changed;
+}
+
+float PolygonMapper::refineTransformation(
+		const PolygonShape &target,
+		const PolygonShape &model,
+		float scaling,
+		Transformation &t,
+		int icpIterations) {
+	return refineCorners(target.getCorners(), model.getCorners(), model.getCenter(), scaling, t, icpIterations);
+}
+
+float PolygonMapper::refineCorners(
+		const vector<Point32f> &ct,
+		const vector<Point32f> &cm,
+		const Point32f &center,
+		float scaling,
+		Transformation &t,
+		int icpIterations) {
+	if (ct.empty() || cm.empty()) return 0;
+	vector<Point32f> cm_t;
+	transformCorners(cm, center, scaling, t, cm_t);
+	float error = getMappingError(ct, cm_t);
+
+	vector<int> pairs;
+	Transformation refined = t;
+	pairCorners(cm_t, ct, pairs);
+	for (int iteration=0; iteration<=icpIterations; iteration++) {
+		// Minimize sum_i ||R*a_i + center + t - b_i||^2, where a_i are the scaled
+		// model corners relative to the center and b_i the paired target corners.
+		// With both point sets centered on their means, the optimal rotation
+		// maximizes sum_i b_i^T*R*a_i, which gives theta in closed form.
+		float mean_ax = 0, mean_ay = 0, mean_bx = 0, mean_by = 0;
+		for (unsigned int i=0; i<cm.size(); i++) {
+			mean_ax += scaling*(cm[i].x-center.x); mean_ay += scaling*(cm[i].y-center.y);
+			mean_bx += ct[pairs[i]].x; mean_by += ct[pairs[i]].y;
+		}
+		mean_ax /= cm.size(); mean_ay /= cm.size();
+		mean_bx /= cm.size(); mean_by /= cm.size();
+		float dot = 0, cross = 0;
+		for (unsigned int i=0; i<cm.size(); i++) {
+			float ax = scaling*(cm[i].x-center.x)-mean_ax, ay = scaling*(cm[i].y-center.y)-mean_ay;
+			float bx = ct[pairs[i]].x-mean_bx, by = ct[pairs[i]].y-mean_by;
+			dot += bx*ax + by*ay;
+			cross += bx*ay - by*ax;
+		}
+		float theta = atan2(cross, dot);
+		float c = cos(theta), s = sin(theta);
+		// keep the rotation close to the one of the passed transformation
+		theta += 2*M_PI*round((t.getRotation()-theta)/(2*M_PI));
+		refined = Transformation(theta,
+			mean_bx - (c*mean_ax + s*mean_ay) - center.x,
+			mean_by - (-s*mean_ax + c*mean_ay) - center.y);
+		transformCorners(cm, center, scaling, refined, cm_t);
+		if (!pairCorners(cm_t, ct, pairs)) break;
+	}
+
+	float refined_error = getMappingError(ct, cm_t);
+	if (refined_error > error) return error;
+	t = refined;
+	return refined_error;
+}
+
+float PolygonMapper::refineMapping(
+		const PolygonShape &target,
+		PolygonObject &mapping,
+		int icpIterations) {
+	Transformation t = mapping.getTransformation();
+	float error = refineTransformation(target, mapping.getShape(), mapping.getScaling(), t, icpIterations);
+	mapping.setTranformation(t);
+	mapping.setError(error);
+	return error;
+}
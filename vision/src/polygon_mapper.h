@@ -10,6 +10,51 @@
 #include "polygon_shape.h"
 #include "polygon_object.h"
 
+/// Model polygon prepared for being mapped onto many targets by the PolygonMapper.
+/** The corners relative to the center, the angle of the first corner and the
+ * error threshold only depend on the model, so they are calculated once in
+ * the constructor. The corners are stored in fixed size arrays, so mapping
+ * does not allocate memory. Polygons with more than MAX_CORNERS corners are
+ * mapped with the general vector based implementation instead.
+ * The model shape is referenced, not copied, so it must outlive the
+ * MappingModel. */
+class MappingModel {
+	public:
+		enum { MAX_CORNERS = 5 };
+
+		MappingModel(const PolygonShape &model, float dynThresh=0.1);
+
+		/// True if the shape has between 1 and MAX_CORNERS corners.
+		static bool isSupported(const PolygonShape &shape) {
+			return shape.getCorners().size() > 0 && shape.getCorners().size() <= MAX_CORNERS;
+		}
+
+		const PolygonShape &getShape() const { return *m_shape; }
+		float getDynThresh() const { return m_dyn_thresh; }
+
+	private:
+		friend class PolygonMapper;
+		const PolygonShape *m_shape;
+		int m_n;
+		float m_x[MAX_CORNERS], m_y[MAX_CORNERS]; ///< corners relative to center
+		icl::Point32f m_center;
+		float m_angle0; ///< angle of the first corner relative to the center
+		float m_radius0_sqr; ///< squared distance of the first corner to the center
+		float m_diagonal, m_dyn_thresh;
+		float m_threshold; ///< error threshold without scaling
+};
+
+/// Target polygon prepared for being mapped onto many MappingModels.
+/** Stores the first MappingModel::MAX_CORNERS corners of the polygon and
+ * their angles relative to its center. */
+struct MappingTarget {
+	MappingTarget(const PolygonShape &target);
+	int n;
+	icl::Point32f corners[MappingModel::MAX_CORNERS];
+	icl::Point32f center;
+	float angle[MappingModel::MAX_CORNERS];
+};
+
 /// Searches for a 2d transformation (rotation, translation, scaling) that will map a polygon shape / polygon object as closely as possible on another polygon shape.
 /**
 PolygonMapper defines four static methods.
@@ -83,6 +128,19 @@ class PolygonMapper {
 		  bool sortResult=true,
 		  bool useScaling=false);
 
+		/// Same as above, but with prepared models.
+		/** Use this method to map many targets onto the same set of models. The
+		 * dynThresh passed to the constructors of the models is used. With
+		 * icpIterations >= 0, each mapping is refined with refineTransformation()
+		 * before its error is compared to the threshold, so the mappings are
+		 * accepted and sorted by their refined error. */
+		static std::vector<PolygonObject> mapPolygonShapes(
+			const PolygonShape &target,
+		  const std::vector<MappingModel> &models,
+		  bool sortResult=true,
+		  bool useScaling=false,
+		  int icpIterations=-1);
+
 		/// Transforms the passed polygon object onto the polygon shape if possible.
 		/** If the polygon object could be mapped onto the shape, its transformation
 		 * is updated, its last_active_time is set to the passed current time and
@@ -117,8 +175,66 @@ class PolygonMapper {
 		  float dynThresh=0.1,
 		  float maxRotation=-1,
 		  float maxTranslation=-1);
+
+		/// Refines the transformation of a mapping by a least squares fit of its corners.
+		/** Each corner of the transformed model is paired with the closest target
+		 * corner. The rotation and translation that minimize the sum of squared
+		 * distances of the pairs are calculated in closed form (2d Procrustes
+		 * analysis). With icpIterations > 0, the corners are paired again under
+		 * the new transformation and the fit is repeated until the pairs do not
+		 * change anymore, but at most icpIterations times (ICP).
+		 * The refined transformation is only taken if its error, calculated like
+		 * the mapping error in mapPolygonShape(), is not bigger than the error of
+		 * the passed transformation. Returns that error.
+		 * The scaling is applied like in PolygonObject and is not refined. */
+		static float refineTransformation(
+			const PolygonShape &target,
+			const PolygonShape &model,
+			float scaling,
+			Transformation &t,
+			int icpIterations=2);
+
+		/// Refines the transformation of a mapping returned by one of the methods above.
+		/** The transformation and the error of the mapping are updated, see
+		 * refineTransformation(). Returns the new error. */
+		static float refineMapping(
+			const PolygonShape &target,
+			PolygonObject &mapping,
+			int icpIterations=2);
+
+		/// A mapping found by mapModel().
+		struct Mapping {
+			float rotation, tx, ty, scaling, error;
+			/// Mean distance the model corners move under the transformation.
+			float corner_movement;
+		};
+
+		/// Writes all mappings of the model onto the target with an error below the threshold to 'maps'.
+		/** This is the allocation-free kernel used by the methods above, it
+		 * finds at most MappingModel::MAX_CORNERS mappings and returns their number.
+		 * If maxRotation is not -1, mappings whose rotation normalized to [-pi, pi]
+		 * is bigger than maxRotation in magnitude are skipped before the model
+		 * corners are transformed. Both polygons must be supported by the
+		 * MappingModel. If icpIterations is not -1, the transformation of each
+		 * mapping is refined with refineTransformation() before the threshold
+		 * test, which allocates memory. */
+		static int mapModel(const MappingTarget &target, const MappingModel &model,
+			bool useScaling, float maxRotation, Mapping *maps, int icpIterations=-1);
 		  
 	private:
+		/// Appends all mappings of the model onto the target with an error below the threshold.
+		static void mapModel(const MappingTarget &target, const MappingModel &model,
+			bool useScaling, std::vector<PolygonObject> &maps, int icpIterations=-1);
+
+		/// Vector based implementation of mapPolygonShape() for polygons with any number of corners.
+		static void mapPolygonShapeGeneral(const PolygonShape &target, const PolygonShape &model,
+			float dynThresh, bool useScaling, std::vector<PolygonObject> &maps, int icpIterations=-1);
+
+		/// Implementation of refineTransformation() on the target and model corners.
+		static float refineCorners(const std::vector<icl::Point32f> &ct,
+			const std::vector<icl::Point32f> &cm, const icl::Point32f &center,
+			float scaling, Transformation &t, int icpIterations);
+
 	 	/** The index of the mapping which moves the corners under its transformation
 	   * the smallest distance is taken. Only mappings with rotation and translation
 	   * not bigger than maxRotation and maxTranslation are considered */
@@ -22,11 +22,11 @@
 class PolygonObject {
 	public:
 		/// Default constructor.
-		PolygonObject(): m_id(ID++), m_scaling(1), m_error(0),
+		PolygonObject(): m_id(nextId()), m_scaling(1), m_error(0),
 		 m_mass(1), m_last_active(0) { }
 		/// Constructor with transformation, mapping error and the source polygon as parameters.
 		PolygonObject(Transformation t, float scaling, const PolygonShape &shape, float error):
-			m_id(ID++), m_transform(t), m_scaling(scaling), m_shape(shape),
+			m_id(nextId()), m_transform(t), m_scaling(scaling), m_shape(shape),
 			m_error(error), m_mass(1), m_last_active(0)
 			{updateTransformedShape();}
 			
@@ -62,6 +62,7 @@ class PolygonObject {
 		/** Will be NULL, when not set before by setPredictedTransformation. */
 		const PolygonShape &getPredictedShape() const { return m_predicted_shape; }
 		float getError() const { return m_error; }		
+		float getScaling() const { return m_scaling; }
 		float getMass() const { return m_mass; }
 		/// Returns the last time, the object was set to active
 		int getActiveTime() const { return m_last_active; }
@@ -81,6 +82,8 @@ class PolygonObject {
 			void updatePredictedShape();
 		
 		private:
+			/// Returns a new id, the objects may be created in several threads.
+			static int nextId() { return __sync_fetch_and_add(&ID, 1); }
 			static int ID;
 			int m_id;
 			Transformation m_transform;
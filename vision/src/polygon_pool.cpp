@@ -0,0 +1,111 @@
+// Copyright 2009 Erik Weitnauer
+#include "polygon_pool.h"
+
+using namespace std;
+using namespace icl;
+
+PolygonPool::PolygonPool(float cell_size): m_cell_size(cell_size), m_index_dirty(true),
+	m_buckets(BUCKETS) {}
+
+int PolygonPool::find(int id) const {
+	map<int,int>::const_iterator it = m_index_of_id.find(id);
+	return it == m_index_of_id.end() ? -1 : it->second;
+}
+
+int PolygonPool::add(const PolygonObject &polygon) {
+	m_objects.push_back(polygon);
+	m_index_of_id[polygon.getId()] = m_objects.size()-1;
+	m_index_dirty = true;
+	return m_objects.size()-1;
+}
+
+void PolygonPool::remove(int index) {
+	m_index_of_id.erase(m_objects[index].getId());
+	if (index != (int)m_objects.size()-1) {
+		m_objects[index] = m_objects.back();
+		m_index_of_id[m_objects[index].getId()] = index;
+	}
+	m_objects.pop_back();
+	m_index_dirty = true;
+}
+
+void PolygonPool::clear() {
+	m_objects.clear();
+	m_index_of_id.clear();
+	m_index_dirty = true;
+}
+
+int PolygonPool::forget(int cur_time, int max_age) {
+	// move the objects that are kept to the front in a single pass
+	unsigned int n = 0;
+	for (unsigned int i=0; i<m_objects.size(); i++) {
+		if (cur_time - m_objects[i].getActiveTime() > max_age) {
+			m_index_of_id.erase(m_objects[i].getId());
+			continue;
+		}
+		if (n != i) {
+			m_objects[n] = m_objects[i];
+			m_index_of_id[m_objects[n].getId()] = n;
+		}
+		n++;
+	}
+	int removed = m_objects.size()-n;
+	if (removed > 0) {
+		m_objects.erase(m_objects.begin()+n, m_objects.end());
+		m_index_dirty = true;
+	}
+	return removed;
+}
+
+vector<PolygonObject> PolygonPool::getActive(int cur_time) const {
+	vector<PolygonObject> actives;
+	for (unsigned int i=0; i<m_objects.size(); i++) {
+		if (m_objects[i].isActive(cur_time)) actives.push_back(m_objects[i]);
+	}
+	return actives;
+}
+
+void PolygonPool::setCellSize(float cell_size) {
+	if (cell_size <= 0 || cell_size == m_cell_size) return;
+	m_cell_size = cell_size;
+	m_index_dirty = true;
+}
+
+void PolygonPool::updateIndex() {
+	for (int b=0; b<BUCKETS; b++) m_buckets[b].clear();
+	for (unsigned int i=0; i<m_objects.size(); i++) {
+		const Point32f &c = m_objects[i].getTransformedShape().getCenter();
+		Entry e;
+		e.cx = getCell(c.x);
+		e.cy = getCell(c.y);
+		e.index = i;
+		m_buckets[getBucket(e.cx, e.cy)].push_back(e);
+	}
+	m_index_dirty = false;
+}
+
+void PolygonPool::getNeighbours(const Point32f &p, float radius, vector<int> &indices) {
+	indices.clear();
+	// a linear search is faster if the radius covers many cells
+	float cells = 2*radius/m_cell_size+2;
+	if (radius < 0 || cells*cells > m_objects.size()) {
+		for (unsigned int i=0; i<m_objects.size(); i++) {
+			if (radius < 0 || LinAlg::distance2(p, m_objects[i].getTransformedShape().getCenter()) < radius*radius)
+				indices.push_back(i);
+		}
+		return;
+	}
+	if (m_index_dirty) updateIndex();
+	int x0 = getCell(p.x-radius), x1 = getCell(p.x+radius);
+	int y0 = getCell(p.y-radius), y1 = getCell(p.y+radius);
+	for (int cy=y0; cy<=y1; cy++) for (int cx=x0; cx<=x1; cx++) {
+		const vector<Entry> &bucket = m_buckets[getBucket(cx, cy)];
+		for (unsigned int k=0; k<bucket.size(); k++) {
+			const Entry &e = bucket[k];
+			// other cells can share the bucket
+			if (e.cx != cx || e.cy != cy) continue;
+			if (LinAlg::distance2(p, m_objects[e.index].getTransformedShape().getCenter()) < radius*radius)
+				indices.push_back(e.index);
+		}
+	}
+}
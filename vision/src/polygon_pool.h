@@ -0,0 +1,78 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __POLYGON_POOL_EWEITNAU_H__
+#define __POLYGON_POOL_EWEITNAU_H__
+
+#include <map>
+#include <vector>
+#include "polygon_object.h"
+
+/// Container for the tracked polygon objects with a spatial index on their centers.
+/**
+ The objects are stored contiguously and accessed by index. Indices change when
+ objects are removed, the ids of the objects (PolygonObject::getId()) are stable
+ and can be used to find an object again with find().
+
+ The centers of the transformed shapes are hashed into a uniform grid, so
+ getNeighbours() only looks at the objects in the grid cells around the
+ query point. As the objects might be moved through the non-const operator[],
+ calling it marks the grid as outdated, just like adding and removing objects.
+ An outdated grid is rebuilt on the next query. Use getObjects() for read
+ access between queries.
+*/
+class PolygonPool {
+	public:
+		/// The grid cells have a size of cell_size x cell_size.
+		PolygonPool(float cell_size=100);
+
+		int size() const { return m_objects.size(); }
+		bool empty() const { return m_objects.empty(); }
+		PolygonObject &operator[](int i) { m_index_dirty = true; return m_objects[i]; }
+		const PolygonObject &operator[](int i) const { return m_objects[i]; }
+		const std::vector<PolygonObject> &getObjects() const { return m_objects; }
+
+		/// Returns the index of the object with the passed id or -1.
+		int find(int id) const;
+
+		/// Appends a copy of the object and returns its index.
+		int add(const PolygonObject &polygon);
+		/// Removes the object by moving the last object to its index.
+		void remove(int index);
+		void clear();
+
+		/// Removes all objects that were not active during the last max_age timesteps.
+		/** The order of the remaining objects is kept. Returns the number of
+		 * removed objects. */
+		int forget(int cur_time, int max_age);
+
+		/// Returns copies of all objects that are active at cur_time.
+		std::vector<PolygonObject> getActive(int cur_time) const;
+
+		/// Sets the size of the grid cells, should be about the query radius.
+		void setCellSize(float cell_size);
+		float getCellSize() const { return m_cell_size; }
+
+		/// Writes the indices of all objects whose center is closer than radius to p to 'indices'.
+		/** If radius is negative, all indices are returned. */
+		void getNeighbours(const icl::Point32f &p, float radius, std::vector<int> &indices);
+
+	private:
+		enum { BUCKETS = 256 }; ///< must be a power of 2
+
+		struct Entry {
+			int cx, cy; ///< grid cell
+			int index;
+		};
+
+		/// Recalculates the grid cells of all objects.
+		void updateIndex();
+		int getCell(float x) const { return (int)floor(x/m_cell_size); }
+		static int getBucket(int cx, int cy) { return ((unsigned)cx*73856093u ^ (unsigned)cy*19349663u) & (BUCKETS-1); }
+
+		std::vector<PolygonObject> m_objects;
+		std::map<int,int> m_index_of_id;
+		float m_cell_size;
+		bool m_index_dirty;
+		std::vector< std::vector<Entry> > m_buckets;
+};
+
+#endif /* __POLYGON_POOL_EWEITNAU_H__ */
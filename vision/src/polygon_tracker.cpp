@@ -0,0 +1,176 @@
+// Copyright 2009 Erik Weitnauer
+#include "polygon_tracker.h"
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+using namespace std;
+using namespace icl;
+
+string PolygonTracker::Statistics::toString() const {
+	stringstream s;
+	s.precision(3);
+	s << "shapes=" << shapes << " polygons=" << polygons << " candidates=" << candidate_pairs
+		<< " mapped=" << mapped_pairs << " assigned=" << assigned << " cost=" << cost
+		<< " time=" << time_ms << " ms";
+	return s.str();
+}
+
+PolygonTracker::PolygonTracker(float dynThresh, float maxRotation, float maxTranslation):
+	m_dyn_thresh(dynThresh), m_max_rotation(maxRotation), m_max_translation(maxTranslation),
+	m_refine_iterations(-1) {}
+
+int PolygonTracker::track(const vector<PolygonShape> &shapes, vector<PolygonObject> &polygons,
+		int cur_time, vector<int> &assignment) {
+	Time start = Time::now();
+	m_columns.clear();
+	m_column_objects.clear();
+	for (unsigned int k=0; k<polygons.size(); k++) {
+		if (polygons[k].isActive(cur_time)) continue;
+		m_columns.push_back(k);
+		m_column_objects.push_back(&polygons[k]);
+	}
+	return assign(shapes, cur_time, assignment, start);
+}
+
+int PolygonTracker::track(const vector<PolygonShape> &shapes, PolygonPool &pool,
+		int cur_time, vector<int> &assignment) {
+	Time start = Time::now();
+	m_columns.clear();
+	m_is_column.assign(pool.size(), false);
+	for (unsigned int i=0; i<shapes.size(); i++) {
+		if (!MappingModel::isSupported(shapes[i])) continue;
+		pool.getNeighbours(shapes[i].getCenter(), m_max_translation, m_neighbours);
+		for (unsigned int k=0; k<m_neighbours.size(); k++) {
+			int index = m_neighbours[k];
+			if (m_is_column[index] || pool.getObjects()[index].isActive(cur_time)) continue;
+			m_is_column[index] = true;
+			m_columns.push_back(index);
+		}
+	}
+	// same column order as in the vector version
+	sort(m_columns.begin(), m_columns.end());
+	m_column_objects.clear();
+	// the assigned objects will be moved, this marks the spatial index as outdated
+	for (unsigned int j=0; j<m_columns.size(); j++) m_column_objects.push_back(&pool[m_columns[j]]);
+	return assign(shapes, cur_time, assignment, start);
+}
+
+int PolygonTracker::assign(const vector<PolygonShape> &shapes, int cur_time,
+		vector<int> &assignment, const Time &start) {
+	m_statistics = Statistics();
+	int rows = shapes.size(), cols = m_columns.size();
+	m_statistics.shapes = rows;
+	m_statistics.polygons = cols;
+
+	buildCostMatrix(shapes);
+	solveAssignment(rows, cols);
+
+	assignment.assign(rows, -1);
+	for (int i=0; i<rows; i++) {
+		int j = m_row_to_col[i];
+		if (j == -1) continue;
+		const PolygonMapper::Mapping &mapping = m_mappings[i*cols+j];
+		m_column_objects[j]->addTransformation(Transformation(mapping.rotation, mapping.tx, mapping.ty));
+		if (m_refine_iterations >= 0) m_column_objects[j]->setError(mapping.error);
+		m_column_objects[j]->setActive(cur_time);
+		assignment[i] = m_columns[j];
+		m_statistics.assigned++;
+		m_statistics.cost += mapping.corner_movement;
+	}
+	m_statistics.time_ms = (Time::now()-start).toMicroSecondsDouble()/1000;
+	return m_statistics.assigned;
+}
+
+void PolygonTracker::buildCostMatrix(const vector<PolygonShape> &shapes) {
+	int rows = shapes.size(), cols = m_columns.size();
+	m_targets.clear();
+	for (int i=0; i<rows; i++) m_targets.push_back(MappingTarget(shapes[i]));
+	m_models.clear();
+	for (int j=0; j<cols; j++)
+		m_models.push_back(MappingModel(m_column_objects[j]->getTransformedShape(), m_dyn_thresh));
+	m_cost.assign(rows*cols, -1);
+	m_mappings.resize(rows*cols);
+
+	float max_translation2 = m_max_translation*m_max_translation;
+	PolygonMapper::Mapping found[MappingModel::MAX_CORNERS];
+	for (int i=0; i<rows; i++) {
+		if (!MappingModel::isSupported(shapes[i])) continue;
+		for (int j=0; j<cols; j++) {
+			const MappingModel &model = m_models[j];
+			if (!MappingModel::isSupported(model.getShape())) continue;
+			// the translation of all mappings is the distance of the centers
+			if (m_max_translation >= 0 &&
+			    LinAlg::distance2(m_targets[i].center, model.getShape().getCenter()) >= max_translation2)
+				continue;
+			m_statistics.candidate_pairs++;
+			int n = PolygonMapper::mapModel(m_targets[i], model, false, m_max_rotation, found, m_refine_iterations);
+			if (n == 0) continue;
+			m_statistics.mapped_pairs++;
+			// take the mapping in which the corners travel the smallest distance
+			int best = 0;
+			for (int k=1; k<n; k++) {
+				if (found[k].corner_movement < found[best].corner_movement) best = k;
+			}
+			m_cost[i*cols+j] = found[best].corner_movement;
+			m_mappings[i*cols+j] = found[best];
+		}
+	}
+}
+
+// Hungarian method with potentials on a square matrix, O(n^3). The cost of a
+// pair with a mapping is its corner movement minus a bonus that is bigger than
+// the sum of all corner movements of any assignment, all other pairs cost 0.
+// So the solution has the maximal number of mapped pairs and among those the
+// smallest total corner movement.
+void PolygonTracker::solveAssignment(int rows, int cols) {
+	m_row_to_col.assign(rows, -1);
+	if (rows == 0 || cols == 0) return;
+	int n = max(rows, cols);
+	double max_cost = 0;
+	for (int i=0; i<rows*cols; i++) {
+		if (m_cost[i] > max_cost) max_cost = m_cost[i];
+	}
+	double bonus = max_cost*n + 1;
+	const double INF = numeric_limits<double>::max();
+	m_u.assign(n+1, 0);
+	m_v.assign(n+1, 0);
+	m_p.assign(n+1, 0);
+	m_way.assign(n+1, 0);
+	// rows and columns are 1-based here, column 0 is a virtual start column
+	for (int i=1; i<=n; i++) {
+		m_p[0] = i;
+		int j0 = 0;
+		m_minv.assign(n+1, INF);
+		m_used.assign(n+1, false);
+		do {
+			m_used[j0] = true;
+			int i0 = m_p[j0], j1 = 0;
+			double delta = INF;
+			for (int j=1; j<=n; j++) {
+				if (m_used[j]) continue;
+				double cost = 0;
+				if (i0 <= rows && j <= cols && m_cost[(i0-1)*cols+j-1] >= 0)
+					cost = m_cost[(i0-1)*cols+j-1] - bonus;
+				double cur = cost - m_u[i0] - m_v[j];
+				if (cur < m_minv[j]) { m_minv[j] = cur; m_way[j] = j0; }
+				if (m_minv[j] < delta) { delta = m_minv[j]; j1 = j; }
+			}
+			for (int j=0; j<=n; j++) {
+				if (m_used[j]) { m_u[m_p[j]] += delta; m_v[j] -= delta; }
+				else m_minv[j] -= delta;
+			}
+			j0 = j1;
+		} while (m_p[j0] != 0);
+		// augment along the alternating path
+		do {
+			int j1 = m_way[j0];
+			m_p[j0] = m_p[j1];
+			j0 = j1;
+		} while (j0 != 0);
+	}
+	for (int j=1; j<=cols; j++) {
+		int i = m_p[j]-1;
+		if (i < rows && m_cost[i*cols+j-1] >= 0) m_row_to_col[i] = j-1;
+	}
+}
@@ -0,0 +1,126 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __POLYGON_TRACKER_EWEITNAU_H__
+#define __POLYGON_TRACKER_EWEITNAU_H__
+
+#include <string>
+#include <vector>
+#include <ICLUtils/Time.h>
+#include "polygon_shape.h"
+#include "polygon_object.h"
+#include "polygon_mapper.h"
+#include "polygon_pool.h"
+
+/// Assigns the shapes observed in a frame to the tracked polygon objects.
+/**
+ Mapping one observed shape after the other onto the best of the polygon objects,
+ as PolygonMapper::mapPolygonObjects() does, gives results that depend on the
+ order of the shapes and needs a mapping for each pair of shape and object.
+
+ The tracker instead builds a cost matrix between all observed shapes and all
+ polygon objects that are not active yet. Pairs whose centers are further apart
+ than maxTranslation are pruned before any corners are mapped, as the
+ translation of a mapping is the distance of the centers. For the other pairs,
+ only mappings with a rotation below maxRotation are evaluated. The cost of a
+ pair is the corner movement of its best mapping, like in
+ PolygonMapper::getBestMapping().
+
+ The assignment is solved once per frame with the Hungarian method. Among all
+ assignments with the maximal number of mapped pairs, the one with the smallest
+ total corner movement is chosen.
+
+ Usage example:
+ \code
+ PolygonTracker tracker(0.1, M_PI/4, 50);
+ vector<int> assignment;
+ tracker.track(shapes, polygons, timestep, assignment);
+ for (unsigned int i=0; i<shapes.size(); i++)
+   if (assignment[i] == -1) // shape i is a new object
+ cout << tracker.getStatistics().toString() << endl;
+ \endcode
+*/
+class PolygonTracker {
+	public:
+		/// Numbers about the last track() call.
+		struct Statistics {
+			Statistics(): shapes(0), polygons(0), candidate_pairs(0), mapped_pairs(0),
+				assigned(0), cost(0), time_ms(0) {}
+			int shapes;
+			/// Number of inactive polygon objects considered for the assignment.
+			int polygons;
+			/// Pairs which were not pruned by their translation.
+			int candidate_pairs;
+			/// Pairs with at least one valid mapping.
+			int mapped_pairs;
+			/// Number of shapes which were assigned to a polygon object.
+			int assigned;
+			/// Sum of the corner movements of the assigned pairs.
+			float cost;
+			float time_ms;
+			std::string toString() const;
+		};
+
+		/// See the setter methods for the parameters.
+		PolygonTracker(float dynThresh=0.1, float maxRotation=-1, float maxTranslation=-1);
+
+		/// Mapping error threshold, see PolygonMapper::mapPolygonShape().
+		void setDynThresh(float value) { m_dyn_thresh = value; }
+		/// Maximal rotation in rad between two frames, -1 for no limit.
+		void setMaxRotation(float value) { m_max_rotation = value; }
+		/// Maximal translation between two frames, -1 for no limit.
+		void setMaxTranslation(float value) { m_max_translation = value; }
+		/// ICP iterations for refining the mappings, -1 for no refinement.
+		/** The mappings are refined before they are compared to the error
+		 * threshold, see PolygonMapper::mapModel(). */
+		void setRefineIterations(int value) { m_refine_iterations = value; }
+		float getDynThresh() const { return m_dyn_thresh; }
+		float getMaxRotation() const { return m_max_rotation; }
+		float getMaxTranslation() const { return m_max_translation; }
+		int getRefineIterations() const { return m_refine_iterations; }
+
+		/// Maps the shapes onto the polygon objects that are not active at cur_time.
+		/** The assigned polygon objects get the transformation of the mapping
+		 * added and are set active at cur_time. For each shape, 'assignment'
+		 * holds the index of its polygon object or -1. Shapes or polygons with
+		 * more than MappingModel::MAX_CORNERS corners are never assigned.
+		 * Returns the number of assigned shapes. */
+		int track(const std::vector<PolygonShape> &shapes, std::vector<PolygonObject> &polygons,
+			int cur_time, std::vector<int> &assignment);
+
+		/// Same as above, but only polygon objects near the shapes are considered.
+		/** The spatial index of the pool is used to find the objects within
+		 * maxTranslation of each shape, so the size of the cost matrix does not
+		 * grow with the number of inactive objects far away. The indices in
+		 * 'assignment' are indices into the pool. */
+		int track(const std::vector<PolygonShape> &shapes, PolygonPool &pool,
+			int cur_time, std::vector<int> &assignment);
+
+		const Statistics &getStatistics() const { return m_statistics; }
+
+	private:
+		/// Assigns the shapes to the polygons in m_columns and m_column_objects.
+		int assign(const std::vector<PolygonShape> &shapes, int cur_time,
+			std::vector<int> &assignment, const icl::Time &start);
+		/// Builds m_cost and m_mappings for the shapes and the polygons in m_column_objects.
+		void buildCostMatrix(const std::vector<PolygonShape> &shapes);
+		/// Hungarian method on the rows x cols matrix m_cost, fills m_row_to_col.
+		void solveAssignment(int rows, int cols);
+
+		float m_dyn_thresh, m_max_rotation, m_max_translation;
+		int m_refine_iterations;
+		Statistics m_statistics;
+		// the vectors are reused from frame to frame
+		std::vector<int> m_columns; ///< indices of the polygons that are not active
+		std::vector<PolygonObject*> m_column_objects;
+		std::vector<int> m_neighbours;
+		std::vector<char> m_is_column;
+		std::vector<MappingTarget> m_targets;
+		std::vector<MappingModel> m_models;
+		std::vector<double> m_cost; ///< row major, -1 for pairs without mapping
+		std::vector<PolygonMapper::Mapping> m_mappings; ///< best mapping of each pair
+		std::vector<int> m_row_to_col;
+		std::vector<double> m_u, m_v, m_minv;
+		std::vector<int> m_p, m_way;
+		std::vector<char> m_used;
+};
+
+#endif /* __POLYGON_TRACKER_EWEITNAU_H__ */
@@ -2,10 +2,27 @@
 #include "tangram_classifier.h"
 #include "polygon_shape.h"
 #include <xml_reader.h>
+#include <algorithm>
 
 using namespace std;
 using namespace icl;
 
+TangramClassifier::ShapeDescriptor::ShapeDescriptor(const PolygonShape &shape):
+		corners(shape.getCorners().size()), area(shape.getArea()) {
+	if (corners > MAX_CORNERS) return;
+	const vector<Point32f> &c = shape.getCorners();
+	for (int i=0; i<corners; i++) {
+		const Point32f &prev = c[(i+corners-1) % corners];
+		const Point32f &next = c[(i+1) % corners];
+		float ux = prev.x-c[i].x, uy = prev.y-c[i].y;
+		float vx = next.x-c[i].x, vy = next.y-c[i].y;
+		edges[i] = sqrt(vx*vx + vy*vy);
+		angles[i] = fabs(atan2(ux*vy - uy*vx, ux*vx + uy*vy));
+	}
+	sort(edges, edges+corners);
+	sort(angles, angles+corners);
+}
+
 
 void TangramClassifier::setSize(float base_length, float height) {
 	// do we need to scale the shapes?
@@ -21,6 +38,7 @@ void TangramClassifier::setSize(float base_length, float height) {
 			m_shapes[i].setHeight(height);
 		m_height = height;		
 	}
+	updateIndex();
 }
 
 void TangramClassifier::loadStandardTangramShapes(float base_length, float height) {
@@ -72,26 +90,58 @@ void TangramClassifier::loadStandardTangramShapes(float base_length, float heigh
 	m_shapes.push_back(tl_shape);
 	m_shapes.push_back(pa_shape);
 	m_shapes.push_back(sq_shape);
+	updateIndex();
 }
 
 void TangramClassifier::loadShapesFromXML(const string &filename) {
 	XMLReader::readShapes(filename, m_shapes, m_base_length, m_height);
+	updateIndex();
 }
 
-/// For now, just return all models if corner number in {3..5}.
-const vector<PolygonShape> &TangramClassifier::classify(PolygonShape &data, float tolerance, bool size_matters) {
-	int data_corners = data.getCorners().size(); 
-	m_candidate_shapes.clear();
+void TangramClassifier::updateIndex() {
+	m_descriptors.clear();
+	m_shapes_by_corners.clear();
 	for (unsigned int i=0; i<m_shapes.size(); ++i) {
-		int model_corners = m_shapes[i].getCorners().size();
-		if (model_corners > data_corners || model_corners < data_corners-2) continue;
-		if (!size_matters) m_candidate_shapes.push_back(m_shapes[i]);
-		else { // size matters
-			if (fabs(m_shapes[i].getArea() - data.getArea()) < m_shapes[i].getArea()*tolerance)
-				m_candidate_shapes.push_back(m_shapes[i]);
+		m_descriptors.push_back(ShapeDescriptor(m_shapes[i]));
+		unsigned int corners = m_descriptors.back().corners;
+		if (m_shapes_by_corners.size() <= corners) m_shapes_by_corners.resize(corners+1);
+		m_shapes_by_corners[corners].push_back(i);
+	}
+}
+
+bool TangramClassifier::matches(const ShapeDescriptor &data, const ShapeDescriptor &model,
+		float tolerance, bool size_matters) const {
+	if (size_matters && !(fabs(model.area - data.area) < model.area*tolerance)) return false;
+	// compare the signatures only if the corners correspond to each other
+	if (model.corners != data.corners || data.corners > ShapeDescriptor::MAX_CORNERS) return true;
+	float scale = (size_matters || model.area <= 0) ? 1 : sqrt(data.area / model.area);
+	for (int i=0; i<data.corners; ++i) {
+		if (fabs(data.edges[i] - scale*model.edges[i]) > tolerance*scale*model.edges[i]) return false;
+		if (fabs(data.angles[i] - model.angles[i]) > tolerance*M_PI/2) return false;
+	}
+	return true;
+}
+
+/// Models with the same corner count or up to two corners less than the data are considered.
+void TangramClassifier::classify(const PolygonShape &data, vector<int> &candidates,
+		float tolerance, bool size_matters) const {
+	candidates.clear();
+	ShapeDescriptor d(data);
+	for (int corners=max(0, d.corners-2); corners<=d.corners && corners<(int)m_shapes_by_corners.size(); ++corners) {
+		const vector<int> &ids = m_shapes_by_corners[corners];
+		for (unsigned int i=0; i<ids.size(); ++i) {
+			if (matches(d, m_descriptors[ids[i]], tolerance, size_matters)) candidates.push_back(ids[i]);
 		}
 	}
-	return m_candidate_shapes;
+	sort(candidates.begin(), candidates.end());
+}
+
+vector<PolygonShape> TangramClassifier::classify(const PolygonShape &data, float tolerance, bool size_matters) const {
+	vector<int> ids;
+	classify(data, ids, tolerance, size_matters);
+	vector<PolygonShape> candidates;
+	for (unsigned int i=0; i<ids.size(); ++i) candidates.push_back(m_shapes[ids[i]]);
+	return candidates;
 }
 
 std::ostream& operator<<(std::ostream &out, const TangramClassifier &tc) {
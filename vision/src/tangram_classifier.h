@@ -28,13 +28,28 @@ of the tiles (same as the side length of the square).
 ==================
 </pre>
 
-By now, the class selects the candidate tangram shapes only by counting the
-corners and -- in case the mode without scaling is used -- by comparing the
-area of the observed and model shapes.
+The candidates are selected by their corner count and -- in case the mode
+without scaling is used -- by their area. If the observed shape has as many
+corners as a model, also the sorted lists of their edge lengths and inner
+angles have to match.
+
+For each model shape, these values are stored in a ShapeDescriptor, which is
+computed when the shapes are loaded or resized. The shapes and descriptors
+are not changed by classify(), so it can be called from several threads.
 */
 
 class TangramClassifier {
 	public:
+		/// Values for comparing an observed shape with a model shape.
+		struct ShapeDescriptor {
+			enum { MAX_CORNERS = 8 };
+			ShapeDescriptor(const PolygonShape &shape);
+			int corners;
+			float area;
+			/// Only set for shapes with at most MAX_CORNERS corners, sorted in ascending order.
+			float edges[MAX_CORNERS], angles[MAX_CORNERS];
+		};
+
 		/// Standard Constructor that creates a TangramClassifier with an empty list of classification model shapes.
 		TangramClassifier(): m_base_length(0), m_height(0) {}
 	  
@@ -48,7 +63,7 @@ class TangramClassifier {
 		void loadShapesFromXML(const std::string &filename);
 		
 		/// Clears all shapes.
-		void clearShapes() { m_shapes.clear(); }
+		void clearShapes() { m_shapes.clear(); updateIndex(); }
 		
 	  /// Returns a vector of tangram tiles (PolygonShapes), which are similar to the observed object.
 	  /** At the moment, all the tangram tiles are returned whose corner count is
@@ -59,11 +74,19 @@ class TangramClassifier {
 		 0.2 means that the area of the model polygon can differ up to 20% from
 		 the area of the observed polygon in order to be taken as a candidate match.
 		 If no matching candidate tangram tile is found, an empty vector is returned.
-		 WARNING: The returned vector is only valid until the next call of the function!*/
-		const std::vector<PolygonShape> &classify(PolygonShape &data, float tolerance=0.2, bool size_matters=false);
+		 If the corner counts are equal, each edge length may differ up to 'tolerance'
+		 relatively and each angle up to 'tolerance' times 90 deg. Without size_matters,
+		 the edge lengths are compared after scaling the model to the area of the data. */
+		std::vector<PolygonShape> classify(const PolygonShape &data, float tolerance=0.2, bool size_matters=false) const;
+
+		/// Same as above, but writes the indices of the candidate shapes to 'candidates'.
+		/** The shapes can be accessed with getShape(), nothing is copied. */
+		void classify(const PolygonShape &data, std::vector<int> &candidates,
+			float tolerance=0.2, bool size_matters=false) const;
 		
 		/// Returns a vector with Triangle, Square and Parallelogram shape in it.
-		const std::vector<PolygonShape> &getAllShapes() {return m_shapes;}
+		const std::vector<PolygonShape> &getAllShapes() const {return m_shapes;}
+		const PolygonShape &getShape(int i) const { return m_shapes[i]; }
 		
 		inline float getBaseLength() const { return m_base_length; }
 		inline float getHeight() const { return m_height; }
@@ -75,8 +98,15 @@ class TangramClassifier {
 	friend std::ostream& operator<<(std::ostream &out, const TangramClassifier &tc);
 	
 	private:
+		/// Computes the descriptors and sorts the shapes by corner count.
+		void updateIndex();
+		bool matches(const ShapeDescriptor &data, const ShapeDescriptor &model,
+			float tolerance, bool size_matters) const;
+
 		std::vector< PolygonShape > m_shapes;
-		std::vector< PolygonShape > m_candidate_shapes;
+		std::vector< ShapeDescriptor > m_descriptors;
+		/// Indices of the shapes for each corner count.
+		std::vector< std::vector<int> > m_shapes_by_corners;
 		
 		float m_base_length;
 		float m_height;
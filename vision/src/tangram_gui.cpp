@@ -1,45 +1,17 @@
 #include "tangram_gui.h"
-#include "tangram_classifier.h"
-#include "polygon_mapper.h"
 #include "lin_alg.h"
 
 using namespace std;
 
-vector<PolygonObject*> TangramGui::getActivePolygons() {
-	icl::Mutex::Locker l(m_polygon_mutex);
-	vector<PolygonObject*> actives;
-	for (unsigned int i=0; i<m_polygon_pool.size(); i++) {
-		if (m_polygon_pool[i].isActive(m_timestep)) actives.push_back(&(m_polygon_pool[i]));
-	}
-	return actives;
-}
-
 // Check the area of the smallest and the biggest polygon shape on the screen
-// and adjust the max and min blob size of the RegionDetector.
+// and adjust the max and min blob size of the BlobDetector.
 void TangramGui::adjustRegionDetectorParams() {
-	static bool &enabled = m_gui.getValue<bool>("blob-auto-adjust");
+	bool enabled = m_gui.getValue<bool>("blob-auto-adjust");
 	if (!enabled) return;
-	const std::vector<PolygonShape> &shapes = m_tangram_classifier.getAllShapes();
-	if (shapes.empty()) return;
-	int biggest_idx=0, smallest_idx=0;
-	for (unsigned int i=1; i<shapes.size(); ++i) {
-		if (shapes[i].getArea() > shapes[biggest_idx].getArea()) biggest_idx = i;
-		else if (shapes[i].getArea() < shapes[smallest_idx].getArea()) smallest_idx = i;
-	}
-	float biggest_area, smallest_area;
-	if (do_world_transformation) {
-		PolygonShape bigshape = shapes[biggest_idx];
-		PolygonShape smallshape = shapes[smallest_idx];
-		m_cam_transformer.transformWorldToScreen2D(bigshape, bigshape.getHeight());
-		m_cam_transformer.transformWorldToScreen2D(smallshape, smallshape.getHeight());
-		biggest_area=bigshape.getArea();
-		smallest_area=smallshape.getArea();
-	} else {
-		biggest_area=shapes[biggest_idx].getArea();
-		smallest_area=shapes[smallest_idx].getArea();
-	}
-	m_gui.getValue<SliderHandle>("max-blob-size-handle") = biggest_area*1.2;
-	m_gui.getValue<SliderHandle>("min-blob-size-handle") = smallest_area*0.8;
+	float min_size, max_size;
+	if (!m_vision.getBlobSizeLimits(min_size, max_size)) return;
+	m_gui.getValue<SliderHandle>("max-blob-size-handle") = max_size;
+	m_gui.getValue<SliderHandle>("min-blob-size-handle") = min_size;
 }
 
 void TangramGui::init() {
@@ -55,6 +27,18 @@ GUI &TangramGui::addControls(GUI &gui) {
 			<< "fslider(0,1,0.2)[@out=size-tolerance@label=classification shape tolerance]"
 			<< "fslider(0,1,0.1)[@out=corner-tolerance@label=mapping corner distance tolerance]";
 	tab << vbox;
+	GUI tracking_controls("vbox[@label=tracking]");
+	tracking_controls << "fslider(0.1,5,1)[@out=max-movement@label=max. movement per frame [tile sizes]]"
+			<< "fslider(0,180,180)[@out=max-rotation@label=max. rotation per frame [deg]]"
+			<< "togglebutton(off,on)[@out=refine-pose@label=least squares pose refinement]"
+			<< "slider(0,10,2)[@out=icp-iterations@label=ICP iterations]"
+			<< "label(-)[@label=tracking cost@handle=tracking-label]";
+	tab << tracking_controls;
+	GUI roi_controls("vbox[@label=segmentation around tracked tangrams]");
+	roi_controls << "togglebutton(full image,tracking ROIs)[@out=use-rois@label=segmented area]"
+			<< "fslider(0,200,30)[@out=roi-margin@label=ROI margin [px]]"
+			<< "slider(1,100,10)[@out=full-scan-interval@label=full scan every n frames]";
+	tab << roi_controls;
 	
 	return tab;
 }
@@ -64,46 +48,48 @@ string str_rounded(const Point32f p) {
 }
 
 void TangramGui::loadShapesFromXMLFile(const std::string &file) {
-	m_tangram_classifier.clearShapes();
-	m_tangram_classifier.loadShapesFromXML(file);
-	cout << "Loaded these polygon models:" << endl << m_tangram_classifier << endl;
+	m_vision.loadShapesFromXMLFile(file);
+	cout << "Loaded these polygon models:" << endl << m_vision.getTangramClassifier() << endl;
 	adjustRegionDetectorParams();
 }
 
 void TangramGui::loadStandardTangramShapes() {
-	m_tangram_classifier.clearShapes();
-	m_tangram_classifier.loadStandardTangramShapes(m_gui.getValue<float>("tile-size"),18);
+	m_vision.setConfig(getConfig());
+	m_vision.loadStandardTangramShapes();
 	adjustRegionDetectorParams();
 }
 
-void TangramGui::drawPredictedShapes(ICLDrawWidget *w, const Color4D &color) {
+void TangramGui::drawPredictedShapes(ICLDrawWidget *w, const vector<PolygonObject> &polygons,
+		const Color4D &color) {
 	w->color(color[0],color[1],color[2],color[3]);
-	for (unsigned int i=0; i<m_polygon_pool.size(); i++) {
-		const PolygonShape &pshape = m_polygon_pool[i].getPredictedShape();
+	for (unsigned int i=0; i<polygons.size(); i++) {
+		const PolygonShape &pshape = polygons[i].getPredictedShape();
 		if (!pshape.hasCorners()) continue;
 		PolygonShape shape = pshape;
-		if (do_world_transformation) 
-			m_cam_transformer.transformWorldToScreen2D(shape, shape.getHeight());
+		if (getDoWorldTransformation())
+			getCameraTransformer().transformWorldToScreen2D(shape, shape.getHeight());
 		w->linestrip(shape.getCorners());
 	}
 }
 
 void TangramGui::drawPolygons(ICLDrawWidget *w, const vector<PolygonObject> &polygons,
-		const Color4D &color,	const Color4D &fill) {
+		int timestep, const Color4D &color,	const Color4D &fill) {
+	const CameraTransformer &cam_transformer = getCameraTransformer();
+	bool do_world_transformation = getDoWorldTransformation();
 	enum {INACTIVE, ACTIVE};
 	for (int state=INACTIVE; state<=ACTIVE; ++state) {
 	  for (unsigned int k=0; k<polygons.size(); k++) {
-	   	if (!polygons[k].isActive(m_timestep) && state==INACTIVE) {
+	   	if (!polygons[k].isActive(timestep) && state==INACTIVE) {
 				w->color(100,100,100);
 				w->fill(100,100,100);
-			} else if (polygons[k].isActive(m_timestep) && state==ACTIVE) {
+			} else if (polygons[k].isActive(timestep) && state==ACTIVE) {
 				w->color(color[0],color[1],color[2],color[3]);
 				w->fill(fill[0],fill[1],fill[2],fill[3]);
 			} else continue;
 	  	PolygonShape shape = polygons[k].getTransformedShape();
 	  	Point32f center = shape.getCenter();
 	  	float rotation = polygons[k].getTransformation().getRotation()*180/M_PI;
-			if (do_world_transformation) m_cam_transformer.transformWorldToScreen2D(shape, shape.getHeight());
+			if (do_world_transformation) cam_transformer.transformWorldToScreen2D(shape, shape.getHeight());
 	 		w->ellipse(shape.getCenter().x-1,shape.getCenter().y-1,2,2);
   		w->text("#" + str(polygons[k].getId()) + " " + shape.getName(), shape.getCenter().x, shape.getCenter().y,-1,-1,10);
   		if (do_world_transformation)
@@ -118,90 +104,81 @@ void TangramGui::drawPolygons(ICLDrawWidget *w, const vector<PolygonObject> &pol
 	}
 }
 
-void TangramGui::forgetOldPolygons(int max_age) {
-	for (int i=m_polygon_pool.size()-1; i>=0; --i) {
-		if (m_timestep - m_polygon_pool[i].getActiveTime() > max_age)
-			m_polygon_pool.erase(m_polygon_pool.begin()+i);
-	}
-}
-
 void TangramGui::drawGrid(ICLDrawWidget *w, float size_mm, const Color4D &color,
 		float offset_x_mm, float offset_y_mm) {
 	w->color(color[0],color[1],color[2],color[3]);
 	if (size_mm < 40) size_mm = 40;
+	vector<Point32f> points;
 	for (float y=offset_y_mm; y<1000+offset_y_mm; y+= size_mm) {
+		// transform the points of a whole row at once
+		points.clear();
 		for (float x=-1000+offset_x_mm; x<1000+offset_x_mm; x+= size_mm) {
 			// A -- B
 			// |
 			// C
-			Point32f A = m_cam_transformer.transformedWorldToScreen(Vec(x,y,0,1));
-			Point32f B = m_cam_transformer.transformedWorldToScreen(Vec(x+size_mm,y,0,1));
-			Point32f C = m_cam_transformer.transformedWorldToScreen(Vec(x,y+size_mm,0,1));
+			points.push_back(Point32f(x,y));
+			points.push_back(Point32f(x+size_mm,y));
+			points.push_back(Point32f(x,y+size_mm));
+		}
+		if (points.empty()) continue;
+		getCameraTransformer().transformWorldToScreen(&points[0], &points[0], points.size(), 0);
+		for (unsigned int i=0; i+2<points.size(); i+=3) {
+			const Point32f &A = points[i], &B = points[i+1], &C = points[i+2];
 			w->line(A.x,A.y,B.x,B.y);
 			w->line(A.x,A.y,C.x,C.y);
 		}
 	}
 }
 		
-void TangramGui::draw(ICLDrawWidget *w, const std::vector<icl::Region> &rs) {
+VisionConfig TangramGui::getConfig() {
+	VisionConfig c = BasicCornerDetectionGui::getConfig();
+	c.tile_size = m_gui.getValue<float>("tile-size");
+	c.size_tolerance = m_gui.getValue<float>("size-tolerance");
+	c.corner_tolerance = m_gui.getValue<float>("corner-tolerance");
+	c.max_movement = m_gui.getValue<float>("max-movement");
+	c.max_rotation = m_gui.getValue<float>("max-rotation");
+	c.refine_pose = m_gui.getValue<bool>("refine-pose");
+	c.icp_iterations = m_gui.getValue<int>("icp-iterations");
+	c.forget_after = m_forget_after;
+	c.use_rois = m_gui.getValue<bool>("use-rois");
+	c.roi_margin = m_gui.getValue<float>("roi-margin");
+	c.full_scan_interval = m_gui.getValue<int>("full-scan-interval");
+	return c;
+}
+		
+void TangramGui::draw(ICLDrawWidget *w, const VisionFrame &frame) {
 	static const Color4D RED(255,50,50,255);
 	static const Color4D YELLOW(255,255,0,255);
 	static const Color4D GRAY(50,50,50,200);
-	static float &tileSize = m_gui.getValue<float>("tile-size");
-	static float &sizeTolerance = m_gui.getValue<float>("size-tolerance");
-	static float &cornerTolerance = m_gui.getValue<float>("corner-tolerance");
-	static ButtonHandle &auto_adjust_button = m_gui.getValue<ButtonHandle>("blob-auto-adjust-handle");
+	float &tileSize = m_gui.getValue<float>("tile-size");
+	LabelHandle tracking_label = m_gui.getValue<LabelHandle>("tracking-label");
+	ButtonHandle &auto_adjust_button = m_gui.getValue<ButtonHandle>("blob-auto-adjust-handle");
 	
-	Mutex::Locker l(m_polygon_mutex);
-	m_polygon_shapes.clear();
-	m_timestep++;
-	if (m_tangram_classifier.getBaseLength() != tileSize) {
-		m_tangram_classifier.setSize(tileSize);
+	// corner detection and tracking, the configuration was set by segmentFrame()
+	m_vision.track(frame, m_result);
+	for(unsigned int i=0;i<m_result.corners.size();++i) {
+	  w->color(255,255,255,255);
+    //w->text(str(frame.blobs[i].size), frame.blobs[i].cog.x-20, frame.blobs[i].cog.y-20);
+	  drawCorners(w, m_result.corners[i], RED, RED);
+	}
+	if (m_tile_size != tileSize || auto_adjust_button.wasTriggered()) {
+		m_tile_size = tileSize;
 		adjustRegionDetectorParams();
-		m_polygon_pool.clear();
 	}
-	if (auto_adjust_button.wasTriggered()) adjustRegionDetectorParams();
-
-	forgetOldPolygons(m_forget_after);
+	if (frame.id % 10 == 0) tracking_label = m_vision.getTrackingStatistics();
 
-	// iterate over detected regions
-	for(unsigned int i=0;i<rs.size();++i) {
-	  // do the corner detection
-	  vector<Point32f> corners = detectCornersCSS(rs[i]);
-	  w->color(255,255,255,255);
-    //w->text(str(rs[i].getSize()), rs[i].getCOG().x-20, rs[i].getCOG().y-20);
-	  drawCorners(w, corners, RED, RED);
-	  // transform to world coordinates
-		if (do_world_transformation) m_cam_transformer.transformScreenToWorld2D(corners);
-
-	  // object classification, but only if polygon has less than 6 corners
-	  if (corners.size() > 5) continue;
-	  PolygonShape observed_shape(corners);
-	  m_polygon_shapes.push_back(observed_shape);
-	  // try to match a polygon from the polygon pool on the observed shape
-	  if (! PolygonMapper::mapPolygonObjects(observed_shape, m_polygon_pool, m_timestep, cornerTolerance)) {
-	  	// it didn't work, so try to match any of the tangram shapes and create a new polygon object
-	  	vector<PolygonShape> candidate_shapes = m_tangram_classifier.classify(observed_shape, sizeTolerance, true);
-	  	vector<PolygonObject> polygons = PolygonMapper::mapPolygonShapes(observed_shape, candidate_shapes, cornerTolerance,true,false);
-	  	// take the best match and copy it to the polygon pool
-	  	if (polygons.size() > 0) {
-	  		polygons[0].setActive(m_timestep);
-	  		m_polygon_pool.push_back(polygons[0]);
-	  	}
-	  }
-	}
 	if (m_grid_size != -1) drawGrid(w,m_grid_size,Color4D(80,255,80,255));
-	drawPolygons(w, m_polygon_pool, RED, RED);
-	drawPredictedShapes(w, YELLOW);
+	drawPolygons(w, m_result.polygons, m_result.timestep, RED, RED);
+	drawPredictedShapes(w, m_result.polygons, YELLOW);
 }
 
 void TangramGui::setCameraTransformer(CameraTransformer tc, bool use_it) {
-	m_cam_transformer = tc;
+	m_vision.setCameraTransformer(tc);
 	setDoWorldTransformation(use_it);
 }
 
 void TangramGui::setDoWorldTransformation(bool value) {
-	do_world_transformation = value;
+	m_vision.setDoWorldTransformation(value);
 	if (value) adjustRegionDetectorParams();
 }
 
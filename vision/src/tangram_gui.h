@@ -9,7 +9,6 @@
 
 #include "polygon_object.h"
 #include "basic_corner_detection_gui.h"
-#include "tangram_classifier.h"
 #include "camera_transformer.h"
 
 /// Class adding to the BasicsCornerDetectionGui the functionality of tracking tangrams.
@@ -23,31 +22,42 @@
  * if a camera for performing the screen to world transformation is provided via
  * the setCamera(.) method and then calling the enableScreenToWorldTransformation()
  * method. When no camera is provides, all classes work with pixels as units.
+ *
+ * The tracking is done by the TangramVisionPipeline of the parent class,
+ * this class adds the tracking parameters of the GUI to its configuration
+ * and draws the results.
  */
 class TangramGui : public BasicCornerDetectionGui {
 	public:
-		TangramGui(): BasicCornerDetectionGui(), m_timestep(0),	do_world_transformation(false),
-			m_grid_size(-1), m_forget_after(20)
-			{ m_tab_names += ",Tangram Tracking"; }
+		TangramGui(): BasicCornerDetectionGui(), m_grid_size(-1), m_forget_after(20),
+			m_tile_size(-1) { m_tab_names += ",Tangram Tracking"; }
+		~TangramGui() { stopPipeline(); }
 		
-		virtual void draw(icl::ICLDrawWidget *w, const std::vector<icl::Region> &rs);
+		virtual void draw(icl::ICLDrawWidget *w, const VisionFrame &frame);
 		
 		virtual void init();
 		
 		void loadShapesFromXMLFile(const std::string &file);
 		void loadStandardTangramShapes();
 		
-		std::vector<PolygonObject*> getActivePolygons();
-		std::vector<PolygonObject> &getPolygons() { return m_polygon_pool; }
-		std::vector<PolygonShape> getCurrentPolygonShapes() const { return m_polygon_shapes; }
+		/// Returns copies of the polygons that are active in the current frame.
+		/** The copies stay valid while the vision pipeline goes on. Use
+		 * setPredictedTransformation() to write back results by the polygon id. */
+		std::vector<PolygonObject> getActivePolygons() { return m_vision.getActivePolygons(); }
+		/// Returns copies of all active and inactive polygons.
+		std::vector<PolygonObject> getPolygons() { return m_vision.getPolygons(); }
+		/// Sets the predicted transformation of the polygon with the passed id.
+		/** Returns false if there is no such polygon anymore. */
+		bool setPredictedTransformation(int id, const Transformation &t) { return m_vision.setPredictedTransformation(id, t); }
+		std::vector<PolygonShape> getCurrentPolygonShapes() { return m_vision.getCurrentPolygonShapes(); }
 	
 		void setCameraTransformer(CameraTransformer tc, bool use_it=true);
-		const CameraTransformer &getCameraTransformer() { return m_cam_transformer; }
+		const CameraTransformer &getCameraTransformer() { return m_vision.getCameraTransformer(); }
 		virtual void setDoWorldTransformation(bool value);
-		bool getDoWorldTransformation() { return do_world_transformation; }
+		bool getDoWorldTransformation() { return m_vision.getDoWorldTransformation(); }
 		
-		float getTangramHeight() const { return m_tangram_classifier.getHeight(); }
-		float getTangramBaseLength() const { return m_tangram_classifier.getBaseLength(); }
+		float getTangramHeight() const { return m_vision.getTangramHeight(); }
+		float getTangramBaseLength() const { return m_vision.getTangramBaseLength(); }
 		
 		void enableGrid(float grid_size_mm) { m_grid_size = grid_size_mm; }
 		void disableGrid() { m_grid_size = -1; }
@@ -60,33 +70,29 @@ class TangramGui : public BasicCornerDetectionGui {
 	protected:
 		/// Gets called on init by the parent class
 		virtual GUI &addControls(icl::GUI &gui);
+		/// Adds the tracking parameters to the ones of the parent class.
+		virtual VisionConfig getConfig();
 		
-		/// Automatically adjusts the parameters of the RegionDetector.
+		/// Automatically adjusts the parameters of the BlobDetector.
 		/** Checks area of the smallest and biggest polygon shape model on screen and
-		 * adjusts max and min blob size of the RegionDetector.*/
+		 * adjusts max and min blob size of the BlobDetector.*/
 		void adjustRegionDetectorParams();
 
 		void drawPolygons(icl::ICLDrawWidget *w, const std::vector<PolygonObject> &polygons,
-				const icl::Color4D &color,	const icl::Color4D &fill);
+				int timestep, const icl::Color4D &color,	const icl::Color4D &fill);
 
-		void drawPredictedShapes(icl::ICLDrawWidget *w, const icl::Color4D &color);
+		void drawPredictedShapes(icl::ICLDrawWidget *w, const std::vector<PolygonObject> &polygons,
+				const icl::Color4D &color);
 
 		/// Grid size must be 40 mm at least. A camera transformer must be set.
 		void drawGrid(ICLDrawWidget *w, float size_mm, const Color4D &color,
 			float offset_x_mm=0, float offset_y_mm=0);
-		
-	private:
-		void forgetOldPolygons(int max_age);
 
-		std::vector<PolygonObject> m_polygon_pool;
-		std::vector<PolygonShape> m_polygon_shapes;
-		int m_timestep;
-		icl::Mutex m_polygon_mutex;
-		TangramClassifier m_tangram_classifier;
-		CameraTransformer m_cam_transformer;
-		bool do_world_transformation;
+	private:
 		float m_grid_size;
 		int m_forget_after;
+		float m_tile_size; ///< tile size of the last frame, to notice changes
+		VisionResult m_result;
 };
 
 #endif /* __TANGRAM_GUI_EWEITNAU_H__ */
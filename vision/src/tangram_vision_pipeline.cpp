@@ -0,0 +1,558 @@
+// Copyright 2009 Erik Weitnauer
+#include "tangram_vision_pipeline.h"
+#include <ICLUtils/StringUtils.h>
+#include "image_pyramid.h"
+#include "polygon_mapper.h"
+
+using namespace std;
+using namespace icl;
+
+struct ColorDist{
+  float r,g,b;
+  ColorDist(const std::vector<double> &color):
+    r(color.at(0)),g(color.at(1)),b(color.at(2)){}
+  static inline float sqr(float x){ return x*x; }
+  void operator()(const icl8u src[3], icl8u dst[1]) const{
+    *dst = 255.0 - sqrt(sqr(r-src[0])+sqr(g-src[1])+sqr(b-src[2]))/sqrt(3);
+  }
+};
+
+void create_weight_image(const Img8u &image, const std::vector<double> &color, Img8u &wi){
+  wi.setChannels(1);
+  wi.setSize(image.getSize());
+  image.reduce_channels<icl8u,3,1,ColorDist>(wi,ColorDist(color));
+}
+
+/// Returns the ms since t and sets t to now.
+static float lap(Time &t) {
+  Time now = Time::now();
+  float ms = (now-t).toMicroSecondsDouble()/1000;
+  t = now;
+  return ms;
+}
+
+VisionConfig::VisionConfig(): ref_color(3,255),
+	threshold(50), mask_size(100), min_blob_size(400), max_blob_size(100000),
+	pyramid_factor(1), skip_unchanged(false), change_threshold(6),
+	sigma(3), rc_coeff(1.5), curvature_cutoff(100), max_angle(162), straight_line_thresh(10),
+	contour_spacing(0), region_cache(false), cache_quantization(1),
+	tile_size(96), size_tolerance(0.2), corner_tolerance(0.1), max_movement(1), max_rotation(180),
+	refine_pose(false), icp_iterations(2), forget_after(20),
+	use_rois(false), roi_margin(30), full_scan_interval(10) {}
+
+TangramVisionPipeline::TangramVisionPipeline(int threads):
+	m_threshold_op(35,-10,threads), m_blob_detector(400,100000,255), m_last_segmentation_partial(false),
+	m_corner_detection(threads), m_timestep(0), m_do_world_transformation(false), m_frames_since_full_scan(0),
+	m_object_lost(false), m_tracked_frame_id(-1), m_mapping_lookups(0), m_mapping_hits(0) {}
+
+void TangramVisionPipeline::setConfig(const VisionConfig &config) {
+	Mutex::Locker l(m_config_mutex);
+	m_config = config;
+}
+
+VisionConfig TangramVisionPipeline::getConfig() {
+	Mutex::Locker l(m_config_mutex);
+	return m_config;
+}
+
+void TangramVisionPipeline::segment(VisionFrame &frame) {
+  VisionConfig c = getConfig();
+  m_threshold_op.setGlobalThreshold(c.threshold);
+  m_threshold_op.setMaskSize(c.mask_size);
+  m_blob_detector.setRestrictions(c.min_blob_size, c.max_blob_size);
+  int factor = c.pyramid_factor;
+  frame.blobs.clear();
+  frame.blobs_frame_id = frame.id;
+  frame.timings = VisionTimings();
+
+  // segment around the tracked polygons, unless the tracking asks for a full scan
+  vector<Rect> rois;
+  bool roi_scan = c.use_rois && getRegionsOfInterest(c, frame.image.getSize(), rois);
+
+  // the results of the last frame can only be reused with the same parameters,
+  // and not for a full scan if they only cover the regions of interest
+  m_segment_mutex.lock();
+  double p[] = {c.threshold, c.mask_size, c.min_blob_size, c.max_blob_size, factor,
+    c.ref_color[0], c.ref_color[1], c.ref_color[2]};
+  vector<double> params(p, p+8);
+  bool reusable = c.skip_unchanged && m_last_segmentation.blobs_frame_id != -1 && params == m_last_params
+    && (roi_scan || !m_last_segmentation_partial);
+  m_last_params = params;
+  int changed_tiles = -1;
+  if (c.skip_unchanged) {
+    m_change_detector.setThreshold(c.change_threshold);
+    changed_tiles = m_change_detector.detect(frame.image);
+  } else m_change_detector.reset();
+  m_segment_mutex.unlock();
+
+  if (reusable && changed_tiles == 0) {
+    // nothing changed, reuse everything
+    m_last_segmentation.distance_image.deepCopy(&frame.distance_image);
+    m_last_segmentation.threshold_image.deepCopy(&frame.threshold_image);
+    frame.blobs = m_last_segmentation.blobs;
+    frame.blobs_frame_id = m_last_segmentation.blobs_frame_id;
+    frame.processed_fraction = 0;
+    return;
+  }
+
+	// get distance image to reference color
+  Time t = Time::now();
+  create_weight_image(frame.image,c.ref_color,frame.distance_image);
+  frame.timings.color_distance = lap(t);
+
+  Rect changed;
+  if (roi_scan) {
+    // use the local threshold only inside the regions of interest
+    frame.threshold_image.setChannels(1);
+    frame.threshold_image.setSize(frame.image.getSize());
+    frame.threshold_image.clear();
+    int pixels = segmentROIs(frame, rois);
+    frame.processed_fraction = (float)pixels / frame.image.getDim();
+  } else if (reusable && getChangedArea(frame.image.getSize(), changed)) {
+    // segment the changed area again and keep the blobs outside of it
+    m_last_segmentation.threshold_image.deepCopy(&frame.threshold_image);
+    vector<Rect> area(1, changed);
+    int pixels = segmentROIs(frame, area);
+    const vector<Blob> &last_blobs = m_last_segmentation.blobs;
+    for (unsigned int i=0; i<last_blobs.size(); i++) {
+      if (!intersect(getBoundingBox(last_blobs[i]), changed)) frame.blobs.push_back(last_blobs[i]);
+    }
+    frame.processed_fraction = (float)pixels / frame.image.getDim();
+  } else if (factor > 1) {
+    segmentPyramid(frame, factor, c.min_blob_size, c.max_blob_size);
+  } else {
+    // use the local threshold on the whole image
+    m_threshold_op.apply(frame.distance_image, m_threshold_image);
+    m_threshold_image.deepCopy(&frame.threshold_image);
+    frame.timings.threshold += lap(t);
+    addBlobs(frame, Rect(Point::null, frame.image.getSize()));
+    frame.timings.regions += lap(t);
+    frame.processed_fraction = 1;
+  }
+
+  if (c.skip_unchanged) {
+    frame.distance_image.deepCopy(&m_last_segmentation.distance_image);
+    frame.threshold_image.deepCopy(&m_last_segmentation.threshold_image);
+    m_last_segmentation.blobs = frame.blobs;
+    m_last_segmentation.blobs_frame_id = frame.id;
+    m_last_segmentation_partial = roi_scan;
+  } else m_last_segmentation.blobs_frame_id = -1;
+}
+
+int TangramVisionPipeline::segmentROIs(VisionFrame &frame, vector<Rect> &rois,
+    const Img8u *band, int factor) {
+  mergeOverlappingRects(rois);
+  // threshold the rois plus the mask size on each side, so the local means
+  // inside them are the same as on the whole image. Overlapping padded rois
+  // are merged, so no pixel is thresholded twice.
+  int margin = m_threshold_op.getMaskSize();
+  Rect image(Point::null, frame.distance_image.getSize());
+  vector<Rect> padded;
+  for (unsigned int i=0; i<rois.size(); i++) {
+    const Rect &r = rois[i];
+    padded.push_back(clip(Rect(r.x-margin, r.y-margin, r.width+2*margin, r.height+2*margin), image));
+  }
+  mergeOverlappingRects(padded);
+  int pixels = 0;
+  for (unsigned int i=0; i<padded.size(); i++) {
+    Time t = Time::now();
+    frame.distance_image.setROI(padded[i]);
+    frame.distance_image.deepCopyROI(&m_roi_image);
+    frame.distance_image.setFullROI();
+    m_threshold_op.apply(m_roi_image, m_padded_threshold_image);
+    frame.timings.threshold += lap(t);
+    pixels += padded[i].getDim();
+    // each roi lies inside exactly one of the merged padded rois
+    for (unsigned int j=0; j<rois.size(); j++) {
+      if (intersect(rois[j], padded[i])) segmentROI(frame, rois[j], padded[i], band, factor);
+    }
+  }
+  return pixels;
+}
+
+void TangramVisionPipeline::segmentROI(VisionFrame &frame, const Rect &roi, const Rect &padded,
+    const Img8u *band, int factor) {
+  Time t = Time::now();
+  m_threshold_image.setChannels(1);
+  m_threshold_image.setSize(Size(roi.width, roi.height));
+  for (int y=0; y<roi.height; y++) {
+    memcpy(m_threshold_image.getData(0) + y*roi.width,
+           m_padded_threshold_image.getData(0) + (roi.y-padded.y+y)*padded.width + roi.x-padded.x, roi.width);
+  }
+  if (band) {
+    // outside of the band around the coarse contours, the coarse result is used
+    int band_w = band->getWidth(), band_h = band->getHeight();
+    for (int y=0; y<roi.height; y++) {
+      const icl8u *b = band->getData(0) + min(band_h-1, (roi.y+y)/factor)*band_w;
+      icl8u *t = m_threshold_image.getData(0) + y*m_threshold_image.getWidth();
+      for (int x=0; x<roi.width; x++) {
+        icl8u c = b[min(band_w-1, (roi.x+x)/factor)];
+        if (c != 128) t[x] = c;
+      }
+    }
+  }
+  // paste the thresholded roi into the threshold image of the frame
+  for (int y=0; y<roi.height; y++) {
+    memcpy(frame.threshold_image.getData(0) + (roi.y+y)*frame.threshold_image.getWidth() + roi.x,
+           m_threshold_image.getData(0) + y*m_threshold_image.getWidth(), roi.width);
+  }
+  frame.timings.threshold += lap(t);
+  addBlobs(frame, roi);
+  frame.timings.regions += lap(t);
+}
+
+void TangramVisionPipeline::segmentPyramid(VisionFrame &frame, int factor,
+    int min_blob_size, int max_blob_size) {
+  // find the blobs in the reduced distance image
+  Time t = Time::now();
+  reduceImage(frame.distance_image, m_coarse_distance, factor, m_coarse_tmp);
+  int mask_size = m_threshold_op.getMaskSize();
+  m_threshold_op.setMaskSize(max(1, mask_size/factor));
+  m_threshold_op.apply(m_coarse_distance, m_coarse_threshold);
+  m_threshold_op.setMaskSize(mask_size);
+  frame.timings.threshold += lap(t);
+  // the sizes of the coarse blobs are less exact, the final check is done at full resolution
+  m_coarse_blob_detector.setRestrictions(min_blob_size/(2*factor*factor), 2*max_blob_size/(factor*factor));
+  const vector<Blob> &coarse_blobs = m_coarse_blob_detector.detect(m_coarse_threshold);
+  frame.timings.regions += lap(t);
+  classifyContourBand(m_coarse_threshold, m_coarse_band);
+  frame.timings.threshold += lap(t);
+
+  // segment the areas around the coarse blobs at full resolution
+  Rect image(Point::null, frame.image.getSize());
+  vector<Rect> rois;
+  for (unsigned int i=0; i<coarse_blobs.size(); i++) {
+    Rect bb = getBoundingBox(coarse_blobs[i]);
+    Rect roi = clip(Rect((bb.x-1)*factor, (bb.y-1)*factor, (bb.width+2)*factor, (bb.height+2)*factor), image);
+    if (roi.getDim() > 0) rois.push_back(roi);
+  }
+  frame.threshold_image.setChannels(1);
+  frame.threshold_image.setSize(frame.image.getSize());
+  frame.threshold_image.clear();
+  int pixels = segmentROIs(frame, rois, &m_coarse_band, factor);
+  frame.processed_fraction = (float)pixels / frame.image.getDim();
+}
+
+bool TangramVisionPipeline::getChangedArea(const Size &image_size, Rect &area) {
+  area = m_change_detector.getChangedBoundingBox();
+  if (area.getDim() == 0) return false;
+  // the local threshold of a pixel depends on the pixels up to the mask size
+  // away, so the result changes that far around the changed tiles
+  int margin = max(m_change_detector.getTileSize(), m_threshold_op.getMaskSize());
+  Rect image(Point::null, image_size);
+  area = clip(Rect(area.x-margin, area.y-margin, area.width+2*margin, area.height+2*margin), image);
+  // blobs reaching into the area must be detected completely again
+  const vector<Blob> &blobs = m_last_segmentation.blobs;
+  bool grown = true;
+  while (grown) {
+    grown = false;
+    for (unsigned int i=0; i<blobs.size(); i++) {
+      Rect bb = clip(getBoundingBox(blobs[i]), image);
+      if (!intersect(bb, area)) continue;
+      int x0 = min(bb.x, area.x), y0 = min(bb.y, area.y);
+      int x1 = max(bb.right(), area.right()), y1 = max(bb.bottom(), area.bottom());
+      if (x0 == area.x && y0 == area.y && x1 == area.right() && y1 == area.bottom()) continue;
+      area = Rect(x0, y0, x1-x0, y1-y0);
+      grown = true;
+    }
+  }
+  // for big areas, the whole image is faster
+  return area.getDim() < image.getDim()/2;
+}
+
+Rect TangramVisionPipeline::getBoundingBox(const Blob &blob) {
+  const vector<Point> &b = blob.boundary;
+  if (b.empty()) return Rect();
+  int min_x = b[0].x, max_x = min_x, min_y = b[0].y, max_y = min_y;
+  for (unsigned int j=1; j<b.size(); j++) {
+    min_x = min(min_x, b[j].x); max_x = max(max_x, b[j].x);
+    min_y = min(min_y, b[j].y); max_y = max(max_y, b[j].y);
+  }
+  // one pixel more, so touching blobs are detected again, too
+  return Rect(min_x-1, min_y-1, max_x-min_x+3, max_y-min_y+3);
+}
+
+void TangramVisionPipeline::addBlobs(VisionFrame &frame, const Rect &roi) {
+  const vector<Blob> &blobs = m_blob_detector.detect(m_threshold_image);
+  const Size &size = frame.image.getSize();
+  // copy the blobs, as the detector reuses them
+  for (unsigned int i=0; i<blobs.size(); i++) {
+    const vector<Point> &boundary = blobs[i].boundary;
+    if (boundary.empty()) continue;
+    // regions cut by the border of the roi are incomplete, skip them
+    int min_x = boundary[0].x, max_x = min_x, min_y = boundary[0].y, max_y = min_y;
+    for (unsigned int j=1; j<boundary.size(); j++) {
+      min_x = min(min_x, boundary[j].x); max_x = max(max_x, boundary[j].x);
+      min_y = min(min_y, boundary[j].y); max_y = max(max_y, boundary[j].y);
+    }
+    if ((min_x == 0 && roi.x > 0) || (min_y == 0 && roi.y > 0) ||
+        (max_x == roi.width-1 && roi.right() < size.width) ||
+        (max_y == roi.height-1 && roi.bottom() < size.height)) continue;
+    Blob blob;
+    blob.boundary.resize(boundary.size());
+    for (unsigned int j=0; j<boundary.size(); j++)
+      blob.boundary[j] = Point(boundary[j].x+roi.x, boundary[j].y+roi.y);
+    blob.cog = Point32f(blobs[i].cog.x+roi.x, blobs[i].cog.y+roi.y);
+    blob.size = blobs[i].size;
+    frame.blobs.push_back(blob);
+  }
+}
+
+bool TangramVisionPipeline::intersect(const Rect &a, const Rect &b) {
+  return a.x < b.right() && b.x < a.right() && a.y < b.bottom() && b.y < a.bottom();
+}
+
+Rect TangramVisionPipeline::clip(const Rect &r, const Rect &bounds) {
+  int x0 = max(r.x, bounds.x), y0 = max(r.y, bounds.y);
+  int x1 = min(r.right(), bounds.right()), y1 = min(r.bottom(), bounds.bottom());
+  if (x1 <= x0 || y1 <= y0) return Rect();
+  return Rect(x0, y0, x1-x0, y1-y0);
+}
+
+void TangramVisionPipeline::mergeOverlappingRects(vector<Rect> &rects) {
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (unsigned int i=0; i<rects.size() && !merged; i++) {
+      for (unsigned int j=i+1; j<rects.size() && !merged; j++) {
+        Rect &a = rects[i], &b = rects[j];
+        if (a.x >= b.right() || b.x >= a.right() || a.y >= b.bottom() || b.y >= a.bottom()) continue;
+        int x = min(a.x, b.x), y = min(a.y, b.y);
+        a = Rect(x, y, max(a.right(), b.right())-x, max(a.bottom(), b.bottom())-y);
+        rects.erase(rects.begin()+j);
+        merged = true;
+      }
+    }
+  }
+}
+
+const CornerDetectionBatch &TangramVisionPipeline::detectCorners(const vector<Blob> &blobs) {
+	VisionConfig c = getConfig();
+	m_corner_detection.setParameters(c.max_angle, c.rc_coeff, c.sigma,
+		c.curvature_cutoff, c.straight_line_thresh, c.contour_spacing);
+	m_corner_detection.setCache(c.region_cache, c.cache_quantization);
+	m_corner_detection.detect(blobs);
+	return m_corner_detection;
+}
+
+vector<Point32f> TangramVisionPipeline::detectCorners(const Blob &blob) {
+	VisionConfig c = getConfig();
+	vector<Point32f> boundary;
+	getThinnedBoundary(blob.boundary, boundary);
+	CornerDetectorCSS detector(c.max_angle, c.rc_coeff, c.sigma, c.curvature_cutoff, c.straight_line_thresh);
+	detector.contour_spacing = c.contour_spacing;
+	return detector.detectCorners(boundary);
+}
+
+void TangramVisionPipeline::loadShapesFromXMLFile(const std::string &file) {
+	Mutex::Locker l(m_polygon_mutex);
+	m_tangram_classifier.clearShapes();
+	m_tangram_classifier.loadShapesFromXML(file);
+}
+
+void TangramVisionPipeline::loadStandardTangramShapes() {
+	float tile_size = getConfig().tile_size;
+	Mutex::Locker l(m_polygon_mutex);
+	m_tangram_classifier.clearShapes();
+	m_tangram_classifier.loadStandardTangramShapes(tile_size,18);
+}
+
+// Check the area of the smallest and the biggest polygon shape on the screen.
+bool TangramVisionPipeline::getBlobSizeLimits(float &min_size, float &max_size) {
+	Mutex::Locker l(m_polygon_mutex);
+	const std::vector<PolygonShape> &shapes = m_tangram_classifier.getAllShapes();
+	if (shapes.empty()) return false;
+	int biggest_idx=0, smallest_idx=0;
+	for (unsigned int i=1; i<shapes.size(); ++i) {
+		if (shapes[i].getArea() > shapes[biggest_idx].getArea()) biggest_idx = i;
+		else if (shapes[i].getArea() < shapes[smallest_idx].getArea()) smallest_idx = i;
+	}
+	float biggest_area, smallest_area;
+	if (m_do_world_transformation) {
+		PolygonShape bigshape = shapes[biggest_idx];
+		PolygonShape smallshape = shapes[smallest_idx];
+		m_cam_transformer.transformWorldToScreen2D(bigshape, bigshape.getHeight());
+		m_cam_transformer.transformWorldToScreen2D(smallshape, smallshape.getHeight());
+		biggest_area=bigshape.getArea();
+		smallest_area=smallshape.getArea();
+	} else {
+		biggest_area=shapes[biggest_idx].getArea();
+		smallest_area=shapes[smallest_idx].getArea();
+	}
+	max_size = biggest_area*1.2;
+	min_size = smallest_area*0.8;
+	return true;
+}
+
+vector<PolygonObject> TangramVisionPipeline::getActivePolygons() {
+	Mutex::Locker l(m_polygon_mutex);
+	return m_polygon_pool.getActive(m_timestep);
+}
+
+vector<PolygonObject> TangramVisionPipeline::getPolygons() {
+	Mutex::Locker l(m_polygon_mutex);
+	return m_polygon_pool.getObjects();
+}
+
+bool TangramVisionPipeline::setPredictedTransformation(int id, const Transformation &t) {
+	Mutex::Locker l(m_polygon_mutex);
+	int index = m_polygon_pool.find(id);
+	if (index == -1) return false;
+	m_polygon_pool[index].setPredictedTransformation(t);
+	return true;
+}
+
+vector<PolygonShape> TangramVisionPipeline::getCurrentPolygonShapes() {
+	Mutex::Locker l(m_polygon_mutex);
+	return m_polygon_shapes;
+}
+
+int TangramVisionPipeline::getUnchangedFrameCount() {
+	Mutex::Locker l(m_segment_mutex);
+	return m_change_detector.getUnchangedFrameCount();
+}
+
+float TangramVisionPipeline::getUnchangedTileRatio() {
+	Mutex::Locker l(m_segment_mutex);
+	long long tiles = m_change_detector.getTileCount();
+	return tiles ? float(m_change_detector.getUnchangedTileCount())/tiles : 0;
+}
+
+string TangramVisionPipeline::getTrackingStatistics() {
+	Mutex::Locker l(m_polygon_mutex);
+	return m_tracker.getStatistics().toString() + ", reused mappings: "
+		+ str(m_mapping_hits) + "/" + str(m_mapping_lookups);
+}
+
+void TangramVisionPipeline::track(const VisionFrame &frame, VisionResult &result) {
+	VisionConfig c = getConfig();
+	// if the blobs are the ones of the frame tracked last, its corners and tracking results are reused
+	bool reuse = frame.blobs_frame_id != frame.id && frame.blobs_frame_id == m_tracked_frame_id;
+	// do the corner detection for all blobs in parallel, without holding the lock
+	const CornerDetectionBatch &batch = reuse ? m_corner_detection : detectCorners(frame.blobs);
+	result.frame_id = frame.id;
+	result.timings = frame.timings;
+	if (!reuse) {
+		result.timings.thinning = batch.getThinningTime();
+		result.timings.css = batch.getCSSTime();
+	}
+	result.corners.resize(batch.size());
+	result.observed_shapes.clear();
+	vector<int> observed_regions; // index of the blob of each observed shape
+	for(int i=0;i<batch.size();++i) {
+	  vector<Point32f> corners = batch.getCorners(i);
+	  result.corners[i] = corners;
+	  // object classification, but only if polygon has less than 6 corners
+	  if (corners.size() > 5) continue;
+	  // transform to world coordinates
+		if (m_do_world_transformation) m_cam_transformer.transformScreenToWorld2D(corners);
+	  result.observed_shapes.push_back(PolygonShape(corners));
+	  observed_regions.push_back(i);
+	}
+	const vector<PolygonShape> &observed_shapes = result.observed_shapes;
+
+	// merge the observed shapes into the polygon pool
+	Mutex::Locker l(m_polygon_mutex);
+	m_polygon_shapes = observed_shapes;
+	m_timestep++;
+	if (m_tangram_classifier.getBaseLength() != c.tile_size) {
+		m_tangram_classifier.setSize(c.tile_size);
+		m_polygon_pool.clear();
+		reuse = false;
+	}
+
+	m_polygon_pool.forget(m_timestep, c.forget_after);
+
+	vector<bool> was_active(m_polygon_pool.size());
+	for(int i=0;i<m_polygon_pool.size();++i) was_active[i] = m_polygon_pool.getObjects()[i].isActive(m_timestep-1);
+	m_tracked_frame_id = frame.blobs_frame_id;
+	if (reuse) {
+		// nothing moved, so the polygons found in the last frame are still there
+		for(int i=0;i<m_polygon_pool.size();++i) if (was_active[i]) m_polygon_pool[i].setActive(m_timestep);
+	} else {
+		// mappings of the last frame can only be reused with the same parameters
+		float p[] = {c.tile_size, c.size_tolerance, c.corner_tolerance, c.refine_pose, c.icp_iterations, m_do_world_transformation};
+		vector<float> params(p, p+6);
+		if (params != m_mapping_params) m_last_mappings.clear();
+		m_mapping_params = params;
+		// assign the observed shapes to the nearby polygons from the polygon pool all at once
+		m_tracker.setDynThresh(c.corner_tolerance);
+		m_tracker.setMaxTranslation(c.max_movement*c.tile_size);
+		m_polygon_pool.setCellSize(c.max_movement*c.tile_size);
+		m_tracker.setMaxRotation(c.max_rotation*M_PI/180);
+		m_tracker.setRefineIterations(c.refine_pose ? c.icp_iterations : -1);
+		vector<int> assignment;
+		Time t = Time::now();
+		m_tracker.track(observed_shapes, m_polygon_pool, m_timestep, assignment);
+		result.timings.tracking = lap(t);
+		vector<int> candidate_ids;
+		vector<MappingModel> candidate_models;
+		for(unsigned int i=0;i<observed_shapes.size();++i) {
+		  if (assignment[i] != -1) continue;
+		  const PolygonShape &observed_shape = observed_shapes[i];
+		  // if the corners of the blob were reused, so is its mapping
+		  int previous = batch.getPreviousIndex(observed_regions[i]);
+		  map<int, vector<PolygonObject> >::const_iterator cached = m_last_mappings.find(previous);
+		  m_mapping_lookups++;
+		  vector<PolygonObject> polygons;
+		  if (previous != -1 && cached != m_last_mappings.end()) {
+		  	m_mapping_hits++;
+		  	// copy it with a new id
+		  	const vector<PolygonObject> &cp = cached->second;
+		  	for (unsigned int k=0; k<cp.size(); ++k)
+		  		polygons.push_back(PolygonObject(cp[k].getTransformation(), cp[k].getScaling(), cp[k].getShape(), cp[k].getError()));
+		  } else {
+		  	// no polygon was assigned, so try to match any of the tangram shapes and create a new polygon object
+		  	t = Time::now();
+		  	m_tangram_classifier.classify(observed_shape, candidate_ids, c.size_tolerance, true);
+		  	result.timings.classification += lap(t);
+		  	candidate_models.clear();
+		  	for (unsigned int k=0; k<candidate_ids.size(); ++k)
+		  		candidate_models.push_back(MappingModel(m_tangram_classifier.getShape(candidate_ids[k]), c.corner_tolerance));
+		  	polygons = PolygonMapper::mapPolygonShapes(observed_shape, candidate_models, true, false,
+		  		c.refine_pose ? c.icp_iterations : -1);
+		  	if (polygons.size() > 1) polygons.resize(1);
+		  	result.timings.mapping += lap(t);
+		  }
+		  m_mappings[observed_regions[i]] = polygons;
+	  	// take the best match and copy it to the polygon pool
+	  	if (polygons.size() > 0) {
+	  		polygons[0].setActive(m_timestep);
+	  		m_polygon_pool.add(polygons[0]);
+	  	}
+		}
+		m_last_mappings.swap(m_mappings);
+		m_mappings.clear();
+	}
+	for(unsigned int i=0;i<was_active.size();++i) {
+		if (was_active[i] && !m_polygon_pool.getObjects()[i].isActive(m_timestep)) m_object_lost = true;
+	}
+	result.timestep = m_timestep;
+	result.polygons = m_polygon_pool.getObjects();
+}
+
+bool TangramVisionPipeline::getRegionsOfInterest(const VisionConfig &config, const Size &image_size,
+		vector<Rect> &rois) {
+	Mutex::Locker l(m_polygon_mutex);
+	if (m_object_lost || ++m_frames_since_full_scan >= config.full_scan_interval) {
+		m_object_lost = false;
+		m_frames_since_full_scan = 0;
+		return false;
+	}
+	const float margin = config.roi_margin;
+	const vector<PolygonObject> &polygons = m_polygon_pool.getObjects();
+	for (unsigned int i=0; i<polygons.size(); i++) {
+		if (!polygons[i].isActive(m_timestep)) continue;
+		PolygonShape shape = polygons[i].getPredictedShape().hasCorners() ?
+			polygons[i].getPredictedShape() : polygons[i].getTransformedShape();
+		if (m_do_world_transformation)
+			m_cam_transformer.transformWorldToScreen2D(shape, shape.getHeight());
+		const Rect32f &bb = shape.getBoundingBox();
+		int x0 = max(0, (int)floor(bb.x-margin));
+		int y0 = max(0, (int)floor(bb.y-margin));
+		int x1 = min(image_size.width, (int)ceil(bb.x+bb.width+margin));
+		int y1 = min(image_size.height, (int)ceil(bb.y+bb.height+margin));
+		if (x1 > x0 && y1 > y0) rois.push_back(Rect(x0, y0, x1-x0, y1-y0));
+	}
+	return !rois.empty();
+}
@@ -0,0 +1,238 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __TANGRAM_VISION_PIPELINE_EWEITNAU_H__
+#define __TANGRAM_VISION_PIPELINE_EWEITNAU_H__
+
+#include <ICLCore/Img.h>
+#include <ICLUtils/Mutex.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "blob_detector.h"
+#include "camera_transformer.h"
+#include "change_detector.h"
+#include "corner_detection_batch.h"
+#include "local_threshold.h"
+#include "polygon_object.h"
+#include "polygon_pool.h"
+#include "polygon_tracker.h"
+#include "tangram_classifier.h"
+#include "vision_frame.h"
+
+/// All parameters of the TangramVisionPipeline.
+/** The default values are the ones of the sliders in the TangramGui. */
+struct VisionConfig {
+	VisionConfig();
+
+	// segmentation
+	std::vector<double> ref_color; ///< rgb color of the tangrams
+	int threshold; ///< global threshold of the local threshold
+	int mask_size; ///< of the local threshold
+	int min_blob_size, max_blob_size;
+	int pyramid_factor; ///< 1, 2 or 4, see BasicCornerDetectionGui
+	bool skip_unchanged; ///< reuse the segmentation of unchanged tiles
+	int change_threshold; ///< see ChangeDetector
+
+	// corner detection, see CornerDetectorCSS
+	float sigma, rc_coeff, curvature_cutoff, max_angle, straight_line_thresh, contour_spacing;
+	bool region_cache; ///< see CornerDetectionBatch::setCache()
+	int cache_quantization;
+
+	// tangram tracking
+	float tile_size; ///< base length of the standard tangram shapes
+	float size_tolerance; ///< for the classification
+	float corner_tolerance; ///< for the mapping and tracking
+	float max_movement; ///< per frame in tile sizes
+	float max_rotation; ///< per frame in deg
+	bool refine_pose;
+	int icp_iterations;
+	int forget_after; ///< timesteps after which lost polygons are removed
+	bool use_rois; ///< segment only around the tracked polygons
+	float roi_margin; ///< in px
+	int full_scan_interval; ///< segment the whole image every n frames when using ROIs
+};
+
+/// Results of TangramVisionPipeline::track() for one frame.
+struct VisionResult {
+	int frame_id;
+	/// Timestep of the polygon pool after the frame.
+	int timestep;
+	/// Corners of each blob of the frame in screen coordinates.
+	std::vector< std::vector<icl::Point32f> > corners;
+	/// Shapes of the blobs with at most 5 corners, in world coordinates if enabled.
+	std::vector<PolygonShape> observed_shapes;
+	/// Copies of all active and inactive tracked polygons.
+	std::vector<PolygonObject> polygons;
+	/// Times of the segmentation of the frame and of the steps of track().
+	/** If the frame did not change, the corners and tracking results of the
+	 * last frame are reused and the times of these steps are 0. */
+	VisionTimings timings;
+};
+
+/// Segmentation, corner detection and tangram tracking without any GUI.
+/**
+ The pipeline is configured by a VisionConfig and works on VisionFrames, so it
+ can be used by the GUIs as well as for offline processing of recorded images.
+ segment() detects the blobs in the image of a frame, track() detects their
+ corners and maps them to the tracked polygons. The two can run in different
+ threads for consecutive frames, like in the FramePipeline of the
+ BasicCornerDetectionGui. The configuration and the polygons can be accessed
+ from any thread.
+
+ Several pipelines are independent of each other, so batches of images can
+ be processed with one pipeline per thread. In that case, pass threads=1 to
+ the constructor, so the local threshold and the corner detection do not
+ start threads themselves.
+
+ Usage example:
+ \code
+ VisionConfig config;
+ config.ref_color[0] = 200; config.ref_color[1] = 40; config.ref_color[2] = 40;
+ TangramVisionPipeline vision;
+ vision.setConfig(config);
+ vision.loadStandardTangramShapes();
+ VisionResult result;
+ for (...) {
+   image.deepCopy(&frame.image);
+   vision.process(frame, result);
+   cout << result.polygons.size() << endl;
+ }
+ \endcode
+*/
+class TangramVisionPipeline {
+	public:
+		/// Uses 'threads' threads for the local threshold and the corner detection, see ThreadPool::ThreadPool().
+		TangramVisionPipeline(int threads=0);
+
+		void setConfig(const VisionConfig &config);
+		VisionConfig getConfig();
+
+		/// Calculates the color distance and threshold images and detects the blobs.
+		void segment(VisionFrame &frame);
+		/// Detects the corners of the blobs of the frame and tracks the polygons.
+		void track(const VisionFrame &frame, VisionResult &result);
+		/// Calls segment() and track().
+		void process(VisionFrame &frame, VisionResult &result) { segment(frame); track(frame, result); }
+
+		/// Applies the CSS corner detector on all blobs in parallel.
+		/** The batch is valid until the next call of this method or track(). */
+		const CornerDetectionBatch &detectCorners(const std::vector<Blob> &blobs);
+		/// Applies the CSS corner detector on one blob.
+		std::vector<icl::Point32f> detectCorners(const Blob &blob);
+
+		void loadShapesFromXMLFile(const std::string &file);
+		/// Loads the standard tangram shapes with the tile size of the configuration.
+		void loadStandardTangramShapes();
+		const TangramClassifier &getTangramClassifier() const { return m_tangram_classifier; }
+		float getTangramHeight() const { return m_tangram_classifier.getHeight(); }
+		float getTangramBaseLength() const { return m_tangram_classifier.getBaseLength(); }
+		/// Screen areas of the smallest and biggest shape, with 20% tolerance.
+		/** Returns false if no shapes are loaded. */
+		bool getBlobSizeLimits(float &min_size, float &max_size);
+
+		/// Returns copies of the polygons that are active in the current frame.
+		std::vector<PolygonObject> getActivePolygons();
+		/// Returns copies of all active and inactive polygons.
+		std::vector<PolygonObject> getPolygons();
+		/// Sets the predicted transformation of the polygon with the passed id.
+		/** Returns false if there is no such polygon anymore. */
+		bool setPredictedTransformation(int id, const Transformation &t);
+		/// Shapes observed in the last frame.
+		std::vector<PolygonShape> getCurrentPolygonShapes();
+
+		void setCameraTransformer(const CameraTransformer &tc) { m_cam_transformer = tc; }
+		const CameraTransformer &getCameraTransformer() const { return m_cam_transformer; }
+		void setDoWorldTransformation(bool value) { m_do_world_transformation = value; }
+		bool getDoWorldTransformation() const { return m_do_world_transformation; }
+
+		/// Number of frames in which no tile changed, see ChangeDetector.
+		int getUnchangedFrameCount();
+		/// Fraction of the tiles that did not change, see ChangeDetector.
+		float getUnchangedTileRatio();
+		/// Fraction of the regions whose corners were reused, see CornerDetectionBatch.
+		float getRegionCacheHitRatio() const { return m_corner_detection.getCacheHitRatio(); }
+		/// Statistics of the tracker and the number of reused mappings.
+		std::string getTrackingStatistics();
+
+	private:
+		/// Thresholds the distance image of the frame inside the rois and adds the blobs found there.
+		/** Overlapping rois are merged first. The local threshold is applied to
+		 * the rois plus a margin of the mask size, so the result inside them is
+		 * the same as for the whole image. Overlapping padded rois are
+		 * thresholded together. If a band image is passed, which is 'factor'
+		 * times smaller than the frame, only the pixels at which it is 128 are
+		 * thresholded, the other ones get its value, see classifyContourBand().
+		 * Returns the number of thresholded pixels, including the margins. */
+		int segmentROIs(VisionFrame &frame, std::vector<icl::Rect> &rois, const icl::Img8u *band=NULL, int factor=1);
+		/// Adds the blobs inside roi, m_padded_threshold_image must hold the thresholded area 'padded'.
+		void segmentROI(VisionFrame &frame, const icl::Rect &roi, const icl::Rect &padded,
+			const icl::Img8u *band, int factor);
+		/// Segments a reduced image and refines the blobs at full resolution.
+		/** The distance image is reduced by 'factor', thresholded with a mask
+		 * size reduced by the same factor, and the blobs are detected with
+		 * looser size restrictions. Around each blob, only a band of about
+		 * two reduced pixels around its contour is thresholded again at full
+		 * resolution, so the boundaries and corners are as exact as without
+		 * the pyramid. */
+		void segmentPyramid(VisionFrame &frame, int factor, int min_blob_size, int max_blob_size);
+		/// Detects the regions in m_threshold_image, which covers 'roi' of the frame, and adds them to the frame.
+		void addBlobs(VisionFrame &frame, const icl::Rect &roi);
+		/// Returns the area that must be segmented again after some tiles changed.
+		/** It is the bounding box of the changed tiles plus a margin, grown
+		 * until it contains all blobs of the last frame that reach into it.
+		 * Returns false if the area is so big that segmenting the whole image
+		 * is cheaper. */
+		bool getChangedArea(const icl::Size &image_size, icl::Rect &area);
+		/// Returns the screen bounding boxes of all active polygons plus a margin.
+		/** The predicted position of a polygon is used if it is available.
+		 * Returns false, if no polygon is active, an active polygon was lost
+		 * in the last frame or a full scan is due. */
+		bool getRegionsOfInterest(const VisionConfig &config, const icl::Size &image_size,
+			std::vector<icl::Rect> &rois);
+		/// Bounding box of the boundary plus one pixel on each side.
+		static icl::Rect getBoundingBox(const Blob &blob);
+		static bool intersect(const icl::Rect &a, const icl::Rect &b);
+		/// Intersection of r and bounds, an empty rectangle if they don't intersect.
+		static icl::Rect clip(const icl::Rect &r, const icl::Rect &bounds);
+		/// Replaces overlapping rectangles by their bounding rectangle.
+		static void mergeOverlappingRects(std::vector<icl::Rect> &rects);
+
+		icl::Mutex m_config_mutex;
+		VisionConfig m_config;
+
+		// segmentation, guarded by m_segment_mutex where other threads read it
+		icl::Mutex m_segment_mutex;
+		LocalThreshold m_threshold_op;
+		BlobDetector m_blob_detector;
+		icl::Img8u m_threshold_image;
+		icl::Img8u m_roi_image, m_padded_threshold_image;
+		ChangeDetector m_change_detector;
+		BlobDetector m_coarse_blob_detector;
+		icl::Img8u m_coarse_distance, m_coarse_tmp, m_coarse_threshold, m_coarse_band;
+		/// Images and blobs of the last segmented frame, if skipping unchanged frames is enabled.
+		VisionFrame m_last_segmentation;
+		/// Whether m_last_segmentation only covers the regions of interest of the tracked polygons.
+		bool m_last_segmentation_partial;
+		/// Threshold, mask size, blob sizes, pyramid factor and reference color used for m_last_segmentation.
+		std::vector<double> m_last_params;
+
+		// corner detection and tracking, the polygons are guarded by m_polygon_mutex
+		CornerDetectionBatch m_corner_detection;
+		icl::Mutex m_polygon_mutex;
+		PolygonPool m_polygon_pool;
+		std::vector<PolygonShape> m_polygon_shapes;
+		int m_timestep;
+		TangramClassifier m_tangram_classifier;
+		PolygonTracker m_tracker;
+		CameraTransformer m_cam_transformer;
+		bool m_do_world_transformation;
+		int m_frames_since_full_scan;
+		bool m_object_lost; ///< an active polygon was not found in the last frame
+		int m_tracked_frame_id; ///< id of the frame whose blobs were tracked last
+		/// Best mapping of each unassigned blob of the last tracked frame, by blob index.
+		/** Used for the blobs whose corners the CornerDetectionBatch reused. */
+		std::map<int, std::vector<PolygonObject> > m_last_mappings, m_mappings;
+		std::vector<float> m_mapping_params; ///< parameters used for m_last_mappings
+		int m_mapping_lookups, m_mapping_hits;
+};
+
+#endif /* __TANGRAM_VISION_PIPELINE_EWEITNAU_H__ */
@@ -0,0 +1,93 @@
+// Copyright 2009 Erik Weitnauer
+#include "thread_pool.h"
+#include <unistd.h>
+
+using namespace std;
+
+ThreadPool::ThreadPool(int threads): m_function(NULL), m_data(NULL),
+		m_next_task(0), m_task_count(0), m_done_count(0), m_generation(0), m_stop(false) {
+	if (threads <= 0) threads = getProcessorCount();
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_cond_init(&m_work_cond, NULL);
+	pthread_cond_init(&m_done_cond, NULL);
+	m_workers.resize(threads-1);
+	for (unsigned int i=0; i<m_workers.size(); i++) {
+		m_workers[i].pool = this;
+		m_workers[i].index = i+1;
+		pthread_create(&m_workers[i].thread, NULL, &ThreadPool::run, &m_workers[i]);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	pthread_mutex_lock(&m_mutex);
+	m_stop = true;
+	pthread_cond_broadcast(&m_work_cond);
+	pthread_mutex_unlock(&m_mutex);
+	for (unsigned int i=0; i<m_workers.size(); i++) pthread_join(m_workers[i].thread, NULL);
+	pthread_cond_destroy(&m_done_cond);
+	pthread_cond_destroy(&m_work_cond);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+int ThreadPool::getProcessorCount() {
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? n : 1;
+}
+
+void ThreadPool::parallelFor(int n, TaskFunction f, void *data) {
+	if (n <= 0) return;
+	if (m_workers.empty() || n == 1) {
+		for (int i=0; i<n; i++) f(data, i, 0);
+		return;
+	}
+	pthread_mutex_lock(&m_mutex);
+	m_function = f;
+	m_data = data;
+	m_next_task = 0;
+	m_task_count = n;
+	m_done_count = 0;
+	m_generation++;
+	pthread_cond_broadcast(&m_work_cond);
+	pthread_mutex_unlock(&m_mutex);
+
+	work(0);
+
+	pthread_mutex_lock(&m_mutex);
+	while (m_done_count < m_task_count) pthread_cond_wait(&m_done_cond, &m_mutex);
+	pthread_mutex_unlock(&m_mutex);
+}
+
+int ThreadPool::work(int thread) {
+	int counter = 0;
+	pthread_mutex_lock(&m_mutex);
+	while (m_next_task < m_task_count) {
+		int task = m_next_task++;
+		TaskFunction f = m_function;
+		void *data = m_data;
+		pthread_mutex_unlock(&m_mutex);
+		f(data, task, thread);
+		counter++;
+		pthread_mutex_lock(&m_mutex);
+		if (++m_done_count == m_task_count) pthread_cond_signal(&m_done_cond);
+	}
+	pthread_mutex_unlock(&m_mutex);
+	return counter;
+}
+
+void *ThreadPool::run(void *worker) {
+	Worker *w = (Worker*)worker;
+	ThreadPool *pool = w->pool;
+	unsigned int generation = 0;
+	pthread_mutex_lock(&pool->m_mutex);
+	while (true) {
+		while (!pool->m_stop && pool->m_generation == generation)
+			pthread_cond_wait(&pool->m_work_cond, &pool->m_mutex);
+		if (pool->m_stop) break;
+		generation = pool->m_generation;
+		pthread_mutex_unlock(&pool->m_mutex);
+		pool->work(w->index);
+		pthread_mutex_lock(&pool->m_mutex);
+	}
+	pthread_mutex_unlock(&pool->m_mutex);
+	return NULL;
+}
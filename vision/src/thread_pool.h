@@ -0,0 +1,67 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __THREAD_POOL_EWEITNAU_H__
+#define __THREAD_POOL_EWEITNAU_H__
+
+#include <vector>
+#include <pthread.h>
+
+/// A fixed set of worker threads for running parallel loops.
+/** The threads are created once in the constructor and wait for work, so
+ * calling parallelFor() in each frame does not create any threads. The
+ * calling thread works on the loop as well and is thread 0, the worker
+ * threads are 1..getThreadCount()-1. Each task is run exactly once, the
+ * tasks are handed out one by one in increasing order, so the tasks should
+ * not be too small.
+ *
+ * Usage example:
+ * \code
+ * void process(void *data, int task, int thread) {
+ *   // work on element 'task' using the workspace of 'thread'
+ * }
+ * ThreadPool pool;
+ * pool.parallelFor(n, &process, &data);
+ * \endcode
+ */
+class ThreadPool {
+	public:
+		/// Function called for each task with the passed data, the task index and the thread index.
+		typedef void (*TaskFunction)(void *data, int task, int thread);
+
+		/// Creates a pool with 'threads' threads including the calling thread.
+		/** If threads is <= 0, one thread per online processor is used. */
+		ThreadPool(int threads=0);
+		~ThreadPool();
+
+		/// Number of threads including the calling thread.
+		int getThreadCount() const { return m_workers.size()+1; }
+
+		/// Calls f(data, i, thread) for i in [0, n) and returns when all calls are done.
+		/** Must not be called from several threads at the same time. */
+		void parallelFor(int n, TaskFunction f, void *data);
+
+		/// Returns the number of online processors.
+		static int getProcessorCount();
+
+	private:
+		struct Worker {
+			ThreadPool *pool;
+			int index;
+			pthread_t thread;
+		};
+
+		static void *run(void *worker);
+		/// Runs tasks until none are left, returns the number of run tasks.
+		int work(int thread);
+
+		std::vector<Worker> m_workers;
+		pthread_mutex_t m_mutex;
+		pthread_cond_t m_work_cond;
+		pthread_cond_t m_done_cond;
+		TaskFunction m_function;
+		void *m_data;
+		int m_next_task, m_task_count, m_done_count;
+		unsigned int m_generation;
+		bool m_stop;
+};
+
+#endif /* __THREAD_POOL_EWEITNAU_H__ */
@@ -0,0 +1,66 @@
+// Copyright 2009 Erik Weitnauer
+#ifndef __VISION_FRAME_EWEITNAU_H__
+#define __VISION_FRAME_EWEITNAU_H__
+
+#include <ICLCore/Img.h>
+#include <ICLUtils/Time.h>
+#include <vector>
+
+/// A region detected in a frame.
+/** In contrast to the icl::Region, which refers to the data of the
+ * RegionDetector and gets invalid with the next detect() call, a blob owns
+ * its data and can be passed to another thread. */
+struct Blob {
+	std::vector<icl::Point> boundary;
+	icl::Point32f cog;
+	int size;
+};
+
+/// Time spent in each step of the TangramVisionPipeline for one frame, in ms.
+/** A step that was skipped, e.g. because the frame did not change, counts
+ * with 0 ms. */
+struct VisionTimings {
+	VisionTimings(): color_distance(0), threshold(0), regions(0), thinning(0),
+		css(0), tracking(0), classification(0), mapping(0) {}
+
+	float color_distance;
+	/// Local threshold, including the reduced images of the image pyramid.
+	float threshold;
+	/// Blob detection and copying the blobs into the frame.
+	float regions;
+	/// Thinning and CSS are summed up over all blobs, see CornerDetectionBatch::getThinningTime().
+	float thinning, css;
+	/// Assigning the observed shapes to the tracked polygons, see PolygonTracker.
+	float tracking;
+	/// Classifying the shapes that were not assigned and mapping the tangram shapes on them.
+	float classification, mapping;
+};
+
+/// All data of one camera frame which is passed along the stages of the vision pipeline.
+/** The images are deep copies, so the frame stays valid when the grabber
+ * or the filters reuse their buffers for the next frame. */
+struct VisionFrame {
+	VisionFrame(): id(-1), blobs_frame_id(-1), processed_fraction(1) {}
+
+	/// Consecutive number of the grabbed frame.
+	int id;
+	/// Time at which grabbing the frame started.
+	icl::Time grab_time;
+	/// Time at which each stage finished processing the frame.
+	std::vector<icl::Time> stage_times;
+
+	icl::Img8u image;
+	icl::Img8u distance_image;
+	icl::Img8u threshold_image;
+	std::vector<Blob> blobs;
+	/// Id of the frame the blobs were detected in.
+	/** Differs from id if the image did not change and the blobs of an
+	 * earlier frame were reused. */
+	int blobs_frame_id;
+	/// Fraction of the image pixels on which the threshold and region detection ran.
+	float processed_fraction;
+	/// Times of the segmentation steps, set by TangramVisionPipeline::segment().
+	VisionTimings timings;
+};
+
+#endif /* __VISION_FRAME_EWEITNAU_H__ */